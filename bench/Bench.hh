@@ -0,0 +1,63 @@
+#ifndef KOUH_BENCH_BENCH_HH_
+#define KOUH_BENCH_BENCH_HH_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace bench
+{
+/** Keeps the compiler from optimizing away a computed value.
+ */
+template <typename T>
+inline void doNotOptimize(T const& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile T sink;
+  sink = value;
+#endif
+}
+
+/** Runs `f` once per element of `inputs` and returns the mean time per call
+ * in nanoseconds.
+ *
+ * The first pass warms up caches and branch predictors and is not timed.
+ */
+template <typename Input, typename F>
+double nsPerCall(std::vector<Input> const& inputs, F&& f)
+{
+  for (auto const& input : inputs)
+    f(input);
+  auto const start = std::chrono::steady_clock::now();
+  for (auto const& input : inputs)
+    f(input);
+  auto const stop = std::chrono::steady_clock::now();
+  std::chrono::duration<double, std::nano> const elapsed = stop - start;
+  return elapsed.count() / static_cast<double>(inputs.size());
+}
+
+/// Returns `count` random integers in [0, max], with a fixed seed.
+inline std::vector<std::uint64_t> randomKeys(std::size_t count,
+                                             std::uint64_t max)
+{
+  std::mt19937_64 rng{42};
+  std::uniform_int_distribution<std::uint64_t> dist{0, max};
+  std::vector<std::uint64_t> ret(count);
+  for (auto& key : ret)
+    key = dist(rng);
+  return ret;
+}
+
+/// Prints one result line, as "name  size  ns/op".
+inline void report(char const* name, std::size_t size, double ns)
+{
+  std::printf("%-32s %10zu %10.2f ns/op\n", name, size, ns);
+}
+}
+
+#endif /* !KOUH_BENCH_BENCH_HH_ */
@@ -0,0 +1,39 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <kouh/FlatMap.hpp>
+
+#include "Bench.hh"
+
+namespace
+{
+using Map = kouh::FlatMap<std::uint64_t, std::uint64_t>;
+
+void run(std::size_t size)
+{
+  // A quarter of the keys are duplicates.
+  std::vector<Map::PairType> pairs;
+  for (auto const key : bench::randomKeys(size, size * 3 / 4))
+    pairs.emplace_back(key, key);
+
+  auto const start = std::chrono::steady_clock::now();
+  Map const fm{std::move(pairs)};
+  auto const stop = std::chrono::steady_clock::now();
+  bench::doNotOptimize(fm.size());
+  std::chrono::duration<double, std::milli> const elapsed = stop - start;
+  std::printf(
+      "%-32s %10zu %10.2f ms\n", "FlatMap build", size, elapsed.count());
+}
+}
+
+int main()
+{
+  std::printf("%u hardware threads\n", std::thread::hardware_concurrency());
+  for (std::size_t size : {100000u, 1000000u, 10000000u})
+    run(size);
+}
@@ -0,0 +1,42 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <kouh/EytzingerFlatMap.hpp>
+#include <kouh/FlatMap.hpp>
+
+#include "Bench.hh"
+
+namespace
+{
+constexpr std::size_t LOOKUPS = 1 << 20;
+
+void run(std::size_t size)
+{
+  kouh::FlatMap<std::uint64_t, std::uint64_t> fm;
+  std::vector<std::pair<std::uint64_t, std::uint64_t>> pairs;
+  for (auto const key : bench::randomKeys(size, ~std::uint64_t{0}))
+    pairs.emplace_back(key, key);
+  fm.insert(pairs.begin(), pairs.end());
+  kouh::EytzingerFlatMap<std::uint64_t, std::uint64_t> const efm{fm};
+
+  // Half of the lookups hit.
+  auto lookups = bench::randomKeys(LOOKUPS, ~std::uint64_t{0});
+  for (std::size_t i = 0; i < lookups.size(); i += 2)
+    lookups[i] = pairs[lookups[i] % pairs.size()].first;
+
+  auto const& cfm = fm;
+  bench::report("FlatMap::find", size, bench::nsPerCall(lookups, [&](auto k) {
+                  bench::doNotOptimize(cfm.find(k));
+                }));
+  bench::report(
+      "EytzingerFlatMap::find", size, bench::nsPerCall(lookups, [&](auto k) {
+        bench::doNotOptimize(efm.find(k));
+      }));
+}
+}
+
+int main()
+{
+  for (std::size_t size : {1000u, 100000u, 1000000u, 10000000u})
+    run(size);
+}
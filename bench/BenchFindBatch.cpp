@@ -0,0 +1,64 @@
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <kouh/FlatMap.hpp>
+
+#include "Bench.hh"
+
+namespace
+{
+constexpr std::size_t LOOKUPS = 1 << 20;
+constexpr std::size_t BATCH_SIZE = 256;
+
+using Map = kouh::FlatMap<std::uint64_t, std::uint64_t>;
+
+void run(std::size_t size)
+{
+  std::vector<Map::PairType> pairs;
+  for (auto const key : bench::randomKeys(size, ~std::uint64_t{0}))
+    pairs.emplace_back(key, key);
+  Map const fm{std::move(pairs)};
+
+  // Lookups are grouped in batches, and half of them hit.
+  auto const keys = bench::randomKeys(LOOKUPS, ~std::uint64_t{0});
+  std::vector<std::vector<std::uint64_t>> batches;
+  for (std::size_t i = 0; i < LOOKUPS; i += BATCH_SIZE)
+  {
+    batches.emplace_back(keys.begin() + static_cast<std::ptrdiff_t>(i),
+                         keys.begin() +
+                             static_cast<std::ptrdiff_t>(i + BATCH_SIZE));
+    for (std::size_t j = 0; j < BATCH_SIZE; j += 2)
+      batches.back()[j] = (fm.begin() + static_cast<std::ptrdiff_t>(
+                                            batches.back()[j] % fm.size()))
+                              ->first;
+  }
+
+  std::vector<Map::const_iterator> out(BATCH_SIZE);
+  auto const perBatch = static_cast<double>(BATCH_SIZE);
+  bench::report("FlatMap::find loop",
+                size,
+                bench::nsPerCall(batches,
+                                 [&](std::vector<std::uint64_t> const& b) {
+                                   for (std::size_t i = 0; i < b.size(); ++i)
+                                     out[i] = fm.find(b[i]);
+                                   bench::doNotOptimize(out.data());
+                                 }) /
+                    perBatch);
+  bench::report("FlatMap::find_batch",
+                size,
+                bench::nsPerCall(batches,
+                                 [&](std::vector<std::uint64_t> const& b) {
+                                   fm.find_batch(
+                                       b.begin(), b.end(), out.data());
+                                   bench::doNotOptimize(out.data());
+                                 }) /
+                    perBatch);
+}
+}
+
+int main()
+{
+  for (std::size_t size : {1000u, 100000u, 1000000u, 10000000u})
+    run(size);
+}
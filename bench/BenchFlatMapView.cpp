@@ -0,0 +1,74 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+#include <kouh/FlatMap.hpp>
+#include <kouh/FlatMapView.hpp>
+#include <kouh/MappedFile.hh>
+
+#include "Bench.hh"
+
+namespace
+{
+constexpr std::size_t LOOKUPS = 1 << 20;
+char const* const PATH = "BenchFlatMapView.bin";
+
+using Map = kouh::FlatMap<std::uint64_t, std::uint64_t>;
+
+/// Returns the time f takes, in milliseconds.
+template <typename F>
+double msOf(F&& f)
+{
+  auto const start = std::chrono::steady_clock::now();
+  f();
+  auto const stop = std::chrono::steady_clock::now();
+  std::chrono::duration<double, std::milli> const elapsed = stop - start;
+  return elapsed.count();
+}
+
+void run(std::size_t size)
+{
+  std::vector<Map::PairType> pairs;
+  for (auto const key : bench::randomKeys(size, ~std::uint64_t{0}))
+    pairs.emplace_back(key, key);
+
+  Map fm;
+  auto const buildMs = msOf([&]() { fm = Map{std::move(pairs)}; });
+  {
+    std::ofstream out{PATH, std::ios::binary};
+    kouh::serialize(fm, out);
+  }
+  kouh::MappedFile file;
+  kouh::FlatMapView<std::uint64_t, std::uint64_t> fmv;
+  auto const openMs = msOf([&]() {
+    file = kouh::MappedFile{PATH};
+    fmv = {file.data(), file.size()};
+  });
+  std::printf("%-32s %10zu %10.3f ms\n", "FlatMap build", size, buildMs);
+  std::printf("%-32s %10zu %10.3f ms\n", "FlatMapView open", size, openMs);
+
+  // Half of the lookups hit.
+  auto keys = bench::randomKeys(LOOKUPS, ~std::uint64_t{0});
+  for (std::size_t i = 0; i < keys.size(); i += 2)
+    keys[i] = (fm.begin() + static_cast<std::ptrdiff_t>(keys[i] % fm.size()))
+                  ->first;
+  bench::report("FlatMap::find", size, bench::nsPerCall(keys, [&](auto key) {
+                  bench::doNotOptimize(fm.find(key));
+                }));
+  bench::report(
+      "FlatMapView::find", size, bench::nsPerCall(keys, [&](auto key) {
+        bench::doNotOptimize(fmv.find(key));
+      }));
+  std::remove(PATH);
+}
+}
+
+int main()
+{
+  for (std::size_t size : {1000u, 1000000u, 10000000u})
+    run(size);
+}
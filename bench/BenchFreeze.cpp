@@ -0,0 +1,73 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <kouh/FlatMap.hpp>
+#include <kouh/FlatUnorderedSet.hpp>
+#include <kouh/PerfectHashMap.hpp>
+#include <kouh/PerfectHashSet.hpp>
+
+#include "Bench.hh"
+
+namespace
+{
+constexpr std::size_t LOOKUPS = 1 << 20;
+/// Bounds the work of the linear FlatUnorderedSet::find on large sets.
+constexpr std::size_t SCAN_BUDGET = std::size_t{1} << 30;
+
+using Map = kouh::FlatMap<std::uint64_t, std::uint64_t>;
+using Set = kouh::FlatUnorderedSet<std::uint64_t>;
+
+/// Returns LOOKUPS keys, half of which are in fm.
+std::vector<std::uint64_t> lookupKeys(Map const& fm)
+{
+  auto keys = bench::randomKeys(LOOKUPS, ~std::uint64_t{0});
+  for (std::size_t i = 0; i < keys.size(); i += 2)
+    keys[i] = (fm.begin() + static_cast<std::ptrdiff_t>(keys[i] % fm.size()))
+                  ->first;
+  return keys;
+}
+
+void run(std::size_t size)
+{
+  std::vector<Map::PairType> pairs;
+  for (auto const key : bench::randomKeys(size, ~std::uint64_t{0}))
+    pairs.emplace_back(key, key);
+  Map const fm{std::move(pairs)};
+  auto const phm = kouh::freeze(fm);
+  auto const keys = lookupKeys(fm);
+
+  bench::report("FlatMap::find", size, bench::nsPerCall(keys, [&](auto key) {
+                  bench::doNotOptimize(fm.find(key));
+                }));
+  bench::report(
+      "PerfectHashMap::find", size, bench::nsPerCall(keys, [&](auto key) {
+        bench::doNotOptimize(phm.find(key));
+      }));
+
+  Set fus;
+  for (auto const& pair : fm)
+    fus.emplace(pair.first);
+  auto const phs = kouh::freeze(fus);
+  std::vector<std::uint64_t> const scanKeys(
+      keys.begin(),
+      keys.begin() + static_cast<std::ptrdiff_t>(
+                         std::min(LOOKUPS, SCAN_BUDGET / fm.size())));
+
+  bench::report(
+      "FlatUnorderedSet::find", size, bench::nsPerCall(scanKeys, [&](auto key) {
+        bench::doNotOptimize(fus.find(key));
+      }));
+  bench::report(
+      "PerfectHashSet::find", size, bench::nsPerCall(keys, [&](auto key) {
+        bench::doNotOptimize(phs.find(key));
+      }));
+}
+}
+
+int main()
+{
+  for (std::size_t size : {10u, 1000u, 1000000u})
+    run(size);
+}
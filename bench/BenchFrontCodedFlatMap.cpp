@@ -0,0 +1,81 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <kouh/FlatMap.hpp>
+#include <kouh/FrontCodedFlatMap.hpp>
+
+#include "Bench.hh"
+
+namespace
+{
+constexpr std::size_t LOOKUPS = 1 << 20;
+
+using Map = kouh::FlatMap<std::string, std::uint32_t>;
+
+/// Returns `count` URL paths, in a few sections of a few hundred pages.
+std::vector<std::string> randomPaths(std::size_t count)
+{
+  static char const* const sections[] = {"/products/", "/users/profile/",
+                                         "/static/assets/images/",
+                                         "/api/v2/orders/"};
+  auto const ids = bench::randomKeys(count, ~std::uint64_t{0});
+  std::vector<std::string> ret;
+  ret.reserve(count);
+  for (auto const id : ids)
+    ret.push_back(sections[id % 4] + std::to_string(id % 1000) + "/item-" +
+                  std::to_string(id >> 32) + ".html");
+  return ret;
+}
+
+/// Bytes used by a FlatMap, including the heap buffers of long keys.
+std::size_t footprint(Map const& fm)
+{
+  auto ret = fm.size() * sizeof(Map::PairType);
+  for (auto const& pair : fm)
+    if (pair.first.capacity() > std::string{}.capacity())
+      ret += pair.first.capacity() + 1;
+  return ret;
+}
+
+void run(std::size_t size)
+{
+  std::vector<Map::PairType> pairs;
+  std::uint32_t value = 0;
+  for (auto const& path : randomPaths(size))
+    pairs.emplace_back(path, value++);
+  Map const fm{std::move(pairs)};
+  kouh::FrontCodedFlatMap<std::uint32_t> const fcm{
+      kouh::sorted_unique, fm.begin(), fm.end()};
+
+  // Half the lookups hit, at random positions.
+  auto keys = randomPaths(LOOKUPS);
+  auto const positions = bench::randomKeys(LOOKUPS, fm.size() - 1);
+  for (std::size_t i = 0; i < keys.size(); i += 2)
+    keys[i] = (fm.begin() + static_cast<std::ptrdiff_t>(positions[i]))->first;
+
+  bench::report(
+      "FlatMap::find", size, bench::nsPerCall(keys, [&](auto const& key) {
+        bench::doNotOptimize(fm.find(key));
+      }));
+  bench::report("FrontCodedFlatMap::contains",
+                size,
+                bench::nsPerCall(keys, [&](auto const& key) {
+                  bench::doNotOptimize(fcm.contains(key));
+                }));
+  std::printf("%-32s %10zu %10zu bytes\n", "FlatMap", size, footprint(fm));
+  std::printf("%-32s %10zu %10zu bytes\n",
+              "FrontCodedFlatMap",
+              size,
+              fcm.keyStorageSize() + fcm.size() * sizeof(std::uint32_t));
+}
+}
+
+int main()
+{
+  for (std::size_t size : {1000u, 100000u, 5000000u})
+    run(size);
+}
@@ -0,0 +1,85 @@
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <kouh/FlatMap.hpp>
+
+#include "Bench.hh"
+
+namespace
+{
+constexpr std::size_t LOOKUPS = 1 << 20;
+
+template <typename Key, typename Search>
+using Map = kouh::FlatMap<Key,
+                          std::uint64_t,
+                          std::less<Key>,
+                          std::allocator<std::pair<Key, std::uint64_t>>,
+                          Search>;
+
+template <typename Search, typename Key>
+void run(char const* name,
+         std::vector<std::pair<Key, std::uint64_t>> const& pairs,
+         std::vector<Key> const& keys)
+{
+  Map<Key, Search> const fm{pairs.begin(), pairs.end()};
+  bench::report(name, fm.size(), bench::nsPerCall(keys, [&](auto const& key) {
+                  bench::doNotOptimize(fm.find(key));
+                }));
+}
+
+void run(std::size_t size)
+{
+  // Uniformly distributed keys, like IDs or timestamps.
+  std::vector<std::pair<std::uint64_t, std::uint64_t>> pairs;
+  for (auto const key : bench::randomKeys(size, ~std::uint64_t{0} >> 1))
+    pairs.emplace_back(key, key);
+
+  // Half of the lookups hit.
+  auto keys = bench::randomKeys(LOOKUPS, ~std::uint64_t{0} >> 1);
+  for (std::size_t i = 0; i < keys.size(); i += 2)
+    keys[i] = pairs[keys[i] % pairs.size()].first;
+
+  run<kouh::BinarySearch>("BinarySearch", pairs, keys);
+  run<kouh::InterpolationSearch>("InterpolationSearch", pairs, keys);
+  run<kouh::LearnedSegmentSearch>("LearnedSegmentSearch", pairs, keys);
+}
+
+/// Returns `count` URLs of a single site, which share a long prefix.
+std::vector<std::string> randomUrls(std::size_t count)
+{
+  std::vector<std::string> ret;
+  ret.reserve(count);
+  for (auto const id : bench::randomKeys(count, ~std::uint64_t{0}))
+    ret.push_back("https://www.example.com/catalog/item-" +
+                  std::to_string(id) + "/details.html");
+  return ret;
+}
+
+void runStrings(std::size_t size)
+{
+  std::vector<std::pair<std::string, std::uint64_t>> pairs;
+  for (auto const& url : randomUrls(size))
+    pairs.emplace_back(url, pairs.size());
+
+  auto keys = randomUrls(LOOKUPS);
+  auto const positions = bench::randomKeys(LOOKUPS, size - 1);
+  for (std::size_t i = 0; i < keys.size(); i += 2)
+    keys[i] = pairs[positions[i]].first;
+
+  run<kouh::BinarySearch>("BinarySearch<string>", pairs, keys);
+  run<kouh::PrefixCacheSearch>("PrefixCacheSearch<string>", pairs, keys);
+}
+}
+
+int main()
+{
+  for (std::size_t size : {1000u, 100000u, 1000000u, 10000000u})
+    run(size);
+  for (std::size_t size : {1000u, 100000u, 1000000u})
+    runStrings(size);
+}
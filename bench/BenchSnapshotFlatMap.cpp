@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <kouh/FlatMap.hpp>
+#include <kouh/SnapshotFlatMap.hpp>
+#include <kouh/Spinlock.hh>
+
+#include "Bench.hh"
+
+namespace
+{
+constexpr std::size_t SIZE = 100000;
+constexpr std::size_t LOOKUPS = 1 << 20;
+
+using Map = kouh::FlatMap<std::uint64_t, std::uint64_t>;
+using SnapshotMap = kouh::SnapshotFlatMap<std::uint64_t, std::uint64_t>;
+
+/** Runs lookup(key) LOOKUPS times on each of threads threads, while another
+ * thread calls update() every millisecond.
+ * Returns the wall time per lookup, in nanoseconds.
+ */
+template <typename Lookup, typename Update>
+double nsPerLookup(std::size_t threads,
+                   std::vector<std::uint64_t> const& keys,
+                   Lookup const& lookup,
+                   Update const& update)
+{
+  std::atomic<bool> done{false};
+  std::thread writer{[&]() {
+    while (!done.load())
+    {
+      update();
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }};
+  std::vector<std::thread> readers;
+  auto const start = std::chrono::steady_clock::now();
+  for (std::size_t t = 0; t < threads; ++t)
+    readers.emplace_back([&]() {
+      auto state = lookup.start();
+      for (std::size_t i = 0; i < LOOKUPS; ++i)
+        bench::doNotOptimize(lookup(state, keys[i % keys.size()]));
+    });
+  for (auto& reader : readers)
+    reader.join();
+  auto const stop = std::chrono::steady_clock::now();
+  done = true;
+  writer.join();
+  std::chrono::duration<double, std::nano> const elapsed = stop - start;
+  return elapsed.count() / static_cast<double>(threads * LOOKUPS);
+}
+
+/// Looks keys up in a FlatMap guarded by a Lock.
+template <typename Lock>
+struct Locked
+{
+  struct State
+  {
+  };
+  State start() const
+  {
+    return {};
+  }
+  std::uint64_t operator()(State, std::uint64_t key) const
+  {
+    std::lock_guard<Lock> guard{this->lock};
+    auto const it = this->map.find(key);
+    return it == this->map.end() ? 0 : it->second;
+  }
+  void update() const
+  {
+    std::lock_guard<Lock> guard{this->lock};
+    this->map[this->map.begin()->first] += 1;
+  }
+
+  Map& map;
+  Lock& lock;
+};
+
+/// Takes a new Snapshot for each lookup.
+struct PerLookupSnapshot
+{
+  struct State
+  {
+  };
+  State start() const
+  {
+    return {};
+  }
+  std::uint64_t operator()(State, std::uint64_t key) const
+  {
+    auto const snapshot = this->map.snapshot();
+    auto const it = snapshot->find(key);
+    return it == snapshot->end() ? 0 : it->second;
+  }
+
+  SnapshotMap& map;
+};
+
+/// Keeps a Reader per thread.
+struct CachedReader
+{
+  using State = SnapshotMap::Reader;
+  State start() const
+  {
+    return State{this->map};
+  }
+  std::uint64_t operator()(State& reader, std::uint64_t key) const
+  {
+    auto const& snapshot = reader.get();
+    auto const it = snapshot->find(key);
+    return it == snapshot->end() ? 0 : it->second;
+  }
+
+  SnapshotMap& map;
+};
+
+void report(char const* name, std::size_t threads, double ns)
+{
+  std::printf("%-32s %3zu threads %10.2f ns/lookup\n", name, threads, ns);
+}
+
+void run(std::size_t threads)
+{
+  std::vector<Map::PairType> pairs;
+  for (auto const key : bench::randomKeys(SIZE, ~std::uint64_t{0}))
+    pairs.emplace_back(key, key);
+  Map fm{std::move(pairs)};
+  std::vector<std::uint64_t> keys;
+  for (auto const& pair : fm)
+    keys.push_back(pair.first);
+  std::shuffle(keys.begin(), keys.end(), std::mt19937_64{42});
+
+  std::mutex mutex;
+  Locked<std::mutex> const withMutex{fm, mutex};
+  report("FlatMap + std::mutex",
+         threads,
+         nsPerLookup(threads, keys, withMutex, [&]() { withMutex.update(); }));
+  kouh::Spinlock spinlock;
+  Locked<kouh::Spinlock> const withSpinlock{fm, spinlock};
+  report("FlatMap + Spinlock",
+         threads,
+         nsPerLookup(
+             threads, keys, withSpinlock, [&]() { withSpinlock.update(); }));
+
+  SnapshotMap sfm{fm};
+  auto const update = [&]() {
+    sfm.update([](Map& map) { map[map.begin()->first] += 1; });
+  };
+  report("SnapshotFlatMap::snapshot",
+         threads,
+         nsPerLookup(threads, keys, PerLookupSnapshot{sfm}, update));
+  report("SnapshotFlatMap::Reader",
+         threads,
+         nsPerLookup(threads, keys, CachedReader{sfm}, update));
+}
+}
+
+int main()
+{
+  auto const hardware = std::max(1u, std::thread::hardware_concurrency());
+  std::printf("hardware threads: %u\n", hardware);
+  run(1);
+  if (hardware > 1)
+    run(hardware);
+}
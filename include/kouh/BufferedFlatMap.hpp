@@ -0,0 +1,346 @@
+#ifndef KOUH_BUFFEREDFLATMAP_HPP_
+#define KOUH_BUFFEREDFLATMAP_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+#include <kouh/FlatMap.hpp>
+
+namespace kouh
+{
+/** A FlatMap optimized for bursts of insertions.
+ *
+ * Inserting in the middle of a FlatMap shifts every element after the
+ * insertion point. The BufferedFlatMap sends new elements to a small sorted
+ * buffer instead, and merges this buffer into the main FlatMap in one linear
+ * pass once it is full, or when flush() is called.
+ *
+ * A key is either in the main FlatMap or in the buffer, never in both.
+ * Lookups check both. Mutable iteration needs the buffer to be merged and
+ * flushes it first, which invalidates every iterator. Const iteration walks
+ * both parts side by side instead, and leaves the BufferedFlatMap untouched,
+ * so that it can be read concurrently like a FlatMap.
+ *
+ * Because of that, the insertion functions do not return iterators, and
+ * lookups return pointers to the values.
+ */
+template <typename KeyType,
+          typename ValueType,
+          typename Comp = std::less<KeyType>>
+class BufferedFlatMap
+{
+public:
+  using MapType = FlatMap<KeyType, ValueType, Comp>;
+  using PairType = typename MapType::PairType;
+  using value_type = typename MapType::value_type;
+  using size_type = typename MapType::size_type;
+  using iterator = typename MapType::iterator;
+  class const_iterator;
+
+  /// Number of buffered elements at which the buffer is merged.
+  static constexpr size_type DEFAULT_BUFFER_CAPACITY = 512;
+
+  BufferedFlatMap() noexcept : bufferCapacity{DEFAULT_BUFFER_CAPACITY}
+  {
+  }
+  explicit BufferedFlatMap(size_type capacity) noexcept
+    : bufferCapacity{capacity}
+  {
+  }
+  BufferedFlatMap(BufferedFlatMap const& b) = default;
+  BufferedFlatMap(BufferedFlatMap&& b) noexcept = default;
+  ~BufferedFlatMap() noexcept = default;
+
+  BufferedFlatMap& operator=(BufferedFlatMap const& rhs) = default;
+  BufferedFlatMap& operator=(BufferedFlatMap&& rhs) noexcept = default;
+
+  /// Returns the number of elements, buffered or not.
+  size_type size() const noexcept
+  {
+    return this->main.size() + this->buffer.size();
+  }
+  /// Returns true if there are no elements in the BufferedFlatMap.
+  bool empty() const noexcept
+  {
+    return this->main.empty() && this->buffer.empty();
+  }
+  /// Returns the number of elements waiting to be merged.
+  size_type buffered() const noexcept
+  {
+    return this->buffer.size();
+  }
+
+  // Iterators
+  // Mutable iterators flush the buffer first. Const iterators do not.
+  iterator begin()
+  {
+    this->flush();
+    return this->main.begin();
+  }
+  iterator end()
+  {
+    this->flush();
+    return this->main.end();
+  }
+  const_iterator begin() const noexcept
+  {
+    return {this, this->main.cbegin(), this->buffer.cbegin()};
+  }
+  const_iterator end() const noexcept
+  {
+    return {this, this->main.cend(), this->buffer.cend()};
+  }
+  const_iterator cbegin() const noexcept
+  {
+    return this->begin();
+  }
+  const_iterator cend() const noexcept
+  {
+    return this->end();
+  }
+
+  // Lookup
+  /// Returns a pointer to the value for key, nullptr if there is none.
+  ValueType* findValue(KeyType const& key) noexcept
+  {
+    auto it = this->buffer.find(key);
+    if (it != this->buffer.end())
+      return &it->second;
+    it = this->main.find(key);
+    if (it != this->main.end())
+      return &it->second;
+    return nullptr;
+  }
+  /// Returns a pointer to the value for key, nullptr if there is none.
+  ValueType const* findValue(KeyType const& key) const noexcept
+  {
+    auto it = this->buffer.find(key);
+    if (it != this->buffer.cend())
+      return &it->second;
+    it = this->main.find(key);
+    if (it != this->main.cend())
+      return &it->second;
+    return nullptr;
+  }
+  size_type count(KeyType const& key) const noexcept
+  {
+    return this->findValue(key) != nullptr ? 1 : 0;
+  }
+  bool contains(KeyType const& key) const noexcept
+  {
+    return this->findValue(key) != nullptr;
+  }
+  ValueType& operator[](KeyType const& key)
+  {
+    auto const value = this->findValue(key);
+    if (value != nullptr)
+      return *value;
+    return this->insertBuffered(key);
+  }
+  ValueType& at(KeyType const& key)
+  {
+    auto const value = this->findValue(key);
+    if (value != nullptr)
+      return *value;
+    throw std::out_of_range("Invalid access at BufferedFlatMap::at");
+  }
+  ValueType const& at(KeyType const& key) const
+  {
+    auto const value = this->findValue(key);
+    if (value != nullptr)
+      return *value;
+    throw std::out_of_range("Invalid access at BufferedFlatMap::at const");
+  }
+
+  // Modifiers
+  /** In-place insertion.
+   * Returns true if the element was inserted, false if the key was already
+   * present.
+   */
+  template <typename... Args>
+  bool emplace(Args&&... args)
+  {
+    PairType pair{std::forward<Args>(args)...};
+    if (this->contains(pair.first))
+      return false;
+    this->insertBuffered(std::move(pair.first), std::move(pair.second));
+    return true;
+  }
+  /** In-place insertion of a value for key.
+   * Nothing is constructed if the key is already present.
+   */
+  template <typename... Args>
+  bool try_emplace(KeyType const& key, Args&&... args)
+  {
+    if (this->contains(key))
+      return false;
+    this->insertBuffered(key, std::forward<Args>(args)...);
+    return true;
+  }
+  /// Removes element whose key is key. Returns the number of removed elements.
+  size_type erase(KeyType const& key) noexcept
+  {
+    auto const it = this->buffer.find(key);
+    if (it != this->buffer.end())
+    {
+      this->buffer.erase(it);
+      return 1;
+    }
+    auto const mainIt = this->main.find(key);
+    if (mainIt == this->main.end())
+      return 0;
+    this->main.erase(mainIt);
+    return 1;
+  }
+  /// Removes every element.
+  void clear() noexcept
+  {
+    this->main.clear();
+    this->buffer.clear();
+  }
+  /** Merges the buffer into the main FlatMap.
+   *
+   * Runs in O(n + b), n being the size of the main FlatMap and b the size of
+   * the buffer. If memory runs out, the elements stay in the buffer.
+   */
+  void flush()
+  {
+    if (this->buffer.empty())
+      return;
+    auto elements = this->main.extract();
+    auto const sortedCount = elements.size();
+    auto const needed = sortedCount + this->buffer.size();
+    if (elements.capacity() < needed)
+    {
+      // Only this can throw: nothing has moved yet.
+      try
+      {
+        elements.reserve(std::max(needed, 2 * elements.capacity()));
+      }
+      catch (...)
+      {
+        this->main.replace(std::move(elements));
+        throw;
+      }
+    }
+    std::move(this->buffer.begin(),
+              this->buffer.end(),
+              std::back_inserter(elements));
+    auto const comp = this->main.key_comp();
+    std::inplace_merge(elements.begin(),
+                       elements.begin() +
+                           static_cast<std::ptrdiff_t>(sortedCount),
+                       elements.end(),
+                       [&comp](PairType const& a, PairType const& b) {
+                         return comp(a.first, b.first);
+                       });
+    this->main.replace(std::move(elements));
+    // The buffer keeps its storage, so that it is not reallocated.
+    this->buffer.clear();
+  }
+  /// Changes the number of buffered elements at which they are merged.
+  void setBufferCapacity(size_type capacity)
+  {
+    this->bufferCapacity = capacity;
+    if (this->buffer.size() > capacity)
+      this->flush();
+  }
+
+private:
+  /** Inserts a key known to be absent into the buffer.
+   * Makes room first if the buffer is full, so that the returned reference
+   * stays valid.
+   */
+  template <typename K, typename... Args>
+  ValueType& insertBuffered(K&& key, Args&&... args)
+  {
+    if (this->buffer.size() >= this->bufferCapacity)
+      this->flush();
+    auto const ret = this->buffer.try_emplace(std::forward<K>(key),
+                                              std::forward<Args>(args)...);
+    return ret.first->second;
+  }
+
+  MapType main;
+  MapType buffer;
+  size_type bufferCapacity;
+};
+
+/** Walks the main FlatMap and the buffer side by side, in key order.
+ * Invalidated by any modification of the BufferedFlatMap.
+ */
+template <typename KeyType, typename ValueType, typename Comp>
+class BufferedFlatMap<KeyType, ValueType, Comp>::const_iterator
+{
+  using PartIterator = typename MapType::const_iterator;
+
+public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = PairType;
+  using difference_type = std::ptrdiff_t;
+  using pointer = PairType const*;
+  using reference = PairType const&;
+
+  const_iterator() noexcept = default;
+  const_iterator(BufferedFlatMap const* m,
+                 PartIterator mainPos,
+                 PartIterator bufferPos) noexcept
+    : map{m}, mainIt{mainPos}, bufferIt{bufferPos}
+  {
+  }
+
+  reference operator*() const
+  {
+    return this->inMain() ? *this->mainIt : *this->bufferIt;
+  }
+  pointer operator->() const
+  {
+    return &**this;
+  }
+  const_iterator& operator++()
+  {
+    if (this->inMain())
+      ++this->mainIt;
+    else
+      ++this->bufferIt;
+    return *this;
+  }
+  const_iterator operator++(int)
+  {
+    auto const ret = *this;
+    ++*this;
+    return ret;
+  }
+
+  bool operator==(const_iterator const& rhs) const noexcept
+  {
+    return this->mainIt == rhs.mainIt && this->bufferIt == rhs.bufferIt;
+  }
+  bool operator!=(const_iterator const& rhs) const noexcept
+  {
+    return !(*this == rhs);
+  }
+
+private:
+  /// Whether the current element is the one from the main FlatMap.
+  bool inMain() const
+  {
+    auto const& main = this->map->main;
+    auto const& buffer = this->map->buffer;
+    if (this->bufferIt == buffer.cend())
+      return true;
+    return this->mainIt != main.cend() &&
+           main.key_comp()(this->mainIt->first, this->bufferIt->first);
+  }
+
+  BufferedFlatMap const* map = nullptr;
+  PartIterator mainIt{};
+  PartIterator bufferIt{};
+};
+}
+
+#endif /* !KOUH_BUFFEREDFLATMAP_HPP_ */
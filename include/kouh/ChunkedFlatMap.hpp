@@ -0,0 +1,563 @@
+#ifndef KOUH_CHUNKEDFLATMAP_HPP_
+#define KOUH_CHUNKEDFLATMAP_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <kouh/FlatMap.hpp>
+#include <kouh/LowerBound.hpp>
+
+namespace kouh
+{
+/** A FlatMap split in fixed-size chunks, for large element counts.
+ *
+ * Elements are stored in sorted leaves of at most LeafCapacity elements,
+ * each one a std::vector that is allocated once with its full capacity. A
+ * separate vector holds the first key of every leaf, which is searched to
+ * find the leaf holding a key. This makes a two-level B+ tree.
+ *
+ * Inserting into a full leaf splits it in two, and a leaf that becomes small
+ * enough after an erasure is merged with its neighbour. An insertion or
+ * erasure thus moves at most LeafCapacity elements, plus the leaf headers
+ * (three pointers each) after the modified leaf. The container never moves
+ * all of its elements at once.
+ *
+ * Keys must be copyable, since the first key of each leaf is duplicated in
+ * the index.
+ *
+ * The container otherwise behaves as a standard std::map. Insertions and
+ * erasures invalidate all iterators.
+ */
+template <typename KeyType,
+          typename ValueType,
+          typename Comp = std::less<KeyType>,
+          std::size_t LeafCapacity = 256>
+class ChunkedFlatMap
+{
+  static_assert(LeafCapacity >= 4, "Leaves must hold at least 4 elements");
+
+public:
+  using PairType = std::pair<KeyType, ValueType>;
+  using value_type = PairType;
+  using LeafType = std::vector<PairType>;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+
+  /// Bidirectional iterator over the leaves, in key order.
+  template <bool IsConst>
+  class Iterator
+  {
+  public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = PairType;
+    using difference_type = std::ptrdiff_t;
+    using reference =
+        typename std::conditional<IsConst, PairType const&, PairType&>::type;
+    using pointer =
+        typename std::conditional<IsConst, PairType const*, PairType*>::type;
+    using LeafPointer =
+        typename std::conditional<IsConst, LeafType const*, LeafType*>::type;
+
+    Iterator() noexcept : leaf{nullptr}, idx{0}
+    {
+    }
+    Iterator(LeafPointer l, size_type i) noexcept : leaf{l}, idx{i}
+    {
+    }
+    /// Allows conversion from iterator to const_iterator.
+    template <bool WasConst,
+              typename = typename std::enable_if<IsConst && !WasConst>::type>
+    Iterator(Iterator<WasConst> const& b) noexcept
+      : leaf{b.leafPtr()}, idx{b.index()}
+    {
+    }
+
+    reference operator*() const noexcept
+    {
+      return (*this->leaf)[this->idx];
+    }
+    pointer operator->() const noexcept
+    {
+      return &**this;
+    }
+
+    Iterator& operator++() noexcept
+    {
+      if (++this->idx == this->leaf->size())
+      {
+        ++this->leaf;
+        this->idx = 0;
+      }
+      return *this;
+    }
+    Iterator operator++(int) noexcept
+    {
+      auto ret = *this;
+      ++*this;
+      return ret;
+    }
+    Iterator& operator--() noexcept
+    {
+      if (this->idx == 0)
+      {
+        --this->leaf;
+        this->idx = this->leaf->size();
+      }
+      --this->idx;
+      return *this;
+    }
+    Iterator operator--(int) noexcept
+    {
+      auto ret = *this;
+      --*this;
+      return ret;
+    }
+
+    bool operator==(Iterator const& b) const noexcept
+    {
+      return this->leaf == b.leaf && this->idx == b.idx;
+    }
+    bool operator!=(Iterator const& b) const noexcept
+    {
+      return !(*this == b);
+    }
+
+    LeafPointer leafPtr() const noexcept
+    {
+      return this->leaf;
+    }
+    size_type index() const noexcept
+    {
+      return this->idx;
+    }
+
+  private:
+    LeafPointer leaf;
+    size_type idx;
+  };
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  ChunkedFlatMap() noexcept = default;
+  ChunkedFlatMap(std::initializer_list<PairType> l)
+  {
+    this->assign(FlatMap<KeyType, ValueType, Comp>{l}.extract());
+  }
+  /// Builds from a FlatMap, filling leaves to three quarters.
+  explicit ChunkedFlatMap(FlatMap<KeyType, ValueType, Comp>&& fm)
+  {
+    this->assign(fm.extract());
+  }
+  /// Copies leaf by leaf, so that every leaf has its full capacity.
+  ChunkedFlatMap(ChunkedFlatMap const& b)
+    : firstKeys(b.firstKeys), count_(b.count_), comp(b.comp)
+  {
+    this->leaves.reserve(b.leaves.size());
+    for (auto const& leaf : b.leaves)
+    {
+      this->leaves.emplace_back();
+      this->leaves.back().reserve(LeafCapacity);
+      this->leaves.back().insert(
+          this->leaves.back().end(), leaf.begin(), leaf.end());
+    }
+  }
+  /// Leaves b empty.
+  ChunkedFlatMap(ChunkedFlatMap&& b) noexcept
+    : leaves(std::move(b.leaves)),
+      firstKeys(std::move(b.firstKeys)),
+      count_(std::exchange(b.count_, 0)),
+      comp(std::move(b.comp))
+  {
+  }
+  ~ChunkedFlatMap() noexcept = default;
+
+  ChunkedFlatMap& operator=(ChunkedFlatMap const& rhs)
+  {
+    if (this != &rhs)
+      *this = ChunkedFlatMap{rhs};
+    return *this;
+  }
+  /// Leaves rhs empty.
+  ChunkedFlatMap& operator=(ChunkedFlatMap&& rhs) noexcept
+  {
+    if (this != &rhs)
+    {
+      this->leaves = std::move(rhs.leaves);
+      this->firstKeys = std::move(rhs.firstKeys);
+      this->count_ = std::exchange(rhs.count_, 0);
+      this->comp = std::move(rhs.comp);
+      rhs.leaves.clear();
+      rhs.firstKeys.clear();
+    }
+    return *this;
+  }
+
+  /// Returns the number of elements in the ChunkedFlatMap.
+  size_type size() const noexcept
+  {
+    return this->count_;
+  }
+  /// Returns true if there are no elements in the ChunkedFlatMap.
+  bool empty() const noexcept
+  {
+    return this->count_ == 0;
+  }
+  /** Returns the number of leaves.
+   * Every leaf but a lone one holds more than a quarter of LeafCapacity.
+   */
+  size_type leafCount() const noexcept
+  {
+    return this->leaves.size();
+  }
+
+  iterator begin() noexcept
+  {
+    return iterator{this->leaves.data(), 0};
+  }
+  iterator end() noexcept
+  {
+    return iterator{this->leaves.data() + this->leaves.size(), 0};
+  }
+  const_iterator begin() const noexcept
+  {
+    return const_iterator{this->leaves.data(), 0};
+  }
+  const_iterator end() const noexcept
+  {
+    return const_iterator{this->leaves.data() + this->leaves.size(), 0};
+  }
+  const_iterator cbegin() const noexcept
+  {
+    return this->begin();
+  }
+  const_iterator cend() const noexcept
+  {
+    return this->end();
+  }
+
+  /** Find the position of the value for given key.
+   * Returns end() if no match was found.
+   */
+  iterator find(KeyType const& key) noexcept
+  {
+    auto const pos = this->locate(key);
+    if (!this->isAt(pos, key))
+      return this->end();
+    return this->makeIterator(pos);
+  }
+  /** Find the position of the value for given key.
+   * Returns cend() if no match was found.
+   */
+  const_iterator find(KeyType const& key) const noexcept
+  {
+    auto const pos = this->locate(key);
+    if (!this->isAt(pos, key))
+      return this->end();
+    return this->makeIterator(pos);
+  }
+  size_type count(KeyType const& key) const noexcept
+  {
+    return this->isAt(this->locate(key), key) ? 1 : 0;
+  }
+  bool contains(KeyType const& key) const noexcept
+  {
+    return this->isAt(this->locate(key), key);
+  }
+  ValueType& operator[](KeyType const& key)
+  {
+    return this->try_emplace(key).first->second;
+  }
+  ValueType& at(KeyType const& key)
+  {
+    auto const it = this->find(key);
+    if (it != this->end())
+      return it->second;
+    throw std::out_of_range("Invalid access at ChunkedFlatMap::at");
+  }
+  ValueType const& at(KeyType const& key) const
+  {
+    auto const it = this->find(key);
+    if (it != this->end())
+      return it->second;
+    throw std::out_of_range("Invalid access at ChunkedFlatMap::at const");
+  }
+
+  /// In-place insertion.
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args)
+  {
+    PairType pair{std::forward<Args>(args)...};
+    auto const pos = this->locate(pair.first);
+    if (this->isAt(pos, pair.first))
+      return {this->makeIterator(pos), false};
+    return {this->insertAt(pos, std::move(pair)), true};
+  }
+  /** In-place insertion of a value for key.
+   * Nothing is constructed if the key is already present.
+   */
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(KeyType const& key, Args&&... args)
+  {
+    auto const pos = this->locate(key);
+    if (this->isAt(pos, key))
+      return {this->makeIterator(pos), false};
+    auto const it = this->insertAt(pos,
+                                   std::piecewise_construct,
+                                   std::forward_as_tuple(key),
+                                   std::forward_as_tuple(
+                                       std::forward<Args>(args)...));
+    return {it, true};
+  }
+  /// Removes element whose key is key. Returns the number of removed elements.
+  size_type erase(KeyType const& key)
+  {
+    auto const pos = this->locate(key);
+    if (!this->isAt(pos, key))
+      return 0;
+    this->eraseAt(pos);
+    return 1;
+  }
+  /// Removes the element at it. Returns an iterator to the next element.
+  iterator erase(const_iterator it)
+  {
+    auto const leaf =
+        static_cast<size_type>(it.leafPtr() - this->leaves.data());
+    return this->eraseAt(Position{leaf, it.index()});
+  }
+  /// Removes every element.
+  void clear() noexcept
+  {
+    this->leaves.clear();
+    this->firstKeys.clear();
+    this->count_ = 0;
+  }
+
+private:
+  /// Number of elements leaves are filled with on bulk construction.
+  static constexpr size_type BULK_FILL = LeafCapacity - LeafCapacity / 4;
+  /// Leaves at or below this size after an erasure merge or borrow elements.
+  static constexpr size_type MERGE_THRESHOLD = LeafCapacity / 4;
+
+  /// Position of an element: leaf index, then index in the leaf.
+  struct Position
+  {
+    size_type leaf;
+    size_type idx;
+  };
+
+  /// Lays out sorted unique pairs in leaves.
+  void assign(LeafType&& sorted)
+  {
+    this->clear();
+    this->count_ = sorted.size();
+    for (size_type i = 0; i < sorted.size(); i += BULK_FILL)
+    {
+      auto const last = std::min(sorted.size(), i + BULK_FILL);
+      this->leaves.emplace_back();
+      auto& leaf = this->leaves.back();
+      leaf.reserve(LeafCapacity);
+      auto const first = sorted.begin() + static_cast<difference_type>(i);
+      leaf.insert(leaf.end(),
+                  std::make_move_iterator(first),
+                  std::make_move_iterator(
+                      sorted.begin() + static_cast<difference_type>(last)));
+      this->firstKeys.push_back(leaf.front().first);
+    }
+  }
+
+  /** Returns where key is, or where it should be inserted.
+   *
+   * Finds the last leaf whose first key is not greater than key (or the
+   * first leaf), then the lower bound of key within that leaf.
+   */
+  Position locate(KeyType const& key) const noexcept
+  {
+    if (this->leaves.empty())
+      return Position{0, 0};
+    auto const first = this->firstKeys.data();
+    auto const last = first + this->firstKeys.size();
+    auto it = std::upper_bound(first, last, key, this->comp);
+    auto const leafIdx =
+        static_cast<size_type>(it == first ? 0 : it - first - 1);
+    auto const& leaf = this->leaves[leafIdx];
+    auto const inLeaf = detail::lowerBound(
+        leaf.begin(), leaf.end(), key, this->comp, detail::PairFirst{});
+    return Position{leafIdx, static_cast<size_type>(inLeaf - leaf.begin())};
+  }
+  bool isAt(Position pos, KeyType const& key) const noexcept
+  {
+    if (pos.leaf == this->leaves.size())
+      return false;
+    auto const& leaf = this->leaves[pos.leaf];
+    return pos.idx != leaf.size() && !this->comp(key, leaf[pos.idx].first);
+  }
+  /// Turns a position into an iterator, mapping past-the-leaf to the next.
+  iterator makeIterator(Position pos) noexcept
+  {
+    return iteratorAt<iterator>(this->leaves.data(), this->leaves.size(), pos);
+  }
+  const_iterator makeIterator(Position pos) const noexcept
+  {
+    return iteratorAt<const_iterator>(
+        this->leaves.data(), this->leaves.size(), pos);
+  }
+  template <typename It, typename LeafPointer>
+  static It iteratorAt(LeafPointer leaves,
+                       size_type leafCount,
+                       Position pos) noexcept
+  {
+    auto const leaf = leaves + pos.leaf;
+    if (pos.leaf != leafCount && pos.idx == leaf->size())
+      return It{leaf + 1, 0};
+    return It{leaf, pos.idx};
+  }
+
+  template <typename... Args>
+  iterator insertAt(Position pos, Args&&... args)
+  {
+    if (this->leaves.empty())
+    {
+      this->leaves.emplace_back();
+      this->leaves.back().reserve(LeafCapacity);
+      this->leaves.back().emplace_back(std::forward<Args>(args)...);
+      this->firstKeys.push_back(this->leaves.back().front().first);
+      ++this->count_;
+      return this->begin();
+    }
+    if (this->leaves[pos.leaf].size() == LeafCapacity)
+    {
+      this->split(pos.leaf);
+      // The element may now belong to the new, upper, leaf.
+      auto const lowerSize = this->leaves[pos.leaf].size();
+      if (pos.idx > lowerSize)
+      {
+        ++pos.leaf;
+        pos.idx -= lowerSize;
+      }
+    }
+    auto& leaf = this->leaves[pos.leaf];
+    leaf.emplace(leaf.begin() + static_cast<difference_type>(pos.idx),
+                 std::forward<Args>(args)...);
+    if (pos.idx == 0)
+      this->firstKeys[pos.leaf] = leaf.front().first;
+    ++this->count_;
+    return iterator{this->leaves.data() + pos.leaf, pos.idx};
+  }
+  /// Moves the upper half of a full leaf to a new leaf right after it.
+  void split(size_type leafIdx)
+  {
+    LeafType upper;
+    upper.reserve(LeafCapacity);
+    auto& lower = this->leaves[leafIdx];
+    auto const middle =
+        lower.begin() + static_cast<difference_type>(LeafCapacity / 2);
+    upper.insert(upper.end(),
+                 std::make_move_iterator(middle),
+                 std::make_move_iterator(lower.end()));
+    lower.erase(middle, lower.end());
+    auto const offset = static_cast<difference_type>(leafIdx + 1);
+    this->firstKeys.insert(this->firstKeys.begin() + offset,
+                           upper.front().first);
+    this->leaves.insert(this->leaves.begin() + offset, std::move(upper));
+  }
+  iterator eraseAt(Position pos)
+  {
+    auto& leaf = this->leaves[pos.leaf];
+    leaf.erase(leaf.begin() + static_cast<difference_type>(pos.idx));
+    --this->count_;
+    if (leaf.empty())
+    {
+      this->removeLeaf(pos.leaf);
+      return iterator{this->leaves.data() + pos.leaf, 0};
+    }
+    if (pos.idx == 0)
+      this->firstKeys[pos.leaf] = leaf.front().first;
+    if (leaf.size() <= MERGE_THRESHOLD)
+    {
+      // Merge with a neighbour if the result still has room for insertions.
+      // Otherwise, like in a B+ tree, the fuller neighbour gives elements
+      // away, so that no leaf but a lone one stays underfull.
+      if (pos.leaf != 0)
+      {
+        auto const previousSize = this->leaves[pos.leaf - 1].size();
+        if (previousSize + leaf.size() <= BULK_FILL)
+        {
+          this->mergeWithNext(pos.leaf - 1);
+          return this->makeIterator(
+              Position{pos.leaf - 1, previousSize + pos.idx});
+        }
+        this->balance(pos.leaf - 1);
+        auto const moved = previousSize - this->leaves[pos.leaf - 1].size();
+        return this->makeIterator(Position{pos.leaf, pos.idx + moved});
+      }
+      if (pos.leaf + 1 != this->leaves.size())
+      {
+        if (this->leaves[pos.leaf + 1].size() + leaf.size() <= BULK_FILL)
+          this->mergeWithNext(pos.leaf);
+        else
+          this->balance(pos.leaf);
+      }
+    }
+    return this->makeIterator(pos);
+  }
+  /// Evens out the sizes of the leaf at leafIdx and of the next one.
+  void balance(size_type leafIdx)
+  {
+    auto& left = this->leaves[leafIdx];
+    auto& right = this->leaves[leafIdx + 1];
+    auto const target =
+        static_cast<difference_type>((left.size() + right.size()) / 2);
+    if (left.size() > right.size())
+    {
+      auto const middle = left.begin() + target;
+      right.insert(right.begin(),
+                   std::make_move_iterator(middle),
+                   std::make_move_iterator(left.end()));
+      left.erase(middle, left.end());
+    }
+    else
+    {
+      auto const middle =
+          right.begin() + (target - static_cast<difference_type>(left.size()));
+      left.insert(left.end(),
+                  std::make_move_iterator(right.begin()),
+                  std::make_move_iterator(middle));
+      right.erase(right.begin(), middle);
+    }
+    this->firstKeys[leafIdx + 1] = right.front().first;
+  }
+  /// Moves the elements of the leaf after leafIdx into it.
+  void mergeWithNext(size_type leafIdx)
+  {
+    auto& leaf = this->leaves[leafIdx];
+    auto& next = this->leaves[leafIdx + 1];
+    leaf.insert(leaf.end(),
+                std::make_move_iterator(next.begin()),
+                std::make_move_iterator(next.end()));
+    this->removeLeaf(leafIdx + 1);
+  }
+  void removeLeaf(size_type leafIdx) noexcept
+  {
+    auto const offset = static_cast<difference_type>(leafIdx);
+    this->leaves.erase(this->leaves.begin() + offset);
+    this->firstKeys.erase(this->firstKeys.begin() + offset);
+  }
+
+  std::vector<LeafType> leaves;
+  std::vector<KeyType> firstKeys;
+  size_type count_ = 0;
+  Comp comp;
+};
+}
+
+#endif /* !KOUH_CHUNKEDFLATMAP_HPP_ */
@@ -0,0 +1,333 @@
+#ifndef KOUH_EYTZINGERFLATMAP_HPP_
+#define KOUH_EYTZINGERFLATMAP_HPP_
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <kouh/FlatMap.hpp>
+#include <kouh/Prefetch.hh>
+
+namespace kouh
+{
+/** A frozen associative container laid out for fast lookups.
+ *
+ * The EytzingerFlatMap is built once from a FlatMap and is read-only
+ * afterwards. Keys are stored in Eytzinger (breadth-first) order: the root
+ * of the implicit binary search tree comes first, then its two children, and
+ * so on. The first levels of every search thus share the same few cache
+ * lines, and the descendants a few levels down are contiguous, which lets us
+ * prefetch them while the current comparison is still in flight.
+ *
+ * Keys and values are stored in separate std::vectors so that searching
+ * never pulls values into the cache.
+ *
+ * Iteration is still performed in key order, by walking the implicit tree.
+ */
+template <typename KeyType,
+          typename ValueType,
+          typename Comp = std::less<KeyType>>
+class EytzingerFlatMap
+{
+public:
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using value_type = std::pair<KeyType, ValueType>;
+  using FlatMapType = FlatMap<KeyType, ValueType, Comp>;
+
+  /** In-order iterator over the implicit tree.
+   *
+   * Nodes are numbered from 1 (the root), the children of node k being 2k
+   * and 2k + 1. Node 0 stands for end().
+   *
+   * Keys and values live apart, so the reference is a pair of references
+   * made on the fly, and the iterator is only advertised as an input
+   * iterator. It can still be decremented.
+   */
+  class const_iterator
+  {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = EytzingerFlatMap::value_type;
+    using difference_type = std::ptrdiff_t;
+    using reference = std::pair<KeyType const&, ValueType const&>;
+
+    /// Gives operator-> something to point to.
+    class pointer
+    {
+    public:
+      explicit pointer(reference r) noexcept : ref{r}
+      {
+      }
+      reference const* operator->() const noexcept
+      {
+        return &this->ref;
+      }
+
+    private:
+      reference ref;
+    };
+
+    const_iterator() noexcept : map{nullptr}, node{0}
+    {
+    }
+    const_iterator(EytzingerFlatMap const* m, size_type n) noexcept
+      : map{m}, node{n}
+    {
+    }
+
+    reference operator*() const noexcept
+    {
+      return reference{this->map->keys[this->node - 1],
+                       this->map->values[this->node - 1]};
+    }
+    pointer operator->() const noexcept
+    {
+      return pointer{**this};
+    }
+
+    const_iterator& operator++() noexcept
+    {
+      this->node = EytzingerFlatMap::nextNode(this->node, this->map->size());
+      return *this;
+    }
+    const_iterator operator++(int) noexcept
+    {
+      auto ret = *this;
+      ++*this;
+      return ret;
+    }
+    const_iterator& operator--() noexcept
+    {
+      this->node = EytzingerFlatMap::prevNode(this->node, this->map->size());
+      return *this;
+    }
+    const_iterator operator--(int) noexcept
+    {
+      auto ret = *this;
+      --*this;
+      return ret;
+    }
+
+    bool operator==(const_iterator const& b) const noexcept
+    {
+      return this->node == b.node;
+    }
+    bool operator!=(const_iterator const& b) const noexcept
+    {
+      return this->node != b.node;
+    }
+
+  private:
+    EytzingerFlatMap const* map;
+    size_type node;
+  };
+  using iterator = const_iterator;
+
+  EytzingerFlatMap() noexcept = default;
+  explicit EytzingerFlatMap(FlatMapType const& fm)
+  {
+    this->build(typename FlatMapType::ContainerType{fm.begin(), fm.end()});
+  }
+  explicit EytzingerFlatMap(FlatMapType&& fm)
+  {
+    this->build(fm.extract());
+  }
+  EytzingerFlatMap(EytzingerFlatMap const& b) = default;
+  EytzingerFlatMap(EytzingerFlatMap&& b) noexcept = default;
+  ~EytzingerFlatMap() noexcept = default;
+
+  EytzingerFlatMap& operator=(EytzingerFlatMap const& rhs) = default;
+  EytzingerFlatMap& operator=(EytzingerFlatMap&& rhs) noexcept = default;
+
+  /// Returns the number of elements in the EytzingerFlatMap.
+  size_type size() const noexcept
+  {
+    return this->keys.size();
+  }
+  /// Returns true if there are no elements in the EytzingerFlatMap.
+  bool empty() const noexcept
+  {
+    return this->keys.empty();
+  }
+
+  /// Returns an iterator to the element with the smallest key.
+  const_iterator begin() const noexcept
+  {
+    return const_iterator{this, firstNode(this->size())};
+  }
+  /// Returns an iterator past the element with the largest key.
+  const_iterator end() const noexcept
+  {
+    return const_iterator{this, 0};
+  }
+  const_iterator cbegin() const noexcept
+  {
+    return this->begin();
+  }
+  const_iterator cend() const noexcept
+  {
+    return this->end();
+  }
+
+  /** Find the position of the value for given key.
+   * Returns end() if no match was found.
+   */
+  const_iterator find(KeyType const& key) const noexcept
+  {
+    return const_iterator{this, this->findNode(key)};
+  }
+  size_type count(KeyType const& key) const noexcept
+  {
+    return this->findNode(key) != 0 ? 1 : 0;
+  }
+  bool contains(KeyType const& key) const noexcept
+  {
+    return this->findNode(key) != 0;
+  }
+  ValueType const& at(KeyType const& key) const
+  {
+    auto const node = this->findNode(key);
+    if (node != 0)
+      return this->values[node - 1];
+    throw std::out_of_range("Invalid access at EytzingerFlatMap::at const");
+  }
+
+  /// Converts back to a regular, mutable, FlatMap.
+  FlatMapType toFlatMap() const
+  {
+    typename FlatMapType::ContainerType pairs;
+    pairs.reserve(this->size());
+    for (auto const& pair : *this)
+      pairs.emplace_back(pair.first, pair.second);
+    return FlatMapType{sorted_unique, std::move(pairs)};
+  }
+
+private:
+  /// How many nodes of a level fit in a cache line.
+  static constexpr size_type PREFETCH_STRIDE =
+      sizeof(KeyType) >= detail::CACHE_LINE_SIZE ?
+          1 :
+          detail::CACHE_LINE_SIZE / sizeof(KeyType);
+
+  /** Lays out sorted pairs in Eytzinger order.
+   *
+   * The in-order traversal of the implicit tree visits nodes in sorted
+   * order, which gives the rank of every node. Elements are then appended
+   * in node order so that neither keys nor values need to be default
+   * constructible.
+   */
+  void build(typename FlatMapType::ContainerType&& sorted)
+  {
+    auto const n = sorted.size();
+    std::vector<size_type> ranks(n);
+    auto node = firstNode(n);
+    for (size_type rank = 0; rank < n; ++rank)
+    {
+      ranks[node - 1] = rank;
+      node = nextNode(node, n);
+    }
+    this->keys.reserve(n);
+    this->values.reserve(n);
+    for (auto const rank : ranks)
+    {
+      this->keys.push_back(std::move(sorted[rank].first));
+      this->values.push_back(std::move(sorted[rank].second));
+    }
+  }
+
+  /** Returns the node of the first key not less than key, 0 if none.
+   *
+   * Goes down the tree until falling off a leaf, without any branch on the
+   * comparison result. The bits of the final node record the path taken:
+   * every 1 is a right turn. The answer is the last node where we turned
+   * left, found by stripping the trailing right turns.
+   */
+  size_type lowerBound(KeyType const& key) const noexcept
+  {
+    auto const n = this->size();
+    auto const data = this->keys.data();
+    size_type node = 1;
+    while (node <= n)
+    {
+      detail::prefetch(data, node * PREFETCH_STRIDE - 1);
+      node = 2 * node + (this->comp(data[node - 1], key) ? 1 : 0);
+    }
+#if defined(__GNUC__) || defined(__clang__)
+    node >>= __builtin_ctzll(~static_cast<unsigned long long>(node)) + 1;
+#else
+    while (node & 1)
+      node >>= 1;
+    node >>= 1;
+#endif
+    return node;
+  }
+  /// Returns the node holding key, 0 if none.
+  size_type findNode(KeyType const& key) const noexcept
+  {
+    auto const node = this->lowerBound(key);
+    if (node != 0 && !this->comp(key, this->keys[node - 1]))
+      return node;
+    return 0;
+  }
+  /// Leftmost node of a tree of n nodes.
+  static size_type firstNode(size_type n) noexcept
+  {
+    size_type node = n != 0 ? 1 : 0;
+    while (node != 0 && 2 * node <= n)
+      node *= 2;
+    return node;
+  }
+  /// Rightmost node of a tree of n nodes.
+  static size_type lastNode(size_type n) noexcept
+  {
+    size_type node = n != 0 ? 1 : 0;
+    while (node != 0 && 2 * node + 1 <= n)
+      node = 2 * node + 1;
+    return node;
+  }
+  /// In-order successor of node in a tree of n nodes, 0 past the last one.
+  static size_type nextNode(size_type node, size_type n) noexcept
+  {
+    if (2 * node + 1 <= n)
+    {
+      // Leftmost node of the right subtree.
+      node = 2 * node + 1;
+      while (2 * node <= n)
+        node *= 2;
+      return node;
+    }
+    // Climb until we come from a left child.
+    while (node & 1)
+      node >>= 1;
+    return node >> 1;
+  }
+  /// In-order predecessor of node in a tree of n nodes. 0 maps to the last.
+  static size_type prevNode(size_type node, size_type n) noexcept
+  {
+    if (node == 0)
+      return lastNode(n);
+    if (2 * node <= n)
+    {
+      // Rightmost node of the left subtree.
+      node = 2 * node;
+      while (2 * node + 1 <= n)
+        node = 2 * node + 1;
+      return node;
+    }
+    // Climb until we come from a right child.
+    while (node != 1 && (node & 1) == 0)
+      node >>= 1;
+    return node >> 1;
+  }
+
+  std::vector<KeyType> keys;
+  std::vector<ValueType> values;
+  Comp comp;
+};
+}
+
+#endif /* !KOUH_EYTZINGERFLATMAP_HPP_ */
@@ -4,8 +4,15 @@
 #include <cstddef>
 #include <functional>
 #include <initializer_list>
+#include <memory>
+#include <tuple>
+#include <type_traits>
 #include <vector>
 
+#include <kouh/Pmr.hh>
+#include <kouh/SearchPolicy.hpp>
+#include <kouh/SortedVector.hpp>
+
 namespace kouh
 {
 /** A flattened associative container.
@@ -18,17 +25,31 @@ namespace kouh
  * Keys and values are not in separated containers.
  *
  * The container otherwise behaves as a standard std::map.
+ *
+ * Memory is obtained from Alloc. The kouh::pmr::FlatMap alias uses a
+ * std::pmr::polymorphic_allocator, so that short-lived maps can be allocated
+ * from an arena and released all at once.
+ *
+ * Lookups go through Search, see SearchPolicy.hpp. The default is a binary
+ * search. InterpolationSearch and LearnedSegmentSearch find arithmetic keys
+ * that are close to uniformly distributed in fewer probes, and
+ * PrefixCacheSearch finds long string keys with fewer cache misses.
+ * find_batch keeps its own interleaved binary search.
  */
 template <typename KeyType,
           typename ValueType,
-          typename Comp = std::less<KeyType>>
+          typename Comp = std::less<KeyType>,
+          typename Alloc = std::allocator<std::pair<KeyType, ValueType>>,
+          typename Search = BinarySearch>
 class FlatMap
 {
 public:
   using PairType = std::pair<KeyType, ValueType>;
   using value_type = PairType;
-  using ContainerType = std::vector<PairType>;
+  using allocator_type = Alloc;
+  using ContainerType = std::vector<PairType, Alloc>;
   using size_type = typename ContainerType::size_type;
+  using difference_type = typename ContainerType::difference_type;
   using iterator = typename ContainerType::iterator;
   using const_iterator = typename ContainerType::const_iterator;
   using reverse_iterator = typename ContainerType::reverse_iterator;
@@ -36,7 +57,26 @@ public:
 
 public:
   FlatMap() noexcept;
+  /// Construct an empty FlatMap whose storage comes from alloc.
+  explicit FlatMap(Alloc const& alloc) noexcept;
   FlatMap(std::initializer_list<PairType> l);
+  FlatMap(std::initializer_list<PairType> l, Alloc const& alloc);
+  /** Construct from an unsorted range of pairs.
+   * The range is copied once, then sorted and deduplicated in a single pass.
+   */
+  template <typename InputIt>
+  FlatMap(InputIt first,
+          InputIt last,
+          DuplicatePolicy policy = DuplicatePolicy::KeepFirst);
+  /** Construct by adopting an unsorted vector of pairs.
+   * No element is copied. The vector is sorted and deduplicated in place.
+   */
+  explicit FlatMap(ContainerType&& c,
+                   DuplicatePolicy policy = DuplicatePolicy::KeepFirst);
+  /** Construct by adopting a vector that is already sorted and unique.
+   * Runs in constant time.
+   */
+  FlatMap(sorted_unique_t, ContainerType&& c, Comp const& cmp = Comp{});
 
   /// Returns the number of elements in the FlatMap.
   size_type size() const noexcept;
@@ -57,6 +97,14 @@ public:
   /// Returns a const_iterator past the last element in the FlatMap.
   const_iterator cend() const noexcept;
 
+  // Observers
+  /// Returns the comparator used to order keys.
+  Comp key_comp() const;
+  /// Returns the allocator the elements are stored with.
+  Alloc get_allocator() const noexcept;
+  /// Returns the search policy, with what it learnt of the keys.
+  Search const& searchPolicy() const noexcept;
+
   // Lookup
   /** Find the position of the value for given key.
    * Returns end() if no match was found.
@@ -66,28 +114,312 @@ public:
    * Returns cend() if no match was found.
    */
   const_iterator find(KeyType const& key) const noexcept;
+  /// Returns 1 if key is in the FlatMap, 0 otherwise.
+  size_type count(KeyType const& key) const noexcept;
+  /// Returns true if key is in the FlatMap, false otherwise.
+  bool contains(KeyType const& key) const noexcept;
+  /** Returns the value for given key, inserting a value-initialized one if
+   * the key is not present.
+   */
   ValueType& operator[](KeyType const& key);
+  /// Same as above, but moves the key in if it has to be inserted.
+  ValueType& operator[](KeyType&& key);
   ValueType& at(KeyType const& key);
   ValueType const& at(KeyType const& key) const;
 
+  // Ordered lookup
+  /// Returns an iterator to the first element whose key is not less than key.
+  iterator lower_bound(KeyType const& key) noexcept;
+  const_iterator lower_bound(KeyType const& key) const noexcept;
+  /// Returns an iterator to the first element whose key is greater than key.
+  iterator upper_bound(KeyType const& key) noexcept;
+  const_iterator upper_bound(KeyType const& key) const noexcept;
+  /// Returns the range of elements whose key is equivalent to key.
+  std::pair<iterator, iterator> equal_range(KeyType const& key) noexcept;
+  std::pair<const_iterator, const_iterator> equal_range(
+      KeyType const& key) const noexcept;
+
+  // Batch lookup
+  // Independent searches are advanced in lockstep, in groups, prefetching
+  // the next probe of every search. The memory latency of one search is thus
+  // hidden behind the comparisons of the others.
+  // Keys are taken from [first, last), which must yield KeyType lvalues.
+  /** Writes to out, for each key, the same const_iterator find would return.
+   * Returns out past the last written element.
+   */
+  template <typename KeyIt, typename OutIt>
+  OutIt find_batch(KeyIt first, KeyIt last, OutIt out) const;
+  /** Writes to out, for each key, whether it is in the FlatMap.
+   * Returns out past the last written element.
+   */
+  template <typename KeyIt, typename OutIt>
+  OutIt contains_batch(KeyIt first, KeyIt last, OutIt out) const;
+
+  // Heterogeneous lookup
+  // These overloads take any type that Comp can compare to KeyType, so that
+  // no KeyType needs to be built. They are only available when Comp declares
+  // `is_transparent`, such as std::less<>.
+  template <typename K,
+            typename = typename detail::EnableIfTransparent<Comp, K>::type>
+  iterator find(K const& key) noexcept;
+  template <typename K,
+            typename = typename detail::EnableIfTransparent<Comp, K>::type>
+  const_iterator find(K const& key) const noexcept;
+  template <typename K,
+            typename = typename detail::EnableIfTransparent<Comp, K>::type>
+  size_type count(K const& key) const noexcept;
+  template <typename K,
+            typename = typename detail::EnableIfTransparent<Comp, K>::type>
+  bool contains(K const& key) const noexcept;
+  template <typename K,
+            typename = typename detail::EnableIfTransparent<Comp, K>::type>
+  iterator lower_bound(K const& key) noexcept;
+  template <typename K,
+            typename = typename detail::EnableIfTransparent<Comp, K>::type>
+  const_iterator lower_bound(K const& key) const noexcept;
+  template <typename K,
+            typename = typename detail::EnableIfTransparent<Comp, K>::type>
+  iterator upper_bound(K const& key) noexcept;
+  template <typename K,
+            typename = typename detail::EnableIfTransparent<Comp, K>::type>
+  const_iterator upper_bound(K const& key) const noexcept;
+  template <typename K,
+            typename = typename detail::EnableIfTransparent<Comp, K>::type>
+  std::pair<iterator, iterator> equal_range(K const& key) noexcept;
+  template <typename K,
+            typename = typename detail::EnableIfTransparent<Comp, K>::type>
+  std::pair<const_iterator, const_iterator> equal_range(K const& key) const
+      noexcept;
+
   // Modifiers
   /// Removes element whose key is key. Does nothing if key is not found.
   iterator erase(KeyType const& key) noexcept;
   iterator erase(iterator it) noexcept;
+  /** Removes the elements in [first, last).
+   * The following elements are moved once, whatever the size of the range.
+   */
+  iterator erase(const_iterator first, const_iterator last) noexcept;
+  /** Removes every element whose key is less than key.
+   * Returns the number of removed elements.
+   */
+  size_type erase_before(KeyType const& key) noexcept;
+  /** Keeps only the elements for which pred(element) is true.
+   * Elements are compacted in a single pass and stay sorted.
+   * Returns the number of removed elements.
+   */
+  template <typename Pred>
+  size_type retain(Pred pred);
   /// Removes every element.
   void clear() noexcept;
-  /// In-place insertion.
+  /** Moves the underlying vector out of the FlatMap.
+   * The FlatMap is left empty.
+   */
+  ContainerType extract() noexcept;
+  /** Replaces the underlying vector with one that is already sorted and
+   * unique. Runs in constant time, unless the allocators differ and do not
+   * propagate, in which case the elements are moved one by one.
+   */
+  void replace(ContainerType&& c) noexcept(
+      std::is_nothrow_move_assignable<ContainerType>::value);
+  /** In-place insertion.
+   * Inserting keys in increasing order skips the search and amounts to a
+   * push_back.
+   */
   template <typename... Args>
   std::pair<iterator, bool> emplace(Args&&... args);
+  /** In-place insertion, next to hint.
+   * If the element belongs right before hint, it is inserted there without
+   * searching. Otherwise, this behaves like emplace.
+   * Returns an iterator to the inserted element, or to the element that
+   * prevented insertion.
+   */
+  template <typename... Args>
+  iterator emplace_hint(const_iterator hint, Args&&... args);
+  /** In-place insertion of a value for key.
+   * Unlike emplace, nothing is constructed if the key is already present:
+   * args are left untouched.
+   */
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(KeyType const& key, Args&&... args);
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(KeyType&& key, Args&&... args);
+  /** Inserts obj for key, or assigns it to the existing value.
+   * The second member of the returned pair is true if insertion took place.
+   */
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(KeyType const& key, M&& obj);
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(KeyType&& key, M&& obj);
+  /** Bulk insertion of an unsorted range.
+   * Elements are appended, sorted once and merged with the existing ones.
+   * With DuplicatePolicy::KeepFirst, keys already in the FlatMap are left
+   * untouched. With DuplicatePolicy::KeepLast, they are overwritten.
+   */
+  template <typename InputIt>
+  void insert(InputIt first,
+              InputIt last,
+              DuplicatePolicy policy = DuplicatePolicy::KeepFirst);
+  /** Merges other into this FlatMap, in a single linear pass.
+   * policy tells which element to keep when both have the same key.
+   * other is left empty, unless it is this FlatMap, which is left as is.
+   */
+  void merge(FlatMap&& other,
+             DuplicatePolicy policy = DuplicatePolicy::KeepFirst);
+  /// Same as above, but copies the elements out of other.
+  void merge(FlatMap const& other,
+             DuplicatePolicy policy = DuplicatePolicy::KeepFirst);
+  /** Merges other into this FlatMap, in a single linear pass.
+   * When both have the same key, `resolve(key, mine, theirs)` is called and
+   * is expected to update `mine`. `theirs` may be moved from.
+   * other is left empty, unless it is this FlatMap, which is left as is.
+   */
+  template <typename Resolve>
+  void merge(FlatMap&& other, Resolve resolve);
+  /// Same as above, but `theirs` is a const reference into other.
+  template <typename Resolve>
+  void merge(FlatMap const& other, Resolve resolve);
 
 private:
-  iterator lowerBound(KeyType const& key) noexcept;
-  const_iterator lowerBound(KeyType const& key) const noexcept;
-  bool isKeyEqual(KeyType const& a, KeyType const& b) const noexcept;
+  /** Restores the invariants after elements were appended.
+   * The first `sortedCount` elements must already be sorted and unique.
+   */
+  void sortAndDedup(size_type sortedCount, DuplicatePolicy policy);
+  /// Lets the search policy learn the keys, after a linear time operation.
+  void train() noexcept;
+  /// Tells the search policy an element was inserted at pos.
+  void notifyInserted(const_iterator pos) noexcept;
+  /// Tells the search policy an element was erased from before pos.
+  void notifyErased(const_iterator pos) noexcept;
+  /** Shared implementation of merge.
+   * Move is either std::move-like or a copy, depending on whether other is
+   * an rvalue.
+   */
+  template <typename Other, typename Move, typename Resolve>
+  void mergeImpl(Other& other, Move move, Resolve resolve);
+  /// Shared implementation of try_emplace and operator[].
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> tryEmplace(K&& key, Args&&... args);
+  /// Shared implementation of insert_or_assign.
+  template <typename K, typename M>
+  std::pair<iterator, bool> insertOrAssign(K&& key, M&& obj);
+  /// Whether the elements are sorted and unique. Used for debug assertions.
+  bool isSortedUnique() const noexcept;
+  template <typename K>
+  iterator lowerBound(K const& key) noexcept;
+  template <typename K>
+  const_iterator lowerBound(K const& key) const noexcept;
+  /// Where an element with given key belongs.
+  template <typename K>
+  iterator insertionPoint(K const& key) noexcept;
+  /// Same as insertionPoint, but tries hint before anything else.
+  template <typename K>
+  iterator hintedInsertionPoint(const_iterator hint, K const& key) noexcept;
+  template <typename K>
+  iterator upperBound(K const& key) noexcept;
+  template <typename K>
+  const_iterator upperBound(K const& key) const noexcept;
+  template <typename K>
+  bool isKeyEqual(K const& a, KeyType const& b) const noexcept;
+  /** Shared implementation of the batch lookups.
+   * Calls `onFound(it)` for each key, with the iterator find would return.
+   */
+  template <typename KeyIt, typename OnFound>
+  void findBatch(KeyIt first, KeyIt last, OnFound onFound) const;
 
   ContainerType container;
   Comp comp;
+  Search search;
 };
+
+// Set operations
+// All of them run in a single linear pass over both FlatMaps and allocate
+// the result once, with the allocator of a.
+
+/// Returns the elements of a and b. a wins when both have the same key.
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+FlatMap<KeyType, ValueType, Comp, Alloc, Search> setUnion(
+    FlatMap<KeyType, ValueType, Comp, Alloc, Search> const& a,
+    FlatMap<KeyType, ValueType, Comp, Alloc, Search> const& b);
+/** Returns the elements of a and b.
+ * When both have the same key, the value is `resolve(key, valueA, valueB)`.
+ */
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search,
+          typename Resolve>
+FlatMap<KeyType, ValueType, Comp, Alloc, Search> setUnion(
+    FlatMap<KeyType, ValueType, Comp, Alloc, Search> const& a,
+    FlatMap<KeyType, ValueType, Comp, Alloc, Search> const& b,
+    Resolve resolve);
+/// Returns the elements of a whose key is also in b.
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+FlatMap<KeyType, ValueType, Comp, Alloc, Search> setIntersection(
+    FlatMap<KeyType, ValueType, Comp, Alloc, Search> const& a,
+    FlatMap<KeyType, ValueType, Comp, Alloc, Search> const& b);
+/** Returns the keys both in a and b.
+ * The value is `resolve(key, valueA, valueB)`.
+ */
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search,
+          typename Resolve>
+FlatMap<KeyType, ValueType, Comp, Alloc, Search> setIntersection(
+    FlatMap<KeyType, ValueType, Comp, Alloc, Search> const& a,
+    FlatMap<KeyType, ValueType, Comp, Alloc, Search> const& b,
+    Resolve resolve);
+/// Returns the elements of a whose key is not in b.
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search,
+          typename OtherValueType,
+          typename OtherAlloc,
+          typename OtherSearch>
+FlatMap<KeyType, ValueType, Comp, Alloc, Search> setDifference(
+    FlatMap<KeyType, ValueType, Comp, Alloc, Search> const& a,
+    FlatMap<KeyType, OtherValueType, Comp, OtherAlloc, OtherSearch> const& b);
+
+/** Removes the elements for which pred(element) is true, in a single pass.
+ * Returns the number of removed elements.
+ */
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search,
+          typename Pred>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::size_type erase_if(
+    FlatMap<KeyType, ValueType, Comp, Alloc, Search>& fm, Pred pred);
+
+#ifdef KOUH_HAS_PMR
+namespace pmr
+{
+/// A FlatMap whose storage comes from a std::pmr::memory_resource.
+template <typename KeyType,
+          typename ValueType,
+          typename Comp = std::less<KeyType>,
+          typename Search = BinarySearch>
+using FlatMap = kouh::FlatMap<
+    KeyType,
+    ValueType,
+    Comp,
+    std::pmr::polymorphic_allocator<std::pair<KeyType, ValueType>>,
+    Search>;
+}
+#endif
 }
 
 #include <kouh/FlatMapDetails.hpp>
@@ -6,84 +6,264 @@
 #endif
 
 #include <algorithm>
+#include <cassert>
+#include <memory>
 #include <stdexcept>
 
+#include <kouh/LowerBound.hpp>
+#include <kouh/Prefetch.hh>
+#include <kouh/SortedVector.hpp>
+
 namespace kouh
 {
-template <typename KeyType, typename ValueType, typename Comp>
-FlatMap<KeyType, ValueType, Comp>::FlatMap() noexcept
+namespace detail
+{
+/** Walks two ranges sorted on `first` in lockstep.
+ *
+ * Calls onlyA or onlyB for elements whose key is only in one range, and
+ * both for elements whose key is in the two ranges.
+ */
+template <typename ItA,
+          typename ItB,
+          typename Comp,
+          typename OnlyA,
+          typename OnlyB,
+          typename Both>
+void combineSorted(ItA a,
+                   ItA lastA,
+                   ItB b,
+                   ItB lastB,
+                   Comp const& comp,
+                   OnlyA onlyA,
+                   OnlyB onlyB,
+                   Both both)
+{
+  while (a != lastA && b != lastB)
+  {
+    if (comp(a->first, b->first))
+      onlyA(*a++);
+    else if (comp(b->first, a->first))
+      onlyB(*b++);
+    else
+      both(*a++, *b++);
+  }
+  for (; a != lastA; ++a)
+    onlyA(*a);
+  for (; b != lastB; ++b)
+    onlyB(*b);
+}
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::FlatMap() noexcept
+{
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::FlatMap(
+    Alloc const& alloc) noexcept
+  : container(alloc)
 {
 }
 
-template <typename KeyType, typename ValueType, typename Comp>
-FlatMap<KeyType, ValueType, Comp>::FlatMap(std::initializer_list<PairType> l)
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::FlatMap(
+    std::initializer_list<PairType> l)
   : container(l)
 {
-  std::sort(container.begin(),
-            container.end(),
-            [this](PairType const& pair1, PairType const& pair2) {
-              return this->comp(pair1.first, pair2.first);
-            });
+  this->sortAndDedup(0, DuplicatePolicy::KeepFirst);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::FlatMap(
+    std::initializer_list<PairType> l, Alloc const& alloc)
+  : container(l, alloc)
+{
+  this->sortAndDedup(0, DuplicatePolicy::KeepFirst);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename InputIt>
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::FlatMap(
+    InputIt first, InputIt last, DuplicatePolicy policy)
+  : container(first, last)
+{
+  this->sortAndDedup(0, policy);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::FlatMap(
+    ContainerType&& c, DuplicatePolicy policy)
+  : container(std::move(c))
+{
+  this->sortAndDedup(0, policy);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::FlatMap(sorted_unique_t,
+                                                          ContainerType&& c,
+                                                          Comp const& cmp)
+  : container(std::move(c)), comp(cmp)
+{
+  assert(this->isSortedUnique());
+  this->train();
 }
 
-template <typename KeyType, typename ValueType, typename Comp>
-typename FlatMap<KeyType, ValueType, Comp>::size_type
-FlatMap<KeyType, ValueType, Comp>::size() const noexcept
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::size_type
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::size() const noexcept
 {
   return this->container.size();
 }
 
-template <typename KeyType, typename ValueType, typename Comp>
-bool FlatMap<KeyType, ValueType, Comp>::empty() const noexcept
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+bool FlatMap<KeyType, ValueType, Comp, Alloc, Search>::empty() const noexcept
 {
   return this->container.empty();
 }
 
-template <typename KeyType, typename ValueType, typename Comp>
-typename FlatMap<KeyType, ValueType, Comp>::iterator
-FlatMap<KeyType, ValueType, Comp>::begin() noexcept
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::iterator
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::begin() noexcept
 {
   return this->container.begin();
 }
 
-template <typename KeyType, typename ValueType, typename Comp>
-typename FlatMap<KeyType, ValueType, Comp>::iterator
-FlatMap<KeyType, ValueType, Comp>::end() noexcept
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::iterator
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::end() noexcept
 {
   return this->container.end();
 }
 
-template <typename KeyType, typename ValueType, typename Comp>
-typename FlatMap<KeyType, ValueType, Comp>::const_iterator
-FlatMap<KeyType, ValueType, Comp>::begin() const noexcept
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::const_iterator
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::begin() const noexcept
 {
   return this->container.begin();
 }
 
-template <typename KeyType, typename ValueType, typename Comp>
-typename FlatMap<KeyType, ValueType, Comp>::const_iterator
-FlatMap<KeyType, ValueType, Comp>::end() const noexcept
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::const_iterator
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::end() const noexcept
 {
   return this->container.end();
 }
 
-template <typename KeyType, typename ValueType, typename Comp>
-typename FlatMap<KeyType, ValueType, Comp>::const_iterator
-FlatMap<KeyType, ValueType, Comp>::cbegin() const noexcept
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::const_iterator
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::cbegin() const noexcept
 {
   return this->container.begin();
 }
 
-template <typename KeyType, typename ValueType, typename Comp>
-typename FlatMap<KeyType, ValueType, Comp>::const_iterator
-FlatMap<KeyType, ValueType, Comp>::cend() const noexcept
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::const_iterator
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::cend() const noexcept
 {
   return this->container.end();
 }
 
-template <typename KeyType, typename ValueType, typename Comp>
-typename FlatMap<KeyType, ValueType, Comp>::iterator
-FlatMap<KeyType, ValueType, Comp>::find(KeyType const& key) noexcept
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+Comp FlatMap<KeyType, ValueType, Comp, Alloc, Search>::key_comp() const
+{
+  return this->comp;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+Alloc FlatMap<KeyType, ValueType, Comp, Alloc, Search>::get_allocator() const
+    noexcept
+{
+  return this->container.get_allocator();
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+Search const&
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::searchPolicy() const noexcept
+{
+  return this->search;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::iterator
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::find(
+    KeyType const& key) noexcept
 {
   auto it = this->lowerBound(key);
   if (it != this->container.end() && this->isKeyEqual(key, it->first))
@@ -91,9 +271,14 @@ FlatMap<KeyType, ValueType, Comp>::find(KeyType const& key) noexcept
   return this->end();
 }
 
-template <typename KeyType, typename ValueType, typename Comp>
-typename FlatMap<KeyType, ValueType, Comp>::const_iterator
-FlatMap<KeyType, ValueType, Comp>::find(KeyType const& key) const noexcept
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::const_iterator
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::find(
+    KeyType const& key) const noexcept
 {
   auto it = this->lowerBound(key);
   if (it != this->container.end() && this->isKeyEqual(key, it->first))
@@ -101,17 +286,58 @@ FlatMap<KeyType, ValueType, Comp>::find(KeyType const& key) const noexcept
   return this->end();
 }
 
-template <typename KeyType, typename ValueType, typename Comp>
-ValueType& FlatMap<KeyType, ValueType, Comp>::operator[](KeyType const& key)
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::size_type
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::count(
+    KeyType const& key) const noexcept
 {
-  auto it = this->lowerBound(key);
-  if (it != this->container.end() && this->isKeyEqual(key, it->first))
-    return it->second;
-  return this->container.emplace(it, key, ValueType{})->second;
+  return this->find(key) != this->end() ? 1 : 0;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+bool FlatMap<KeyType, ValueType, Comp, Alloc, Search>::contains(
+    KeyType const& key) const noexcept
+{
+  return this->find(key) != this->end();
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+ValueType& FlatMap<KeyType, ValueType, Comp, Alloc, Search>::operator[](
+    KeyType const& key)
+{
+  return this->tryEmplace(key).first->second;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+ValueType& FlatMap<KeyType, ValueType, Comp, Alloc, Search>::operator[](
+    KeyType&& key)
+{
+  return this->tryEmplace(std::move(key)).first->second;
 }
 
-template <typename KeyType, typename ValueType, typename Comp>
-ValueType& FlatMap<KeyType, ValueType, Comp>::at(KeyType const& key)
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+ValueType& FlatMap<KeyType, ValueType, Comp, Alloc, Search>::at(
+    KeyType const& key)
 {
   auto it = this->lowerBound(key);
   if (it != this->container.end() && this->isKeyEqual(key, it->first))
@@ -119,8 +345,13 @@ ValueType& FlatMap<KeyType, ValueType, Comp>::at(KeyType const& key)
   throw std::out_of_range("Invalid access at FlatMap::at");
 }
 
-template <typename KeyType, typename ValueType, typename Comp>
-ValueType const& FlatMap<KeyType, ValueType, Comp>::at(KeyType const& key) const
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+ValueType const& FlatMap<KeyType, ValueType, Comp, Alloc, Search>::at(
+    KeyType const& key) const
 {
   auto it = this->lowerBound(key);
   if (it != this->container.end() && this->isKeyEqual(key, it->first))
@@ -128,73 +359,985 @@ ValueType const& FlatMap<KeyType, ValueType, Comp>::at(KeyType const& key) const
   throw std::out_of_range("Invalid access at FlatMap::at const");
 }
 
-template <typename KeyType, typename ValueType, typename Comp>
-typename FlatMap<KeyType, ValueType, Comp>::iterator
-FlatMap<KeyType, ValueType, Comp>::erase(KeyType const& key) noexcept
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::iterator
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::lower_bound(
+    KeyType const& key) noexcept
+{
+  return this->lowerBound(key);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::const_iterator
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::lower_bound(
+    KeyType const& key) const noexcept
+{
+  return this->lowerBound(key);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::iterator
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::upper_bound(
+    KeyType const& key) noexcept
+{
+  return this->upperBound(key);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::const_iterator
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::upper_bound(
+    KeyType const& key) const noexcept
+{
+  return this->upperBound(key);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+std::pair<typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::iterator,
+          typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::iterator>
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::equal_range(
+    KeyType const& key) noexcept
+{
+  auto const first = this->lowerBound(key);
+  if (first != this->container.end() && this->isKeyEqual(key, first->first))
+    return {first, first + 1};
+  return {first, first};
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+std::pair<
+    typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::const_iterator,
+    typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::const_iterator>
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::equal_range(
+    KeyType const& key) const noexcept
+{
+  auto const first = this->lowerBound(key);
+  if (first != this->container.end() && this->isKeyEqual(key, first->first))
+    return {first, first + 1};
+  return {first, first};
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename K, typename>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::iterator
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::find(K const& key) noexcept
+{
+  auto it = this->lowerBound(key);
+  if (it != this->container.end() && this->isKeyEqual(key, it->first))
+    return it;
+  return this->end();
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename K, typename>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::const_iterator
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::find(
+    K const& key) const noexcept
+{
+  auto it = this->lowerBound(key);
+  if (it != this->container.end() && this->isKeyEqual(key, it->first))
+    return it;
+  return this->end();
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename K, typename>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::size_type
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::count(
+    K const& key) const noexcept
+{
+  return this->find(key) != this->end() ? 1 : 0;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename K, typename>
+bool FlatMap<KeyType, ValueType, Comp, Alloc, Search>::contains(
+    K const& key) const noexcept
+{
+  return this->find(key) != this->end();
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename K, typename>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::iterator
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::lower_bound(
+    K const& key) noexcept
+{
+  return this->lowerBound(key);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename K, typename>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::const_iterator
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::lower_bound(
+    K const& key) const noexcept
+{
+  return this->lowerBound(key);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename K, typename>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::iterator
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::upper_bound(
+    K const& key) noexcept
+{
+  return this->upperBound(key);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename K, typename>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::const_iterator
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::upper_bound(
+    K const& key) const noexcept
+{
+  return this->upperBound(key);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename K, typename>
+std::pair<typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::iterator,
+          typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::iterator>
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::equal_range(
+    K const& key) noexcept
+{
+  auto const first = this->lowerBound(key);
+  if (first != this->container.end() && this->isKeyEqual(key, first->first))
+    return {first, first + 1};
+  return {first, first};
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename K, typename>
+std::pair<
+    typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::const_iterator,
+    typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::const_iterator>
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::equal_range(
+    K const& key) const noexcept
+{
+  auto const first = this->lowerBound(key);
+  if (first != this->container.end() && this->isKeyEqual(key, first->first))
+    return {first, first + 1};
+  return {first, first};
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename KeyIt, typename OutIt>
+OutIt FlatMap<KeyType, ValueType, Comp, Alloc, Search>::find_batch(
+    KeyIt first, KeyIt last, OutIt out) const
+{
+  this->findBatch(first, last, [&](const_iterator it) { *out++ = it; });
+  return out;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename KeyIt, typename OutIt>
+OutIt FlatMap<KeyType, ValueType, Comp, Alloc, Search>::contains_batch(
+    KeyIt first, KeyIt last, OutIt out) const
+{
+  this->findBatch(
+      first, last, [&](const_iterator it) { *out++ = it != this->end(); });
+  return out;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::iterator
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::erase(
+    KeyType const& key) noexcept
 {
   auto it = this->lowerBound(key);
   if (it != this->container.end() && this->isKeyEqual(key, it->first))
-    return this->container.erase(it);
+    return this->erase(it);
   return this->container.end();
 }
 
-template <typename KeyType, typename ValueType, typename Comp>
-typename FlatMap<KeyType, ValueType, Comp>::iterator
-FlatMap<KeyType, ValueType, Comp>::erase(iterator it) noexcept
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::iterator
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::erase(iterator it) noexcept
 {
-  return this->container.erase(it);
+  auto const next = this->container.erase(it);
+  this->notifyErased(next);
+  return next;
 }
 
-template <typename KeyType, typename ValueType, typename Comp>
-void FlatMap<KeyType, ValueType, Comp>::clear() noexcept
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::iterator
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::erase(
+    const_iterator first, const_iterator last) noexcept
+{
+  auto const it = this->container.erase(first, last);
+  this->train();
+  return it;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::size_type
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::erase_before(
+    KeyType const& key) noexcept
+{
+  auto const last = this->lowerBound(key);
+  auto const count = static_cast<size_type>(last - this->container.begin());
+  this->container.erase(this->container.begin(), last);
+  this->train();
+  return count;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename Pred>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::size_type
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::retain(Pred pred)
+{
+  auto const last = std::remove_if(
+      this->container.begin(),
+      this->container.end(),
+      [&](PairType const& pair) { return !pred(pair); });
+  auto const count = static_cast<size_type>(this->container.end() - last);
+  this->container.erase(last, this->container.end());
+  this->train();
+  return count;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+void FlatMap<KeyType, ValueType, Comp, Alloc, Search>::clear() noexcept
 {
   this->container.clear();
+  this->train();
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::ContainerType
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::extract() noexcept
+{
+  ContainerType ret{std::move(this->container)};
+  // A moved-from vector is only guaranteed to be valid, not empty.
+  this->container.clear();
+  this->train();
+  return ret;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+void FlatMap<KeyType, ValueType, Comp, Alloc, Search>::replace(
+    ContainerType&& c) noexcept(
+    std::is_nothrow_move_assignable<ContainerType>::value)
+{
+  this->container = std::move(c);
+  assert(this->isSortedUnique());
+  this->train();
 }
 
-template <typename KeyType, typename ValueType, typename Comp>
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
 template <typename... Args>
-std::pair<typename FlatMap<KeyType, ValueType, Comp>::iterator, bool>
-FlatMap<KeyType, ValueType, Comp>::emplace(Args&&... args)
+std::pair<typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::iterator,
+          bool>
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::emplace(Args&&... args)
 {
   PairType pair{std::forward<Args>(args)...};
-  auto it = this->lowerBound(pair.first);
+  auto it = this->insertionPoint(pair.first);
   // Check if the key is already in there.
   if (it != this->container.end() && this->isKeyEqual(pair.first, it->first))
     return std::make_pair(it, false);
   it = this->container.emplace(it, std::move(pair));
+  this->notifyInserted(it);
+  return std::make_pair(it, true);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename... Args>
+std::pair<typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::iterator,
+          bool>
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::try_emplace(
+    KeyType const& key, Args&&... args)
+{
+  return this->tryEmplace(key, std::forward<Args>(args)...);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename... Args>
+std::pair<typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::iterator,
+          bool>
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::try_emplace(KeyType&& key,
+                                                              Args&&... args)
+{
+  return this->tryEmplace(std::move(key), std::forward<Args>(args)...);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename M>
+std::pair<typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::iterator,
+          bool>
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::insert_or_assign(
+    KeyType const& key, M&& obj)
+{
+  return this->insertOrAssign(key, std::forward<M>(obj));
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename M>
+std::pair<typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::iterator,
+          bool>
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::insert_or_assign(
+    KeyType&& key, M&& obj)
+{
+  return this->insertOrAssign(std::move(key), std::forward<M>(obj));
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename... Args>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::iterator
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::emplace_hint(
+    const_iterator hint, Args&&... args)
+{
+  PairType pair{std::forward<Args>(args)...};
+  auto it = this->hintedInsertionPoint(hint, pair.first);
+  if (it != this->container.end() && this->isKeyEqual(pair.first, it->first))
+    return it;
+  it = this->container.emplace(it, std::move(pair));
+  this->notifyInserted(it);
+  return it;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename InputIt>
+void FlatMap<KeyType, ValueType, Comp, Alloc, Search>::insert(
+    InputIt first, InputIt last, DuplicatePolicy policy)
+{
+  auto const sortedCount = this->container.size();
+  this->container.insert(this->container.end(), first, last);
+  this->sortAndDedup(sortedCount, policy);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename K, typename... Args>
+std::pair<typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::iterator,
+          bool>
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::tryEmplace(K&& key,
+                                                             Args&&... args)
+{
+  auto it = this->insertionPoint(key);
+  if (it != this->container.end() && this->isKeyEqual(key, it->first))
+    return std::make_pair(it, false);
+  it = this->container.emplace(
+      it,
+      std::piecewise_construct,
+      std::forward_as_tuple(std::forward<K>(key)),
+      std::forward_as_tuple(std::forward<Args>(args)...));
+  this->notifyInserted(it);
+  return std::make_pair(it, true);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename K, typename M>
+std::pair<typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::iterator,
+          bool>
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::insertOrAssign(K&& key,
+                                                                 M&& obj)
+{
+  auto it = this->insertionPoint(key);
+  if (it != this->container.end() && this->isKeyEqual(key, it->first))
+  {
+    it->second = std::forward<M>(obj);
+    return std::make_pair(it, false);
+  }
+  it = this->container.emplace(it, std::forward<K>(key), std::forward<M>(obj));
+  this->notifyInserted(it);
   return std::make_pair(it, true);
 }
 
-template <typename KeyType, typename ValueType, typename Comp>
-typename FlatMap<KeyType, ValueType, Comp>::ContainerType::iterator
-FlatMap<KeyType, ValueType, Comp>::lowerBound(KeyType const& key) noexcept
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+void FlatMap<KeyType, ValueType, Comp, Alloc, Search>::merge(
+    FlatMap&& other, DuplicatePolicy policy)
+{
+  if (&other == this)
+    return;
+  this->mergeImpl(
+      other,
+      [](PairType& pair) -> PairType&& { return std::move(pair); },
+      [policy](KeyType const&, ValueType& mine, ValueType& theirs) {
+        if (policy == DuplicatePolicy::KeepLast)
+          mine = std::move(theirs);
+      });
+  other.clear();
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+void FlatMap<KeyType, ValueType, Comp, Alloc, Search>::merge(
+    FlatMap const& other, DuplicatePolicy policy)
 {
-  return std::lower_bound(this->begin(),
-                          this->end(),
-                          key,
-                          [this](PairType const& pair, KeyType const& keyp) {
-                            return this->comp(pair.first, keyp);
-                          });
+  if (&other == this)
+    return;
+  this->mergeImpl(
+      other,
+      [](PairType const& pair) -> PairType const& { return pair; },
+      [policy](KeyType const&, ValueType& mine, ValueType const& theirs) {
+        if (policy == DuplicatePolicy::KeepLast)
+          mine = theirs;
+      });
 }
 
-template <typename KeyType, typename ValueType, typename Comp>
-typename FlatMap<KeyType, ValueType, Comp>::ContainerType::const_iterator
-FlatMap<KeyType, ValueType, Comp>::lowerBound(KeyType const& key) const noexcept
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename Resolve>
+void FlatMap<KeyType, ValueType, Comp, Alloc, Search>::merge(FlatMap&& other,
+                                                             Resolve resolve)
 {
-  return std::lower_bound(this->begin(),
-                          this->end(),
-                          key,
-                          [this](PairType const& pair, KeyType const& keyp) {
-                            return this->comp(pair.first, keyp);
-                          });
+  if (&other == this)
+    return;
+  this->mergeImpl(
+      other,
+      [](PairType& pair) -> PairType&& { return std::move(pair); },
+      resolve);
+  other.clear();
 }
 
-template <typename KeyType, typename ValueType, typename Comp>
-bool FlatMap<KeyType, ValueType, Comp>::isKeyEqual(KeyType const& a,
-                                                   KeyType const& b) const
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename Resolve>
+void FlatMap<KeyType, ValueType, Comp, Alloc, Search>::merge(
+    FlatMap const& other, Resolve resolve)
+{
+  if (&other == this)
+    return;
+  this->mergeImpl(
+      other,
+      [](PairType const& pair) -> PairType const& { return pair; },
+      resolve);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename Other, typename Move, typename Resolve>
+void FlatMap<KeyType, ValueType, Comp, Alloc, Search>::mergeImpl(
+    Other& other, Move move, Resolve resolve)
+{
+  if (other.empty())
+    return;
+  ContainerType merged(this->container.get_allocator());
+  merged.reserve(this->size() + other.size());
+  detail::combineSorted(
+      this->container.begin(),
+      this->container.end(),
+      other.begin(),
+      other.end(),
+      this->comp,
+      [&](PairType& mine) { merged.push_back(std::move(mine)); },
+      [&](auto& theirs) { merged.push_back(move(theirs)); },
+      [&](PairType& mine, auto& theirs) {
+        resolve(static_cast<KeyType const&>(mine.first),
+                mine.second,
+                theirs.second);
+        merged.push_back(std::move(mine));
+      });
+  this->container = std::move(merged);
+  this->train();
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+void FlatMap<KeyType, ValueType, Comp, Alloc, Search>::sortAndDedup(
+    size_type sortedCount, DuplicatePolicy policy)
+{
+  detail::sortTail(
+      this->container, sortedCount, this->comp, detail::PairFirst{});
+  detail::dedupSorted(
+      this->container, this->comp, detail::PairFirst{}, policy);
+  this->train();
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+void FlatMap<KeyType, ValueType, Comp, Alloc, Search>::train() noexcept
+{
+  this->search.train(
+      this->container.cbegin(), this->container.cend(), detail::PairFirst{});
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+void FlatMap<KeyType, ValueType, Comp, Alloc, Search>::notifyInserted(
+    const_iterator pos) noexcept
+{
+  this->search.inserted(this->container.cbegin(),
+                        this->container.cend(),
+                        pos,
+                        detail::PairFirst{});
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+void FlatMap<KeyType, ValueType, Comp, Alloc, Search>::notifyErased(
+    const_iterator pos) noexcept
+{
+  this->search.erased(this->container.cbegin(), this->container.cend(), pos);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename K>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::iterator
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::lowerBound(
+    K const& key) noexcept
+{
+  return this->search.lowerBound(
+      this->begin(), this->end(), key, this->comp, detail::PairFirst{});
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename K>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::const_iterator
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::lowerBound(
+    K const& key) const noexcept
+{
+  return this->search.lowerBound(
+      this->begin(), this->end(), key, this->comp, detail::PairFirst{});
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename K>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::iterator
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::insertionPoint(
+    K const& key) noexcept
+{
+  return detail::uniqueInsertionPoint(
+      this->container, key, this->comp, detail::PairFirst{});
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename K>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::iterator
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::hintedInsertionPoint(
+    const_iterator hint, K const& key) noexcept
+{
+  return detail::uniqueHintedInsertionPoint(
+      this->container, hint, key, this->comp, detail::PairFirst{});
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename K>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::iterator
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::upperBound(
+    K const& key) noexcept
+{
+  return detail::upperBound(
+      this->begin(), this->end(), key, this->comp, detail::PairFirst{});
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename K>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::const_iterator
+FlatMap<KeyType, ValueType, Comp, Alloc, Search>::upperBound(
+    K const& key) const noexcept
+{
+  return detail::upperBound(
+      this->begin(), this->end(), key, this->comp, detail::PairFirst{});
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+bool FlatMap<KeyType, ValueType, Comp, Alloc, Search>::isSortedUnique() const
     noexcept
 {
-  return this->comp(a, b) == false && this->comp(b, a) == false;
+  return detail::isSortedOn(
+      this->begin(), this->end(), this->comp, detail::PairFirst{}, true);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename KeyIt, typename OnFound>
+void FlatMap<KeyType, ValueType, Comp, Alloc, Search>::findBatch(
+    KeyIt first, KeyIt last, OnFound onFound) const
+{
+  // Enough searches in flight to cover a memory access, few enough for their
+  // state to stay in registers or L1.
+  constexpr size_type GROUP_SIZE = 16;
+  auto const data = this->container.data();
+  auto const size = this->container.size();
+  KeyType const* keys[GROUP_SIZE];
+  size_type bases[GROUP_SIZE];
+
+  while (first != last)
+  {
+    size_type count = 0;
+    for (; count < GROUP_SIZE && first != last; ++count, ++first)
+    {
+      keys[count] = std::addressof(*first);
+      bases[count] = 0;
+    }
+    if (size == 0)
+    {
+      for (size_type i = 0; i < count; ++i)
+        onFound(this->end());
+      continue;
+    }
+
+    // The same branchless search as for arithmetic keys, for every key of the
+    // group at once. All searches have the same length, only their bases
+    // differ.
+    auto n = size;
+    while (n > 1)
+    {
+      auto const half = n / 2;
+      auto const nextHalf = (n - half) / 2;
+      for (size_type i = 0; i < count; ++i)
+      {
+        auto const probe = bases[i] + half;
+        bases[i] = this->comp(data[probe].first, *keys[i]) ? probe : bases[i];
+        detail::prefetch(data, bases[i] + nextHalf);
+      }
+      n -= half;
+    }
+    for (size_type i = 0; i < count; ++i)
+    {
+      auto const idx =
+          bases[i] + (this->comp(data[bases[i]].first, *keys[i]) ? 1 : 0);
+      if (idx != size && !this->comp(*keys[i], data[idx].first))
+        onFound(this->begin() + static_cast<difference_type>(idx));
+      else
+        onFound(this->end());
+    }
+  }
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename K>
+bool FlatMap<KeyType, ValueType, Comp, Alloc, Search>::isKeyEqual(
+    K const& a, KeyType const& b) const noexcept
+{
+  return detail::isKeyEqual(this->comp, a, b);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+FlatMap<KeyType, ValueType, Comp, Alloc, Search> setUnion(
+    FlatMap<KeyType, ValueType, Comp, Alloc, Search> const& a,
+    FlatMap<KeyType, ValueType, Comp, Alloc, Search> const& b)
+{
+  return setUnion(
+      a, b, [](KeyType const&, ValueType const& valueA, ValueType const&) {
+        return valueA;
+      });
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search,
+          typename Resolve>
+FlatMap<KeyType, ValueType, Comp, Alloc, Search> setUnion(
+    FlatMap<KeyType, ValueType, Comp, Alloc, Search> const& a,
+    FlatMap<KeyType, ValueType, Comp, Alloc, Search> const& b,
+    Resolve resolve)
+{
+  using Map = FlatMap<KeyType, ValueType, Comp, Alloc, Search>;
+  using PairType = typename Map::PairType;
+  typename Map::ContainerType result(a.get_allocator());
+  result.reserve(a.size() + b.size());
+  detail::combineSorted(
+      a.begin(),
+      a.end(),
+      b.begin(),
+      b.end(),
+      a.key_comp(),
+      [&](PairType const& pair) { result.push_back(pair); },
+      [&](PairType const& pair) { result.push_back(pair); },
+      [&](PairType const& pairA, PairType const& pairB) {
+        result.emplace_back(pairA.first,
+                            resolve(pairA.first, pairA.second, pairB.second));
+      });
+  return Map{sorted_unique, std::move(result), a.key_comp()};
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+FlatMap<KeyType, ValueType, Comp, Alloc, Search> setIntersection(
+    FlatMap<KeyType, ValueType, Comp, Alloc, Search> const& a,
+    FlatMap<KeyType, ValueType, Comp, Alloc, Search> const& b)
+{
+  return setIntersection(
+      a, b, [](KeyType const&, ValueType const& valueA, ValueType const&) {
+        return valueA;
+      });
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search,
+          typename Resolve>
+FlatMap<KeyType, ValueType, Comp, Alloc, Search> setIntersection(
+    FlatMap<KeyType, ValueType, Comp, Alloc, Search> const& a,
+    FlatMap<KeyType, ValueType, Comp, Alloc, Search> const& b,
+    Resolve resolve)
+{
+  using Map = FlatMap<KeyType, ValueType, Comp, Alloc, Search>;
+  using PairType = typename Map::PairType;
+  typename Map::ContainerType result(a.get_allocator());
+  result.reserve(std::min(a.size(), b.size()));
+  detail::combineSorted(
+      a.begin(),
+      a.end(),
+      b.begin(),
+      b.end(),
+      a.key_comp(),
+      [](PairType const&) {},
+      [](PairType const&) {},
+      [&](PairType const& pairA, PairType const& pairB) {
+        result.emplace_back(pairA.first,
+                            resolve(pairA.first, pairA.second, pairB.second));
+      });
+  return Map{sorted_unique, std::move(result), a.key_comp()};
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search,
+          typename OtherValueType,
+          typename OtherAlloc,
+          typename OtherSearch>
+FlatMap<KeyType, ValueType, Comp, Alloc, Search> setDifference(
+    FlatMap<KeyType, ValueType, Comp, Alloc, Search> const& a,
+    FlatMap<KeyType, OtherValueType, Comp, OtherAlloc, OtherSearch> const& b)
+{
+  using Map = FlatMap<KeyType, ValueType, Comp, Alloc, Search>;
+  using PairType = typename Map::PairType;
+  using OtherMap =
+      FlatMap<KeyType, OtherValueType, Comp, OtherAlloc, OtherSearch>;
+  using OtherPairType = typename OtherMap::PairType;
+  typename Map::ContainerType result(a.get_allocator());
+  result.reserve(a.size());
+  detail::combineSorted(
+      a.begin(),
+      a.end(),
+      b.begin(),
+      b.end(),
+      a.key_comp(),
+      [&](PairType const& pair) { result.push_back(pair); },
+      [](OtherPairType const&) {},
+      [](PairType const&, OtherPairType const&) {});
+  return Map{sorted_unique, std::move(result), a.key_comp()};
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search,
+          typename Pred>
+typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::size_type erase_if(
+    FlatMap<KeyType, ValueType, Comp, Alloc, Search>& fm, Pred pred)
+{
+  using PairType =
+      typename FlatMap<KeyType, ValueType, Comp, Alloc, Search>::PairType;
+  return fm.retain([&](PairType const& pair) { return !pred(pair); });
 }
 }
 
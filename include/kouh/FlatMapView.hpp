@@ -0,0 +1,206 @@
+#ifndef KOUH_FLATMAPVIEW_HPP_
+#define KOUH_FLATMAPVIEW_HPP_
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include <kouh/FlatMap.hpp>
+#include <kouh/Serialization.hpp>
+
+namespace kouh
+{
+/** Writes fm to out, in the format FlatMapView reads.
+ *
+ * Keys and values must be trivially copyable or std::string, and keys must
+ * be ordered with std::less. Throws std::runtime_error if out fails.
+ */
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+void serialize(FlatMap<KeyType, ValueType, Comp, Alloc, Search> const& fm,
+               std::ostream& out)
+{
+  static_assert(std::is_same<Comp, std::less<KeyType>>::value,
+                "FlatMapView searches keys with std::less");
+  using PairType = std::pair<KeyType, ValueType>;
+  detail::serializeColumns<KeyType, ValueType>(
+      out,
+      detail::SerializedHeader::Map,
+      fm.begin(),
+      fm.end(),
+      [](PairType const& pair) -> KeyType const& { return pair.first; },
+      [](PairType const& pair) -> ValueType const& { return pair.second; });
+}
+
+/** A read-only FlatMap, served straight from a serialized one.
+ *
+ * The view reads the buffer `serialize` wrote, typically through a
+ * MappedFile: nothing is copied or parsed, building it only checks the
+ * header and, for string columns, the array of offsets. Lookups binary
+ * search the key column in place, so processes that map the same file share
+ * its pages instead of each building its own map.
+ *
+ * The buffer must be aligned on 8 bytes and outlive the view. Only sizes are
+ * recorded in the file, not types: reading a file with types of the same
+ * size it was not written with is not detected.
+ *
+ * Keys and values that are std::string are handed out as MappedString.
+ * Iterators dereference to a pair of references made on the fly, so they
+ * are only input iterators, and have no operator->.
+ */
+template <typename KeyType, typename ValueType>
+class FlatMapView
+{
+  using KeyColumn = detail::SerializedColumn<KeyType>;
+  using ValueColumn = detail::SerializedColumn<ValueType>;
+
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using size_type = std::size_t;
+  using key_reference = typename KeyColumn::reference;
+  using mapped_reference = typename ValueColumn::reference;
+  class const_iterator;
+  using iterator = const_iterator;
+
+  FlatMapView() noexcept = default;
+  /** View the serialized FlatMap in [data, data + size).
+   * Throws std::invalid_argument if it does not hold a FlatMap of these
+   * types.
+   */
+  FlatMapView(void const* data, std::size_t size)
+  {
+    auto const& header = detail::readHeader<KeyType, ValueType>(
+        data, size, detail::SerializedHeader::Map);
+    auto const bytes = static_cast<char const*>(data);
+    this->elementCount = static_cast<size_type>(header.count);
+    this->keys = KeyColumn{bytes + header.keyOffset,
+                           header.valueOffset - header.keyOffset,
+                           header.count};
+    this->values = ValueColumn{bytes + header.valueOffset,
+                               header.totalSize - header.valueOffset,
+                               header.count};
+  }
+
+  /// Returns the number of elements in the FlatMapView.
+  size_type size() const noexcept
+  {
+    return this->elementCount;
+  }
+  /// Returns true if there are no elements in the FlatMapView.
+  bool empty() const noexcept
+  {
+    return this->elementCount == 0;
+  }
+
+  const_iterator begin() const noexcept
+  {
+    return const_iterator{this, 0};
+  }
+  const_iterator end() const noexcept
+  {
+    return const_iterator{this, this->elementCount};
+  }
+  const_iterator cbegin() const noexcept
+  {
+    return this->begin();
+  }
+  const_iterator cend() const noexcept
+  {
+    return this->end();
+  }
+
+  /** Find the position of the value for given key.
+   * Returns end() if no match was found.
+   */
+  const_iterator find(KeyType const& key) const noexcept
+  {
+    auto const i = this->keys.lowerBound(key, this->elementCount);
+    if (i != this->elementCount && this->keys.equal(i, key))
+      return const_iterator{this, i};
+    return this->end();
+  }
+  /// Returns 1 if key is in the FlatMapView, 0 otherwise.
+  size_type count(KeyType const& key) const noexcept
+  {
+    return this->contains(key) ? 1 : 0;
+  }
+  /// Returns true if key is in the FlatMapView, false otherwise.
+  bool contains(KeyType const& key) const noexcept
+  {
+    return this->find(key) != this->end();
+  }
+  mapped_reference at(KeyType const& key) const
+  {
+    auto const i = this->keys.lowerBound(key, this->elementCount);
+    if (i != this->elementCount && this->keys.equal(i, key))
+      return this->values[i];
+    throw std::out_of_range("Invalid access at FlatMapView::at const");
+  }
+
+private:
+  size_type elementCount = 0;
+  KeyColumn keys;
+  ValueColumn values;
+};
+
+/// Iterates over the elements of a FlatMapView, in key order.
+template <typename KeyType, typename ValueType>
+class FlatMapView<KeyType, ValueType>::const_iterator
+{
+public:
+  using iterator_category = std::input_iterator_tag;
+  using value_type = std::pair<KeyType, ValueType>;
+  using difference_type = std::ptrdiff_t;
+  using reference = std::pair<key_reference, mapped_reference>;
+  using pointer = void;
+
+  const_iterator() noexcept = default;
+
+  reference operator*() const noexcept
+  {
+    return {this->view->keys[this->index], this->view->values[this->index]};
+  }
+
+  const_iterator& operator++() noexcept
+  {
+    ++this->index;
+    return *this;
+  }
+  const_iterator operator++(int) noexcept
+  {
+    auto ret = *this;
+    ++*this;
+    return ret;
+  }
+
+  bool operator==(const_iterator const& rhs) const noexcept
+  {
+    return this->index == rhs.index;
+  }
+  bool operator!=(const_iterator const& rhs) const noexcept
+  {
+    return !(*this == rhs);
+  }
+
+private:
+  friend class FlatMapView;
+
+  const_iterator(FlatMapView const* v, size_type i) noexcept
+    : view(v), index(i)
+  {
+  }
+
+  FlatMapView const* view = nullptr;
+  size_type index = 0;
+};
+}
+
+#endif /* !KOUH_FLATMAPVIEW_HPP_ */
@@ -0,0 +1,313 @@
+#ifndef KOUH_FLATMULTIMAP_HPP_
+#define KOUH_FLATMULTIMAP_HPP_
+
+#include <cassert>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <kouh/LowerBound.hpp>
+#include <kouh/Pmr.hh>
+#include <kouh/SortedVector.hpp>
+
+namespace kouh
+{
+/** A flattened associative container with equivalent keys.
+ *
+ * The FlatMultiMap is a FlatMap that accepts several elements with the same
+ * key. They are kept next to each other, in their order of insertion, like
+ * in std::multimap.
+ */
+template <typename KeyType,
+          typename ValueType,
+          typename Comp = std::less<KeyType>,
+          typename Alloc = std::allocator<std::pair<KeyType, ValueType>>>
+class FlatMultiMap
+{
+public:
+  using PairType = std::pair<KeyType, ValueType>;
+  using value_type = PairType;
+  using allocator_type = Alloc;
+  using ContainerType = std::vector<PairType, Alloc>;
+  using size_type = typename ContainerType::size_type;
+  using difference_type = typename ContainerType::difference_type;
+  using iterator = typename ContainerType::iterator;
+  using const_iterator = typename ContainerType::const_iterator;
+  using reverse_iterator = typename ContainerType::reverse_iterator;
+  using const_reverse_iterator = typename ContainerType::const_reverse_iterator;
+
+  FlatMultiMap() noexcept = default;
+  /// Construct an empty FlatMultiMap whose storage comes from alloc.
+  explicit FlatMultiMap(Alloc const& alloc) noexcept : container(alloc)
+  {
+  }
+  FlatMultiMap(std::initializer_list<PairType> l) : container(l)
+  {
+    this->sort(0);
+  }
+  /// Construct from an unsorted range of pairs.
+  template <typename InputIt>
+  FlatMultiMap(InputIt first, InputIt last) : container(first, last)
+  {
+    this->sort(0);
+  }
+  /// Construct by adopting an unsorted vector of pairs.
+  explicit FlatMultiMap(ContainerType&& c) : container(std::move(c))
+  {
+    this->sort(0);
+  }
+  /// Construct by adopting a vector that is already sorted.
+  FlatMultiMap(sorted_equivalent_t,
+               ContainerType&& c,
+               Comp const& cmp = Comp{})
+    : container(std::move(c)), comp(cmp)
+  {
+    assert(this->isSorted());
+  }
+  FlatMultiMap(FlatMultiMap const& b) = default;
+  FlatMultiMap(FlatMultiMap&& b) noexcept = default;
+  ~FlatMultiMap() noexcept = default;
+
+  FlatMultiMap& operator=(FlatMultiMap const& rhs) = default;
+  FlatMultiMap& operator=(FlatMultiMap&& rhs) noexcept = default;
+
+  /// Returns the number of elements in the FlatMultiMap.
+  size_type size() const noexcept
+  {
+    return this->container.size();
+  }
+  /// Returns true if there are no elements in the FlatMultiMap.
+  bool empty() const noexcept
+  {
+    return this->container.empty();
+  }
+
+  iterator begin() noexcept
+  {
+    return this->container.begin();
+  }
+  iterator end() noexcept
+  {
+    return this->container.end();
+  }
+  const_iterator begin() const noexcept
+  {
+    return this->container.begin();
+  }
+  const_iterator end() const noexcept
+  {
+    return this->container.end();
+  }
+  const_iterator cbegin() const noexcept
+  {
+    return this->container.cbegin();
+  }
+  const_iterator cend() const noexcept
+  {
+    return this->container.cend();
+  }
+
+  /// Returns the comparator used to order keys.
+  Comp key_comp() const
+  {
+    return this->comp;
+  }
+  /// Returns the allocator the elements are stored with.
+  Alloc get_allocator() const noexcept
+  {
+    return this->container.get_allocator();
+  }
+
+  /** Find the position of the first element with given key.
+   * Returns end() if no match was found.
+   */
+  iterator find(KeyType const& key) noexcept
+  {
+    auto const it = this->lowerBound(key);
+    if (it != this->end() && detail::isKeyEqual(this->comp, key, it->first))
+      return it;
+    return this->end();
+  }
+  const_iterator find(KeyType const& key) const noexcept
+  {
+    auto const it = this->lowerBound(key);
+    if (it != this->end() && detail::isKeyEqual(this->comp, key, it->first))
+      return it;
+    return this->end();
+  }
+  /// Returns the number of elements with given key.
+  size_type count(KeyType const& key) const noexcept
+  {
+    auto const range = this->equal_range(key);
+    return static_cast<size_type>(range.second - range.first);
+  }
+  /// Returns true if key is in the FlatMultiMap, false otherwise.
+  bool contains(KeyType const& key) const noexcept
+  {
+    return this->find(key) != this->end();
+  }
+  /// Returns an iterator to the first element whose key is not less than key.
+  iterator lower_bound(KeyType const& key) noexcept
+  {
+    return this->lowerBound(key);
+  }
+  const_iterator lower_bound(KeyType const& key) const noexcept
+  {
+    return this->lowerBound(key);
+  }
+  /// Returns an iterator to the first element whose key is greater than key.
+  iterator upper_bound(KeyType const& key) noexcept
+  {
+    return detail::upperBound(
+        this->begin(), this->end(), key, this->comp, detail::PairFirst{});
+  }
+  const_iterator upper_bound(KeyType const& key) const noexcept
+  {
+    return detail::upperBound(
+        this->begin(), this->end(), key, this->comp, detail::PairFirst{});
+  }
+  /** Returns the range of elements with given key.
+   * The upper bound is only searched for past the lower bound.
+   */
+  std::pair<iterator, iterator> equal_range(KeyType const& key) noexcept
+  {
+    auto const first = this->lowerBound(key);
+    return {first,
+            detail::upperBound(
+                first, this->end(), key, this->comp, detail::PairFirst{})};
+  }
+  std::pair<const_iterator, const_iterator> equal_range(
+      KeyType const& key) const noexcept
+  {
+    auto const first = this->lowerBound(key);
+    return {first,
+            detail::upperBound(
+                first, this->end(), key, this->comp, detail::PairFirst{})};
+  }
+
+  /** In-place insertion, after the elements with the same key.
+   * Inserting keys in non-decreasing order skips the search and amounts to a
+   * push_back.
+   */
+  template <typename... Args>
+  iterator emplace(Args&&... args)
+  {
+    PairType pair(std::forward<Args>(args)...);
+    auto const it = detail::equivalentInsertionPoint(
+        this->container, pair.first, this->comp, detail::PairFirst{});
+    return this->container.insert(it, std::move(pair));
+  }
+  /** In-place insertion, right before hint if the order allows it.
+   * Otherwise, this behaves like emplace.
+   */
+  template <typename... Args>
+  iterator emplace_hint(const_iterator hint, Args&&... args)
+  {
+    PairType pair(std::forward<Args>(args)...);
+    auto const it = detail::equivalentHintedInsertionPoint(
+        this->container, hint, pair.first, this->comp, detail::PairFirst{});
+    return this->container.insert(it, std::move(pair));
+  }
+  iterator insert(PairType const& pair)
+  {
+    return this->emplace(pair);
+  }
+  iterator insert(PairType&& pair)
+  {
+    return this->emplace(std::move(pair));
+  }
+  /** Bulk insertion of an unsorted range.
+   * Elements are appended, sorted once and merged with the existing ones.
+   * Existing elements come before new ones with the same key.
+   */
+  template <typename InputIt>
+  void insert(InputIt first, InputIt last)
+  {
+    auto const sortedCount = this->container.size();
+    this->container.insert(this->container.end(), first, last);
+    this->sort(sortedCount);
+  }
+  /// Removes every element with given key. Returns how many were removed.
+  size_type erase(KeyType const& key) noexcept
+  {
+    auto const range = this->equal_range(key);
+    auto const count = static_cast<size_type>(range.second - range.first);
+    this->container.erase(range.first, range.second);
+    return count;
+  }
+  iterator erase(const_iterator it) noexcept
+  {
+    return this->container.erase(it);
+  }
+  /// Removes every element.
+  void clear() noexcept
+  {
+    this->container.clear();
+  }
+  /** Moves the underlying vector out of the FlatMultiMap.
+   * The FlatMultiMap is left empty.
+   */
+  ContainerType extract() noexcept
+  {
+    ContainerType ret{std::move(this->container)};
+    this->container.clear();
+    return ret;
+  }
+  /** Replaces the underlying vector with one that is already sorted.
+   * Runs in constant time, unless the allocators differ and do not
+   * propagate, in which case the elements are moved one by one.
+   */
+  void replace(ContainerType&& c) noexcept(
+      std::is_nothrow_move_assignable<ContainerType>::value)
+  {
+    this->container = std::move(c);
+    assert(this->isSorted());
+  }
+
+private:
+  iterator lowerBound(KeyType const& key) noexcept
+  {
+    return detail::lowerBound(
+        this->begin(), this->end(), key, this->comp, detail::PairFirst{});
+  }
+  const_iterator lowerBound(KeyType const& key) const noexcept
+  {
+    return detail::lowerBound(
+        this->begin(), this->end(), key, this->comp, detail::PairFirst{});
+  }
+  void sort(size_type sortedCount)
+  {
+    detail::sortTail(
+        this->container, sortedCount, this->comp, detail::PairFirst{});
+  }
+  bool isSorted() const noexcept
+  {
+    return detail::isSortedOn(
+        this->begin(), this->end(), this->comp, detail::PairFirst{}, false);
+  }
+
+  ContainerType container;
+  Comp comp;
+};
+
+#ifdef KOUH_HAS_PMR
+namespace pmr
+{
+/// A FlatMultiMap whose storage comes from a std::pmr::memory_resource.
+template <typename KeyType,
+          typename ValueType,
+          typename Comp = std::less<KeyType>>
+using FlatMultiMap = kouh::FlatMultiMap<
+    KeyType,
+    ValueType,
+    Comp,
+    std::pmr::polymorphic_allocator<std::pair<KeyType, ValueType>>>;
+}
+#endif
+}
+
+#endif /* !KOUH_FLATMULTIMAP_HPP_ */
@@ -0,0 +1,272 @@
+#ifndef KOUH_FLATMULTISET_HPP_
+#define KOUH_FLATMULTISET_HPP_
+
+#include <cassert>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <kouh/LowerBound.hpp>
+#include <kouh/Pmr.hh>
+#include <kouh/SortedVector.hpp>
+
+namespace kouh
+{
+/** A flattened sorted multiset.
+ *
+ * The FlatMultiSet is a FlatSet that accepts equivalent keys. They are kept
+ * next to each other, in their order of insertion, like in std::multiset.
+ */
+template <typename KeyType,
+          typename Comp = std::less<KeyType>,
+          typename Alloc = std::allocator<KeyType>>
+class FlatMultiSet
+{
+public:
+  using key_type = KeyType;
+  using value_type = KeyType;
+  using allocator_type = Alloc;
+  using ContainerType = std::vector<KeyType, Alloc>;
+  using size_type = typename ContainerType::size_type;
+  using difference_type = typename ContainerType::difference_type;
+  using iterator = typename ContainerType::const_iterator;
+  using const_iterator = typename ContainerType::const_iterator;
+  using reverse_iterator = typename ContainerType::const_reverse_iterator;
+  using const_reverse_iterator = typename ContainerType::const_reverse_iterator;
+
+  FlatMultiSet() noexcept = default;
+  /// Construct an empty FlatMultiSet whose storage comes from alloc.
+  explicit FlatMultiSet(Alloc const& alloc) noexcept : container(alloc)
+  {
+  }
+  FlatMultiSet(std::initializer_list<KeyType> l) : container(l)
+  {
+    this->sort(0);
+  }
+  /// Construct from an unsorted range of keys.
+  template <typename InputIt>
+  FlatMultiSet(InputIt first, InputIt last) : container(first, last)
+  {
+    this->sort(0);
+  }
+  /// Construct by adopting an unsorted vector of keys.
+  explicit FlatMultiSet(ContainerType&& c) : container(std::move(c))
+  {
+    this->sort(0);
+  }
+  /// Construct by adopting a vector that is already sorted.
+  FlatMultiSet(sorted_equivalent_t,
+               ContainerType&& c,
+               Comp const& cmp = Comp{})
+    : container(std::move(c)), comp(cmp)
+  {
+    assert(this->isSorted());
+  }
+  FlatMultiSet(FlatMultiSet const& b) = default;
+  FlatMultiSet(FlatMultiSet&& b) noexcept = default;
+  ~FlatMultiSet() noexcept = default;
+
+  FlatMultiSet& operator=(FlatMultiSet const& rhs) = default;
+  FlatMultiSet& operator=(FlatMultiSet&& rhs) noexcept = default;
+
+  /// Returns the number of keys in the FlatMultiSet.
+  size_type size() const noexcept
+  {
+    return this->container.size();
+  }
+  /// Returns true if there are no keys in the FlatMultiSet.
+  bool empty() const noexcept
+  {
+    return this->container.empty();
+  }
+
+  const_iterator begin() const noexcept
+  {
+    return this->container.begin();
+  }
+  const_iterator end() const noexcept
+  {
+    return this->container.end();
+  }
+  const_iterator cbegin() const noexcept
+  {
+    return this->container.cbegin();
+  }
+  const_iterator cend() const noexcept
+  {
+    return this->container.cend();
+  }
+
+  /// Returns the comparator used to order keys.
+  Comp key_comp() const
+  {
+    return this->comp;
+  }
+  /// Returns the allocator the elements are stored with.
+  Alloc get_allocator() const noexcept
+  {
+    return this->container.get_allocator();
+  }
+
+  /** Find the position of the first key equivalent to key.
+   * Returns end() if no match was found.
+   */
+  const_iterator find(KeyType const& key) const noexcept
+  {
+    auto const it = this->lowerBound(key);
+    if (it != this->end() && detail::isKeyEqual(this->comp, key, *it))
+      return it;
+    return this->end();
+  }
+  /// Returns the number of keys equivalent to key.
+  size_type count(KeyType const& key) const noexcept
+  {
+    auto const range = this->equal_range(key);
+    return static_cast<size_type>(range.second - range.first);
+  }
+  /// Returns true if key is in the FlatMultiSet, false otherwise.
+  bool contains(KeyType const& key) const noexcept
+  {
+    return this->find(key) != this->end();
+  }
+  /// Returns an iterator to the first key not less than key.
+  const_iterator lower_bound(KeyType const& key) const noexcept
+  {
+    return this->lowerBound(key);
+  }
+  /// Returns an iterator to the first key greater than key.
+  const_iterator upper_bound(KeyType const& key) const noexcept
+  {
+    return detail::upperBound(
+        this->begin(), this->end(), key, this->comp, detail::Identity{});
+  }
+  /** Returns the range of keys equivalent to key.
+   * The upper bound is only searched for past the lower bound.
+   */
+  std::pair<const_iterator, const_iterator> equal_range(
+      KeyType const& key) const noexcept
+  {
+    auto const first = this->lowerBound(key);
+    return {first,
+            detail::upperBound(
+                first, this->end(), key, this->comp, detail::Identity{})};
+  }
+
+  /** In-place insertion, after the keys equivalent to the new one.
+   * Inserting keys in non-decreasing order skips the search and amounts to a
+   * push_back.
+   */
+  template <typename... Args>
+  iterator emplace(Args&&... args)
+  {
+    KeyType key(std::forward<Args>(args)...);
+    auto const it = detail::equivalentInsertionPoint(
+        this->container, key, this->comp, detail::Identity{});
+    return this->container.insert(it, std::move(key));
+  }
+  /** In-place insertion, right before hint if the order allows it.
+   * Otherwise, this behaves like emplace.
+   */
+  template <typename... Args>
+  iterator emplace_hint(const_iterator hint, Args&&... args)
+  {
+    KeyType key(std::forward<Args>(args)...);
+    auto const it = detail::equivalentHintedInsertionPoint(
+        this->container, hint, key, this->comp, detail::Identity{});
+    return this->container.insert(it, std::move(key));
+  }
+  iterator insert(KeyType const& key)
+  {
+    return this->emplace(key);
+  }
+  iterator insert(KeyType&& key)
+  {
+    return this->emplace(std::move(key));
+  }
+  /** Bulk insertion of an unsorted range.
+   * Keys are appended, sorted once and merged with the existing ones.
+   */
+  template <typename InputIt>
+  void insert(InputIt first, InputIt last)
+  {
+    auto const sortedCount = this->container.size();
+    this->container.insert(this->container.end(), first, last);
+    this->sort(sortedCount);
+  }
+  /// Removes every key equivalent to key. Returns how many were removed.
+  size_type erase(KeyType const& key) noexcept
+  {
+    auto const range = this->equal_range(key);
+    auto const count = static_cast<size_type>(range.second - range.first);
+    this->container.erase(range.first, range.second);
+    return count;
+  }
+  iterator erase(const_iterator it) noexcept
+  {
+    return this->container.erase(it);
+  }
+  /// Removes every key.
+  void clear() noexcept
+  {
+    this->container.clear();
+  }
+  /** Moves the underlying vector out of the FlatMultiSet.
+   * The FlatMultiSet is left empty.
+   */
+  ContainerType extract() noexcept
+  {
+    ContainerType ret{std::move(this->container)};
+    this->container.clear();
+    return ret;
+  }
+  /** Replaces the underlying vector with one that is already sorted.
+   * Runs in constant time, unless the allocators differ and do not
+   * propagate, in which case the elements are moved one by one.
+   */
+  void replace(ContainerType&& c) noexcept(
+      std::is_nothrow_move_assignable<ContainerType>::value)
+  {
+    this->container = std::move(c);
+    assert(this->isSorted());
+  }
+
+private:
+  /// Contiguous keys let lowerBound count with SIMD.
+  const_iterator lowerBound(KeyType const& key) const noexcept
+  {
+    auto const first = this->container.data();
+    auto const it = detail::lowerBound(
+        first, first + this->size(), key, this->comp, detail::Identity{});
+    return this->begin() + (it - first);
+  }
+  void sort(size_type sortedCount)
+  {
+    detail::sortTail(
+        this->container, sortedCount, this->comp, detail::Identity{});
+  }
+  bool isSorted() const noexcept
+  {
+    return detail::isSortedOn(
+        this->begin(), this->end(), this->comp, detail::Identity{}, false);
+  }
+
+  ContainerType container;
+  Comp comp;
+};
+
+#ifdef KOUH_HAS_PMR
+namespace pmr
+{
+/// A FlatMultiSet whose storage comes from a std::pmr::memory_resource.
+template <typename KeyType, typename Comp = std::less<KeyType>>
+using FlatMultiSet =
+    kouh::FlatMultiSet<KeyType, Comp, std::pmr::polymorphic_allocator<KeyType>>;
+}
+#endif
+}
+
+#endif /* !KOUH_FLATMULTISET_HPP_ */
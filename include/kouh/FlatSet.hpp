@@ -0,0 +1,280 @@
+#ifndef KOUH_FLATSET_HPP_
+#define KOUH_FLATSET_HPP_
+
+#include <cassert>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <kouh/LowerBound.hpp>
+#include <kouh/Pmr.hh>
+#include <kouh/SortedVector.hpp>
+
+namespace kouh
+{
+/** A flattened sorted set.
+ *
+ * The FlatSet stores its keys sorted in a std::vector. It is to std::set what
+ * FlatMap is to std::map, and shares its sorted vector core with it.
+ *
+ * Keys cannot be modified in place: iterator and const_iterator are the same
+ * type.
+ */
+template <typename KeyType,
+          typename Comp = std::less<KeyType>,
+          typename Alloc = std::allocator<KeyType>>
+class FlatSet
+{
+public:
+  using key_type = KeyType;
+  using value_type = KeyType;
+  using allocator_type = Alloc;
+  using ContainerType = std::vector<KeyType, Alloc>;
+  using size_type = typename ContainerType::size_type;
+  using difference_type = typename ContainerType::difference_type;
+  using iterator = typename ContainerType::const_iterator;
+  using const_iterator = typename ContainerType::const_iterator;
+  using reverse_iterator = typename ContainerType::const_reverse_iterator;
+  using const_reverse_iterator = typename ContainerType::const_reverse_iterator;
+
+  FlatSet() noexcept = default;
+  /// Construct an empty FlatSet whose storage comes from alloc.
+  explicit FlatSet(Alloc const& alloc) noexcept : container(alloc)
+  {
+  }
+  FlatSet(std::initializer_list<KeyType> l) : container(l)
+  {
+    this->sortAndDedup(0);
+  }
+  /// Construct from an unsorted range of keys.
+  template <typename InputIt>
+  FlatSet(InputIt first, InputIt last) : container(first, last)
+  {
+    this->sortAndDedup(0);
+  }
+  /// Construct by adopting an unsorted vector of keys.
+  explicit FlatSet(ContainerType&& c) : container(std::move(c))
+  {
+    this->sortAndDedup(0);
+  }
+  /// Construct by adopting a vector that is already sorted and unique.
+  FlatSet(sorted_unique_t, ContainerType&& c, Comp const& cmp = Comp{})
+    : container(std::move(c)), comp(cmp)
+  {
+    assert(this->isSorted());
+  }
+  FlatSet(FlatSet const& b) = default;
+  FlatSet(FlatSet&& b) noexcept = default;
+  ~FlatSet() noexcept = default;
+
+  FlatSet& operator=(FlatSet const& rhs) = default;
+  FlatSet& operator=(FlatSet&& rhs) noexcept = default;
+
+  /// Returns the number of keys in the FlatSet.
+  size_type size() const noexcept
+  {
+    return this->container.size();
+  }
+  /// Returns true if there are no keys in the FlatSet.
+  bool empty() const noexcept
+  {
+    return this->container.empty();
+  }
+
+  const_iterator begin() const noexcept
+  {
+    return this->container.begin();
+  }
+  const_iterator end() const noexcept
+  {
+    return this->container.end();
+  }
+  const_iterator cbegin() const noexcept
+  {
+    return this->container.cbegin();
+  }
+  const_iterator cend() const noexcept
+  {
+    return this->container.cend();
+  }
+
+  /// Returns the comparator used to order keys.
+  Comp key_comp() const
+  {
+    return this->comp;
+  }
+  /// Returns the allocator the elements are stored with.
+  Alloc get_allocator() const noexcept
+  {
+    return this->container.get_allocator();
+  }
+
+  /** Find the position of key.
+   * Returns end() if no match was found.
+   */
+  const_iterator find(KeyType const& key) const noexcept
+  {
+    auto const it = this->lowerBound(key);
+    if (it != this->end() && detail::isKeyEqual(this->comp, key, *it))
+      return it;
+    return this->end();
+  }
+  /// Returns 1 if key is in the FlatSet, 0 otherwise.
+  size_type count(KeyType const& key) const noexcept
+  {
+    return this->contains(key) ? 1 : 0;
+  }
+  /// Returns true if key is in the FlatSet, false otherwise.
+  bool contains(KeyType const& key) const noexcept
+  {
+    return this->find(key) != this->end();
+  }
+  /// Returns an iterator to the first key not less than key.
+  const_iterator lower_bound(KeyType const& key) const noexcept
+  {
+    return this->lowerBound(key);
+  }
+  /// Returns an iterator to the first key greater than key.
+  const_iterator upper_bound(KeyType const& key) const noexcept
+  {
+    return detail::upperBound(
+        this->begin(), this->end(), key, this->comp, detail::Identity{});
+  }
+  /// Returns the range of keys equivalent to key. It has at most one key.
+  std::pair<const_iterator, const_iterator> equal_range(
+      KeyType const& key) const noexcept
+  {
+    auto const first = this->lowerBound(key);
+    if (first != this->end() && detail::isKeyEqual(this->comp, key, *first))
+      return {first, first + 1};
+    return {first, first};
+  }
+
+  /** In-place insertion.
+   * Inserting keys in increasing order skips the search and amounts to a
+   * push_back.
+   */
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args)
+  {
+    KeyType key(std::forward<Args>(args)...);
+    auto const it = detail::uniqueInsertionPoint(
+        this->container, key, this->comp, detail::Identity{});
+    if (it != this->container.end() && detail::isKeyEqual(this->comp, key, *it))
+      return {it, false};
+    return {this->container.insert(it, std::move(key)), true};
+  }
+  /** In-place insertion, next to hint.
+   * Returns an iterator to the inserted key, or to the key that prevented
+   * insertion.
+   */
+  template <typename... Args>
+  iterator emplace_hint(const_iterator hint, Args&&... args)
+  {
+    KeyType key(std::forward<Args>(args)...);
+    auto const it = detail::uniqueHintedInsertionPoint(
+        this->container, hint, key, this->comp, detail::Identity{});
+    if (it != this->container.end() && detail::isKeyEqual(this->comp, key, *it))
+      return it;
+    return this->container.insert(it, std::move(key));
+  }
+  std::pair<iterator, bool> insert(KeyType const& key)
+  {
+    return this->emplace(key);
+  }
+  std::pair<iterator, bool> insert(KeyType&& key)
+  {
+    return this->emplace(std::move(key));
+  }
+  /** Bulk insertion of an unsorted range.
+   * Keys are appended, sorted once and merged with the existing ones.
+   */
+  template <typename InputIt>
+  void insert(InputIt first, InputIt last)
+  {
+    auto const sortedCount = this->container.size();
+    this->container.insert(this->container.end(), first, last);
+    this->sortAndDedup(sortedCount);
+  }
+  /// Removes key. Returns the number of removed keys.
+  size_type erase(KeyType const& key) noexcept
+  {
+    auto const it = this->find(key);
+    if (it == this->end())
+      return 0;
+    this->container.erase(it);
+    return 1;
+  }
+  iterator erase(const_iterator it) noexcept
+  {
+    return this->container.erase(it);
+  }
+  /// Removes every key.
+  void clear() noexcept
+  {
+    this->container.clear();
+  }
+  /** Moves the underlying vector out of the FlatSet.
+   * The FlatSet is left empty.
+   */
+  ContainerType extract() noexcept
+  {
+    ContainerType ret{std::move(this->container)};
+    this->container.clear();
+    return ret;
+  }
+  /** Replaces the underlying vector with one that is already sorted and
+   * unique. Runs in constant time, unless the allocators differ and do not
+   * propagate, in which case the elements are moved one by one.
+   */
+  void replace(ContainerType&& c) noexcept(
+      std::is_nothrow_move_assignable<ContainerType>::value)
+  {
+    this->container = std::move(c);
+    assert(this->isSorted());
+  }
+
+private:
+  /// Contiguous keys let lowerBound count with SIMD.
+  const_iterator lowerBound(KeyType const& key) const noexcept
+  {
+    auto const first = this->container.data();
+    auto const it = detail::lowerBound(
+        first, first + this->size(), key, this->comp, detail::Identity{});
+    return this->begin() + (it - first);
+  }
+  void sortAndDedup(size_type sortedCount)
+  {
+    detail::sortTail(
+        this->container, sortedCount, this->comp, detail::Identity{});
+    detail::dedupSorted(this->container,
+                        this->comp,
+                        detail::Identity{},
+                        DuplicatePolicy::KeepFirst);
+  }
+  bool isSorted() const noexcept
+  {
+    return detail::isSortedOn(
+        this->begin(), this->end(), this->comp, detail::Identity{}, true);
+  }
+
+  ContainerType container;
+  Comp comp;
+};
+
+#ifdef KOUH_HAS_PMR
+namespace pmr
+{
+/// A FlatSet whose storage comes from a std::pmr::memory_resource.
+template <typename KeyType, typename Comp = std::less<KeyType>>
+using FlatSet =
+    kouh::FlatSet<KeyType, Comp, std::pmr::polymorphic_allocator<KeyType>>;
+}
+#endif
+}
+
+#endif /* !KOUH_FLATSET_HPP_ */
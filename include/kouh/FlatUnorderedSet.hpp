@@ -4,8 +4,11 @@
 #include <algorithm>
 #include <functional>
 #include <initializer_list>
+#include <memory>
 #include <vector>
 
+#include <kouh/Pmr.hh>
+
 namespace kouh
 {
 /** A flattened associative container.
@@ -16,13 +19,18 @@ namespace kouh
  * deletion.
  *
  * The container otherwise behaves as a standard std::set.
+ *
+ * Memory is obtained from Alloc. See kouh::pmr::FlatUnorderedSet.
  */
-template <typename ValueType, typename Comparator = std::equal_to<ValueType>>
+template <typename ValueType,
+          typename Comparator = std::equal_to<ValueType>,
+          typename Alloc = std::allocator<ValueType>>
 class FlatUnorderedSet
 {
 public:
   using value_type = ValueType;
-  using ContainerType = std::vector<value_type>;
+  using allocator_type = Alloc;
+  using ContainerType = std::vector<value_type, Alloc>;
   using size_type = typename ContainerType::size_type;
   using iterator = typename ContainerType::iterator;
   using const_iterator = typename ContainerType::const_iterator;
@@ -30,9 +38,17 @@ public:
   using const_reverse_iterator = typename ContainerType::const_reverse_iterator;
 
   FlatUnorderedSet() noexcept = default;
+  /// Construct an empty FlatUnorderedSet whose storage comes from alloc.
+  explicit FlatUnorderedSet(Alloc const& alloc) noexcept : container(alloc)
+  {
+  }
   FlatUnorderedSet(std::initializer_list<value_type> l) : container{l}
   {
   }
+  FlatUnorderedSet(std::initializer_list<value_type> l, Alloc const& alloc)
+    : container(l, alloc)
+  {
+  }
   FlatUnorderedSet(FlatUnorderedSet const& b) = default;
   FlatUnorderedSet(FlatUnorderedSet&& b) noexcept = default;
   ~FlatUnorderedSet() noexcept = default;
@@ -48,6 +64,16 @@ public:
   {
     return this->container.empty();
   }
+  /// Returns the allocator the values are stored with.
+  Alloc get_allocator() const noexcept
+  {
+    return this->container.get_allocator();
+  }
+  /// Returns the predicate used to compare values.
+  Comparator key_eq() const
+  {
+    return this->equals_pred;
+  }
 
   iterator begin() noexcept
   {
@@ -129,6 +155,21 @@ public:
   {
     this->container.clear();
   }
+  /** Keeps only the values for which pred(value) is true.
+   * Values are compacted in a single pass. Returns the number of removed
+   * values.
+   */
+  template <typename Pred>
+  size_type retain(Pred pred)
+  {
+    auto const last = std::remove_if(
+        this->begin(), this->end(), [&](value_type const& value) {
+          return !pred(value);
+        });
+    auto const count = static_cast<size_type>(this->end() - last);
+    this->container.erase(last, this->end());
+    return count;
+  }
 
   template <typename... Args>
   std::pair<iterator, bool> emplace(Args&&... args)
@@ -151,6 +192,31 @@ private:
   ContainerType container;
   Comparator equals_pred;
 };
+
+/** Removes the values for which pred(value) is true, in a single pass.
+ * Returns the number of removed values.
+ */
+template <typename ValueType,
+          typename Comparator,
+          typename Alloc,
+          typename Pred>
+typename FlatUnorderedSet<ValueType, Comparator, Alloc>::size_type erase_if(
+    FlatUnorderedSet<ValueType, Comparator, Alloc>& set, Pred pred)
+{
+  return set.retain([&](ValueType const& value) { return !pred(value); });
+}
+
+#ifdef KOUH_HAS_PMR
+namespace pmr
+{
+/// A FlatUnorderedSet whose storage comes from a std::pmr::memory_resource.
+template <typename ValueType, typename Comparator = std::equal_to<ValueType>>
+using FlatUnorderedSet =
+    kouh::FlatUnorderedSet<ValueType,
+                           Comparator,
+                           std::pmr::polymorphic_allocator<ValueType>>;
+}
+#endif
 }
 
 #endif /* !KOUH_FLATUNORDEREDSET_HPP_ */
@@ -0,0 +1,170 @@
+#ifndef KOUH_FLATUNORDEREDSETVIEW_HPP_
+#define KOUH_FLATUNORDEREDSETVIEW_HPP_
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <ostream>
+#include <type_traits>
+
+#include <kouh/FlatUnorderedSet.hpp>
+#include <kouh/Serialization.hpp>
+
+namespace kouh
+{
+/** Writes fus to out, in the format FlatUnorderedSetView reads.
+ *
+ * Values must be trivially copyable or std::string, and compared with
+ * std::equal_to. Throws std::runtime_error if out fails.
+ */
+template <typename ValueType, typename Comparator, typename Alloc>
+void serialize(FlatUnorderedSet<ValueType, Comparator, Alloc> const& fus,
+               std::ostream& out)
+{
+  static_assert(std::is_same<Comparator, std::equal_to<ValueType>>::value,
+                "FlatUnorderedSetView compares values with std::equal_to");
+  detail::serializeColumns<ValueType, detail::NoValue>(
+      out,
+      detail::SerializedHeader::UnorderedSet,
+      fus.begin(),
+      fus.end(),
+      [](ValueType const& value) -> ValueType const& { return value; },
+      [](ValueType const&) { return detail::NoValue{}; });
+}
+
+/** A read-only FlatUnorderedSet, served straight from a serialized one.
+ *
+ * The set counterpart of FlatMapView: the same requirements on the buffer
+ * apply. Values keep the order they had in the FlatUnorderedSet, and find
+ * scans them like FlatUnorderedSet::find does.
+ */
+template <typename ValueType>
+class FlatUnorderedSetView
+{
+  using Column = detail::SerializedColumn<ValueType>;
+
+public:
+  using value_type = ValueType;
+  using size_type = std::size_t;
+  using reference = typename Column::reference;
+  class const_iterator;
+  using iterator = const_iterator;
+
+  FlatUnorderedSetView() noexcept = default;
+  /** View the serialized FlatUnorderedSet in [data, data + size).
+   * Throws std::invalid_argument if it does not hold a FlatUnorderedSet of
+   * this type.
+   */
+  FlatUnorderedSetView(void const* data, std::size_t size)
+  {
+    auto const& header = detail::readHeader<ValueType, detail::NoValue>(
+        data, size, detail::SerializedHeader::UnorderedSet);
+    this->elementCount = static_cast<size_type>(header.count);
+    this->values = Column{static_cast<char const*>(data) + header.keyOffset,
+                          header.valueOffset - header.keyOffset,
+                          header.count};
+  }
+
+  size_type size() const noexcept
+  {
+    return this->elementCount;
+  }
+  bool empty() const noexcept
+  {
+    return this->elementCount == 0;
+  }
+
+  const_iterator begin() const noexcept
+  {
+    return const_iterator{this, 0};
+  }
+  const_iterator end() const noexcept
+  {
+    return const_iterator{this, this->elementCount};
+  }
+  const_iterator cbegin() const noexcept
+  {
+    return this->begin();
+  }
+  const_iterator cend() const noexcept
+  {
+    return this->end();
+  }
+
+  /** Find the position of val.
+   * Returns end() if no match was found.
+   */
+  const_iterator find(value_type const& val) const noexcept
+  {
+    for (size_type i = 0; i < this->elementCount; ++i)
+      if (this->values.equal(i, val))
+        return const_iterator{this, i};
+    return this->end();
+  }
+  size_type count(value_type const& val) const noexcept
+  {
+    return this->contains(val) ? 1 : 0;
+  }
+  bool contains(value_type const& val) const noexcept
+  {
+    return this->find(val) != this->end();
+  }
+
+private:
+  size_type elementCount = 0;
+  Column values;
+};
+
+/// Iterates over the values of a FlatUnorderedSetView.
+template <typename ValueType>
+class FlatUnorderedSetView<ValueType>::const_iterator
+{
+public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = ValueType;
+  using difference_type = std::ptrdiff_t;
+  using reference = typename FlatUnorderedSetView::reference;
+  using pointer = void;
+
+  const_iterator() noexcept = default;
+
+  reference operator*() const noexcept
+  {
+    return this->view->values[this->index];
+  }
+
+  const_iterator& operator++() noexcept
+  {
+    ++this->index;
+    return *this;
+  }
+  const_iterator operator++(int) noexcept
+  {
+    auto ret = *this;
+    ++*this;
+    return ret;
+  }
+
+  bool operator==(const_iterator const& rhs) const noexcept
+  {
+    return this->index == rhs.index;
+  }
+  bool operator!=(const_iterator const& rhs) const noexcept
+  {
+    return !(*this == rhs);
+  }
+
+private:
+  friend class FlatUnorderedSetView;
+
+  const_iterator(FlatUnorderedSetView const* v, size_type i) noexcept
+    : view(v), index(i)
+  {
+  }
+
+  FlatUnorderedSetView const* view = nullptr;
+  size_type index = 0;
+};
+}
+
+#endif /* !KOUH_FLATUNORDEREDSETVIEW_HPP_ */
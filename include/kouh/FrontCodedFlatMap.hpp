@@ -0,0 +1,260 @@
+#ifndef KOUH_FRONTCODEDFLATMAP_HPP_
+#define KOUH_FRONTCODEDFLATMAP_HPP_
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <kouh/FrontCodedKeys.hh>
+#include <kouh/SortedVector.hpp>
+
+namespace kouh
+{
+/** A read-only map from strings, with prefix-compressed keys.
+ *
+ * A FlatMap<std::string, V> stores one std::string per element: 32 bytes,
+ * plus a heap allocation for keys that do not fit the small string buffer,
+ * which every probe of a lookup then has to follow. Here, keys are stored
+ * back to back in a single buffer and front coded in blocks of 16 (see
+ * detail::FrontCodedKeys), and values in a vector of their own. Large sets
+ * of keys that share long prefixes, like paths or URLs, take a fraction of
+ * the memory, and a lookup touches a handful of cache lines.
+ *
+ * Keys are ordered like std::string. Lookups take either a std::string or a
+ * pointer and a length, and do not allocate.
+ *
+ * Iterators decode keys as they go. Their reference is a pair of references
+ * to the value and to the key decoded inside the iterator, which does not
+ * outlive it, so they are only input iterators, and have no operator->.
+ */
+template <typename ValueType>
+class FrontCodedFlatMap
+{
+  // Values are handed out by reference, which std::vector<bool> cannot do.
+  static_assert(!std::is_same<ValueType, bool>::value,
+                "FrontCodedFlatMap cannot hold bool values");
+
+public:
+  using key_type = std::string;
+  using mapped_type = ValueType;
+  using value_type = std::pair<std::string, ValueType>;
+  using size_type = std::size_t;
+  class const_iterator;
+  using iterator = const_iterator;
+
+  FrontCodedFlatMap() noexcept = default;
+  /** Construct from a range of pairs.
+   * With several equal keys, policy tells which one is kept.
+   */
+  template <typename InputIt>
+  FrontCodedFlatMap(InputIt first,
+                    InputIt last,
+                    DuplicatePolicy policy = DuplicatePolicy::KeepFirst)
+  {
+    std::vector<value_type> pairs(first, last);
+    detail::sortTail(
+        pairs, 0, std::less<std::string>{}, detail::PairFirst{});
+    detail::dedupSorted(
+        pairs, std::less<std::string>{}, detail::PairFirst{}, policy);
+    this->build(std::make_move_iterator(pairs.begin()),
+                std::make_move_iterator(pairs.end()));
+  }
+  /** Construct from a range of pairs sorted by key, without duplicates.
+   * Any FlatMap with string keys and the default comparator is such a range.
+   */
+  template <typename InputIt>
+  FrontCodedFlatMap(sorted_unique_t, InputIt first, InputIt last)
+  {
+    this->build(first, last);
+  }
+  FrontCodedFlatMap(FrontCodedFlatMap const& b) = default;
+  FrontCodedFlatMap(FrontCodedFlatMap&& b) noexcept = default;
+  ~FrontCodedFlatMap() noexcept = default;
+
+  FrontCodedFlatMap& operator=(FrontCodedFlatMap const& rhs) = default;
+  FrontCodedFlatMap& operator=(FrontCodedFlatMap&& rhs) noexcept = default;
+
+  /// Returns the number of elements in the FrontCodedFlatMap.
+  size_type size() const noexcept
+  {
+    return this->values.size();
+  }
+  /// Returns true if there are no elements in the FrontCodedFlatMap.
+  bool empty() const noexcept
+  {
+    return this->values.empty();
+  }
+  /// Returns the number of bytes used by the keys.
+  size_type keyStorageSize() const noexcept
+  {
+    return this->keys.storageSize();
+  }
+
+  const_iterator begin() const
+  {
+    return const_iterator{this, 0};
+  }
+  const_iterator end() const noexcept
+  {
+    return const_iterator{this};
+  }
+  const_iterator cbegin() const
+  {
+    return this->begin();
+  }
+  const_iterator cend() const noexcept
+  {
+    return this->end();
+  }
+
+  /** Find the position of the value for given key.
+   * Returns end() if no match was found.
+   */
+  const_iterator find(std::string const& key) const
+  {
+    return this->find(key.data(), key.size());
+  }
+  const_iterator find(char const* key, size_type length) const
+  {
+    auto const index = this->keys.find(key, length);
+    if (index == this->size())
+      return this->end();
+    return const_iterator{this, index};
+  }
+  /// Returns 1 if key is in the FrontCodedFlatMap, 0 otherwise.
+  size_type count(std::string const& key) const noexcept
+  {
+    return this->contains(key) ? 1 : 0;
+  }
+  /// Returns true if key is in the FrontCodedFlatMap, false otherwise.
+  bool contains(std::string const& key) const noexcept
+  {
+    return this->contains(key.data(), key.size());
+  }
+  bool contains(char const* key, size_type length) const noexcept
+  {
+    return this->keys.find(key, length) != this->size();
+  }
+  ValueType const& at(std::string const& key) const
+  {
+    return this->at(key.data(), key.size());
+  }
+  ValueType const& at(char const* key, size_type length) const
+  {
+    auto const index = this->keys.find(key, length);
+    if (index != this->size())
+      return this->values[index];
+    throw std::out_of_range("Invalid access at FrontCodedFlatMap::at const");
+  }
+
+private:
+  /// Values are moved from the range if it yields rvalues.
+  template <typename InputIt>
+  void build(InputIt first, InputIt last)
+  {
+    std::string previous;
+    for (; first != last; ++first)
+    {
+      auto&& pair = *first;
+      std::string const& key = pair.first;
+      this->keys.append(previous, key.data(), key.size());
+      this->values.push_back(std::forward<decltype(pair)>(pair).second);
+      previous = key;
+    }
+    this->keys.shrink_to_fit();
+    this->values.shrink_to_fit();
+  }
+
+  detail::FrontCodedKeys keys;
+  std::vector<ValueType> values;
+};
+
+/** Iterates over the elements of a FrontCodedFlatMap, in key order.
+ * Holds the decoded key of the element it points to.
+ */
+template <typename ValueType>
+class FrontCodedFlatMap<ValueType>::const_iterator
+{
+public:
+  using iterator_category = std::input_iterator_tag;
+  using value_type = typename FrontCodedFlatMap::value_type;
+  using difference_type = std::ptrdiff_t;
+  using reference = std::pair<std::string const&, ValueType const&>;
+  using pointer = void;
+
+  const_iterator() noexcept = default;
+
+  reference operator*() const noexcept
+  {
+    return {this->key, this->map->values[this->index]};
+  }
+
+  const_iterator& operator++()
+  {
+    ++this->index;
+    if (this->index < this->map->size())
+      this->decodeNext();
+    return *this;
+  }
+  const_iterator operator++(int)
+  {
+    auto ret = *this;
+    ++*this;
+    return ret;
+  }
+
+  bool operator==(const_iterator const& rhs) const noexcept
+  {
+    return this->index == rhs.index;
+  }
+  bool operator!=(const_iterator const& rhs) const noexcept
+  {
+    return !(*this == rhs);
+  }
+
+private:
+  friend class FrontCodedFlatMap;
+
+  /// The end iterator.
+  explicit const_iterator(FrontCodedFlatMap const* m) noexcept
+    : map(m), index(m->size())
+  {
+  }
+  /// Points to the element at given index, decoding its block up to it.
+  const_iterator(FrontCodedFlatMap const* m, size_type i) : map(m), index(i)
+  {
+    if (i >= m->size())
+      return;
+    auto const block = i / detail::FrontCodedKeys::BLOCK_SIZE;
+    this->index = block * detail::FrontCodedKeys::BLOCK_SIZE;
+    this->offset = m->keys.restart(block);
+    this->decodeNext();
+    while (this->index < i)
+    {
+      ++this->index;
+      this->decodeNext();
+    }
+  }
+
+  void decodeNext()
+  {
+    this->offset = this->map->keys.decode(
+        this->offset,
+        this->index % detail::FrontCodedKeys::BLOCK_SIZE == 0,
+        this->key);
+  }
+
+  FrontCodedFlatMap const* map = nullptr;
+  size_type index = 0;
+  /// Offset of the key after the current one.
+  size_type offset = 0;
+  std::string key;
+};
+}
+
+#endif /* !KOUH_FRONTCODEDFLATMAP_HPP_ */
@@ -0,0 +1,238 @@
+#ifndef KOUH_FRONTCODEDKEYS_HH_
+#define KOUH_FRONTCODEDKEYS_HH_
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <kouh/Prefetch.hh>
+
+namespace kouh
+{
+namespace detail
+{
+/** Sorted strings, stored contiguously with front coding.
+ *
+ * Keys are grouped in blocks of BLOCK_SIZE. The first key of a block, its
+ * restart point, is stored whole; each other key only stores the length of
+ * the prefix it shares with the key before it and the rest of its bytes.
+ * Lengths are varints, so a key costs its unshared bytes plus about two
+ * bytes.
+ *
+ * A lookup binary searches the restart points, then scans one block. The
+ * scan compares each key to the searched one without decoding it: it only
+ * tracks how many bytes of the searched key the previous key matched.
+ *
+ * Keys are ordered like std::string, by unsigned bytes.
+ */
+class FrontCodedKeys
+{
+public:
+  /// Number of keys in a block.
+  static constexpr std::size_t BLOCK_SIZE = 16;
+
+  FrontCodedKeys() noexcept = default;
+
+  /// Returns the number of keys.
+  std::size_t size() const noexcept
+  {
+    return this->keyCount;
+  }
+
+  /// Returns the number of bytes used by the keys.
+  std::size_t storageSize() const noexcept
+  {
+    return this->data.capacity() +
+           this->restarts.capacity() * sizeof(std::size_t);
+  }
+
+  /** Appends a key, which must be greater than the last one.
+   * previous is the last key appended, and is ignored for the first one.
+   */
+  void append(std::string const& previous, char const* key, std::size_t length)
+  {
+    if (this->keyCount % BLOCK_SIZE == 0)
+    {
+      this->restarts.push_back(this->data.size());
+      this->appendVarint(length);
+      this->data.insert(this->data.end(), key, key + length);
+    }
+    else
+    {
+      assert(compare(previous.data(), previous.size(), key, length) < 0);
+      auto const shared = commonPrefix(
+          previous.data(), previous.size(), key, length);
+      this->appendVarint(shared);
+      this->appendVarint(length - shared);
+      this->data.insert(this->data.end(), key + shared, key + length);
+    }
+    ++this->keyCount;
+  }
+
+  /// Frees unused capacity, once all keys are appended.
+  void shrink_to_fit()
+  {
+    this->data.shrink_to_fit();
+    this->restarts.shrink_to_fit();
+  }
+
+  /// Returns the index of key, or size() if it is not there.
+  std::size_t find(char const* key, std::size_t length) const noexcept
+  {
+    auto const block = this->findBlock(key, length);
+    if (block == this->restarts.size())
+      return this->keyCount;
+    auto index = block * BLOCK_SIZE;
+    auto const blockEnd = index + BLOCK_SIZE < this->keyCount
+                              ? index + BLOCK_SIZE
+                              : this->keyCount;
+    char const* p = this->data.data() + this->restarts[block];
+    auto const firstLength = readVarint(p);
+    // Number of bytes of key the current key shares with it.
+    auto match = commonPrefix(p, firstLength, key, length);
+    p += firstLength;
+    if (match == firstLength && match == length)
+      return index;
+    // From here on, the current key is known to be less than key.
+    for (++index; index < blockEnd; ++index)
+    {
+      auto const shared = readVarint(p);
+      auto const suffixLength = readVarint(p);
+      char const* suffix = p;
+      p += suffixLength;
+      // Shares more with the previous key than key does: still less than key.
+      if (shared > match)
+        continue;
+      // Differs from the previous key where it matched key: greater than key.
+      if (shared < match)
+        return this->keyCount;
+      auto const common =
+          commonPrefix(suffix, suffixLength, key + match, length - match);
+      match += common;
+      if (common == suffixLength)
+      {
+        if (match == length)
+          return index;
+        continue;
+      }
+      if (match == length || !lessByte(suffix[common], key[match]))
+        return this->keyCount;
+    }
+    return this->keyCount;
+  }
+
+  /** Decodes the key at given offset into key.
+   * isRestart tells whether it is the first key of a block. Returns the offset
+   * of the next key.
+   */
+  std::size_t decode(std::size_t offset, bool isRestart, std::string& key) const
+  {
+    char const* p = this->data.data() + offset;
+    std::size_t shared = 0;
+    if (!isRestart)
+      shared = readVarint(p);
+    auto const suffixLength = readVarint(p);
+    key.resize(shared);
+    key.append(p, suffixLength);
+    return static_cast<std::size_t>(p + suffixLength - this->data.data());
+  }
+
+  /// Returns the offset of the first key of given block.
+  std::size_t restart(std::size_t block) const noexcept
+  {
+    return this->restarts[block];
+  }
+
+private:
+  static bool lessByte(char a, char b) noexcept
+  {
+    return static_cast<unsigned char>(a) < static_cast<unsigned char>(b);
+  }
+
+  static std::size_t commonPrefix(char const* a,
+                                  std::size_t aLength,
+                                  char const* b,
+                                  std::size_t bLength) noexcept
+  {
+    auto const length = aLength < bLength ? aLength : bLength;
+    std::size_t i = 0;
+    while (i < length && a[i] == b[i])
+      ++i;
+    return i;
+  }
+
+  /// Compares like std::string::compare.
+  static int compare(char const* a,
+                     std::size_t aLength,
+                     char const* b,
+                     std::size_t bLength) noexcept
+  {
+    auto const length = aLength < bLength ? aLength : bLength;
+    if (length > 0)
+    {
+      auto const cmp = std::memcmp(a, b, length);
+      if (cmp != 0)
+        return cmp;
+    }
+    return aLength < bLength ? -1 : (aLength > bLength ? 1 : 0);
+  }
+
+  static std::size_t readVarint(char const*& p) noexcept
+  {
+    std::size_t value = 0;
+    for (unsigned shift = 0;; shift += 7)
+    {
+      auto const byte = static_cast<unsigned char>(*p++);
+      value |= static_cast<std::size_t>(byte & 0x7fu) << shift;
+      if (byte < 0x80u)
+        return value;
+    }
+  }
+
+  void appendVarint(std::size_t value)
+  {
+    while (value >= 0x80u)
+    {
+      this->data.push_back(static_cast<char>((value & 0x7fu) | 0x80u));
+      value >>= 7;
+    }
+    this->data.push_back(static_cast<char>(value));
+  }
+
+  /// Returns the last block whose first key is not greater than key.
+  /// Returns the number of blocks if there is none.
+  std::size_t findBlock(char const* key, std::size_t length) const noexcept
+  {
+    // Binary search for the first block whose first key is greater than key.
+    std::size_t first = 0;
+    std::size_t count = this->restarts.size();
+    while (count > 0)
+    {
+      auto const half = count / 2;
+      prefetch(this->restarts.data() + first, half / 2);
+      prefetch(this->restarts.data() + first, half + half / 2);
+      char const* p = this->data.data() + this->restarts[first + half];
+      auto const keyLength = readVarint(p);
+      if (compare(p, keyLength, key, length) <= 0)
+      {
+        first += half + 1;
+        count -= half + 1;
+      }
+      else
+        count = half;
+    }
+    return first == 0 ? this->restarts.size() : first - 1;
+  }
+
+  /// Front coded keys.
+  std::vector<char> data;
+  /// Offsets of the first key of each block in data.
+  std::vector<std::size_t> restarts;
+  std::size_t keyCount = 0;
+};
+}
+}
+
+#endif /* !KOUH_FRONTCODEDKEYS_HH_ */
@@ -0,0 +1,196 @@
+#ifndef KOUH_FROZENFLATMAP_HPP_
+#define KOUH_FROZENFLATMAP_HPP_
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+
+namespace kouh
+{
+namespace detail
+{
+/// Positions of the elements of an array, in key order.
+template <std::size_t N>
+struct FrozenOrder
+{
+  std::size_t index[N];
+};
+
+/** Sorts the positions of pairs by key, and checks keys are unique.
+ * Evaluated at compile time, a duplicate key fails the compilation.
+ */
+template <typename PairType, std::size_t N, typename Comp>
+constexpr FrozenOrder<N> frozenOrder(std::array<PairType, N> const& pairs,
+                                     Comp const& comp)
+{
+  FrozenOrder<N> order{};
+  for (std::size_t i = 0; i < N; ++i)
+    order.index[i] = i;
+  // Insertion sort: tables are small and this is cheap on the compiler.
+  for (std::size_t i = 1; i < N; ++i)
+  {
+    for (std::size_t j = i; j > 0; --j)
+    {
+      auto const prev = order.index[j - 1];
+      auto const cur = order.index[j];
+      if (!comp(pairs[cur].first, pairs[prev].first))
+        break;
+      order.index[j - 1] = cur;
+      order.index[j] = prev;
+    }
+  }
+  for (std::size_t i = 1; i < N; ++i)
+    if (!comp(pairs[order.index[i - 1]].first, pairs[order.index[i]].first))
+      throw std::logic_error("Duplicate key in FrozenFlatMap");
+  return order;
+}
+}
+
+/** An immutable FlatMap, built at compile time.
+ *
+ * The FrozenFlatMap holds exactly N elements, sorted by key when it is
+ * constructed. When declared constexpr, the sort happens in the compiler, a
+ * duplicate key is a compilation error and the map lives in read-only data:
+ * static lookup tables cost neither startup time nor a heap allocation.
+ *
+ * Lookups are constexpr as well, and behave like those of FlatMap.
+ */
+template <typename KeyType,
+          typename ValueType,
+          std::size_t N,
+          typename Comp = std::less<KeyType>>
+class FrozenFlatMap
+{
+  static_assert(N > 0, "A FrozenFlatMap needs at least one element");
+
+public:
+  using PairType = std::pair<KeyType, ValueType>;
+  using value_type = PairType;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using iterator = PairType const*;
+  using const_iterator = PairType const*;
+
+  /** Construct from unsorted pairs.
+   * Throws std::logic_error if two pairs have the same key.
+   */
+  constexpr explicit FrozenFlatMap(std::array<PairType, N> const& pairs,
+                                   Comp const& cmp = Comp{})
+    : FrozenFlatMap(pairs,
+                    detail::frozenOrder(pairs, cmp),
+                    cmp,
+                    std::make_index_sequence<N>{})
+  {
+  }
+
+  /// Returns the number of elements in the FrozenFlatMap.
+  constexpr size_type size() const noexcept
+  {
+    return N;
+  }
+  constexpr bool empty() const noexcept
+  {
+    return false;
+  }
+
+  constexpr const_iterator begin() const noexcept
+  {
+    return this->values;
+  }
+  constexpr const_iterator end() const noexcept
+  {
+    return this->values + N;
+  }
+  constexpr const_iterator cbegin() const noexcept
+  {
+    return this->values;
+  }
+  constexpr const_iterator cend() const noexcept
+  {
+    return this->values + N;
+  }
+
+  /// Returns the comparator used to order keys.
+  constexpr Comp key_comp() const
+  {
+    return this->comp;
+  }
+
+  /** Find the position of the value for given key.
+   * Returns end() if no match was found.
+   */
+  constexpr const_iterator find(KeyType const& key) const noexcept
+  {
+    auto const it = this->lower_bound(key);
+    if (it != this->end() && !this->comp(key, it->first))
+      return it;
+    return this->end();
+  }
+  /// Returns 1 if key is in the FrozenFlatMap, 0 otherwise.
+  constexpr size_type count(KeyType const& key) const noexcept
+  {
+    return this->contains(key) ? 1 : 0;
+  }
+  /// Returns true if key is in the FrozenFlatMap, false otherwise.
+  constexpr bool contains(KeyType const& key) const noexcept
+  {
+    return this->find(key) != this->end();
+  }
+  constexpr ValueType const& at(KeyType const& key) const
+  {
+    auto const it = this->find(key);
+    if (it == this->end())
+      throw std::out_of_range("Invalid access at FrozenFlatMap::at const");
+    return it->second;
+  }
+  /// Returns an iterator to the first element whose key is not less than key.
+  constexpr const_iterator lower_bound(KeyType const& key) const noexcept
+  {
+    const_iterator first = this->values;
+    size_type length = N;
+    while (length > 0)
+    {
+      auto const half = length / 2;
+      if (this->comp(first[half].first, key))
+      {
+        first += half + 1;
+        length -= half + 1;
+      }
+      else
+        length = half;
+    }
+    return first;
+  }
+
+private:
+  template <std::size_t... I>
+  constexpr FrozenFlatMap(std::array<PairType, N> const& pairs,
+                          detail::FrozenOrder<N> const& order,
+                          Comp const& cmp,
+                          std::index_sequence<I...>)
+    : values{pairs[order.index[I]]...}, comp(cmp)
+  {
+  }
+
+  PairType values[N];
+  Comp comp;
+};
+
+/** Builds a FrozenFlatMap from unsorted pairs, deducing its size.
+ * Throws std::logic_error if two pairs have the same key.
+ */
+template <typename KeyType,
+          typename ValueType,
+          std::size_t N,
+          typename Comp = std::less<KeyType>>
+constexpr FrozenFlatMap<KeyType, ValueType, N, Comp> makeFrozenFlatMap(
+    std::array<std::pair<KeyType, ValueType>, N> const& pairs,
+    Comp const& comp = Comp{})
+{
+  return FrozenFlatMap<KeyType, ValueType, N, Comp>{pairs, comp};
+}
+}
+
+#endif /* !KOUH_FROZENFLATMAP_HPP_ */
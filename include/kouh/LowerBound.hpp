@@ -0,0 +1,293 @@
+#ifndef KOUH_LOWERBOUND_HPP_
+#define KOUH_LOWERBOUND_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+
+#include <kouh/Prefetch.hh>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace kouh
+{
+namespace detail
+{
+/** Size of the window the branchless binary search narrows down to before
+ * counting the remaining keys linearly.
+ */
+constexpr std::size_t LOWER_BOUND_WINDOW = 16;
+
+/// Projects an element onto itself.
+struct Identity
+{
+  template <typename T>
+  T const& operator()(T const& value) const noexcept
+  {
+    return value;
+  }
+};
+
+/// Projects a pair onto its key.
+struct PairFirst
+{
+  template <typename Pair>
+  auto operator()(Pair const& pair) const noexcept -> decltype((pair.first))
+  {
+    return pair.first;
+  }
+};
+
+/** Number of elements of [data, data + n) that are less than key.
+ *
+ * Overloaded below with SIMD versions for the types the instruction set
+ * supports.
+ */
+template <typename T>
+inline std::size_t countLessContiguous(T const* data,
+                                       std::size_t n,
+                                       T key) noexcept
+{
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < n; ++i)
+    count += data[i] < key;
+  return count;
+}
+
+#if defined(__SSE2__)
+inline std::size_t popcount(int mask) noexcept
+{
+  return static_cast<std::size_t>(
+      __builtin_popcount(static_cast<unsigned int>(mask)));
+}
+
+/** SIMD counting of 32 bit signed integers.
+ *
+ * `bias` is xor-ed on every value before comparing, which turns the
+ * signed comparison into an unsigned one when set to the sign bit.
+ */
+inline std::size_t countLessInt32(std::int32_t const* data,
+                                  std::size_t n,
+                                  std::int32_t key,
+                                  std::int32_t bias) noexcept
+{
+  std::size_t count = 0;
+  std::size_t i = 0;
+#if defined(__AVX2__)
+  auto const bias8 = _mm256_set1_epi32(bias);
+  auto const key8 = _mm256_xor_si256(_mm256_set1_epi32(key), bias8);
+  for (; i + 8 <= n; i += 8)
+  {
+    auto const values = _mm256_xor_si256(
+        _mm256_loadu_si256(reinterpret_cast<__m256i const*>(data + i)),
+        bias8);
+    auto const less = _mm256_cmpgt_epi32(key8, values);
+    count += popcount(_mm256_movemask_ps(_mm256_castsi256_ps(less)));
+  }
+#endif
+  auto const bias4 = _mm_set1_epi32(bias);
+  auto const key4 = _mm_xor_si128(_mm_set1_epi32(key), bias4);
+  for (; i + 4 <= n; i += 4)
+  {
+    auto const values = _mm_xor_si128(
+        _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + i)), bias4);
+    auto const less = _mm_cmpgt_epi32(key4, values);
+    count += popcount(_mm_movemask_ps(_mm_castsi128_ps(less)));
+  }
+  for (; i < n; ++i)
+    count += (data[i] ^ bias) < (key ^ bias);
+  return count;
+}
+
+inline std::size_t countLessContiguous(std::int32_t const* data,
+                                       std::size_t n,
+                                       std::int32_t key) noexcept
+{
+  return countLessInt32(data, n, key, 0);
+}
+
+inline std::size_t countLessContiguous(std::uint32_t const* data,
+                                       std::size_t n,
+                                       std::uint32_t key) noexcept
+{
+  return countLessInt32(reinterpret_cast<std::int32_t const*>(data),
+                        n,
+                        static_cast<std::int32_t>(key),
+                        INT32_MIN);
+}
+
+inline std::size_t countLessContiguous(float const* data,
+                                       std::size_t n,
+                                       float key) noexcept
+{
+  std::size_t count = 0;
+  std::size_t i = 0;
+#if defined(__AVX2__)
+  auto const key8 = _mm256_set1_ps(key);
+  for (; i + 8 <= n; i += 8)
+  {
+    auto const less =
+        _mm256_cmp_ps(_mm256_loadu_ps(data + i), key8, _CMP_LT_OQ);
+    count += popcount(_mm256_movemask_ps(less));
+  }
+#endif
+  auto const key4 = _mm_set1_ps(key);
+  for (; i + 4 <= n; i += 4)
+  {
+    auto const less = _mm_cmplt_ps(_mm_loadu_ps(data + i), key4);
+    count += popcount(_mm_movemask_ps(less));
+  }
+  for (; i < n; ++i)
+    count += data[i] < key;
+  return count;
+}
+
+inline std::size_t countLessContiguous(double const* data,
+                                       std::size_t n,
+                                       double key) noexcept
+{
+  std::size_t count = 0;
+  std::size_t i = 0;
+#if defined(__AVX2__)
+  auto const key4 = _mm256_set1_pd(key);
+  for (; i + 4 <= n; i += 4)
+  {
+    auto const less =
+        _mm256_cmp_pd(_mm256_loadu_pd(data + i), key4, _CMP_LT_OQ);
+    count += popcount(_mm256_movemask_pd(less));
+  }
+#endif
+  auto const key2 = _mm_set1_pd(key);
+  for (; i + 2 <= n; i += 2)
+  {
+    auto const less = _mm_cmplt_pd(_mm_loadu_pd(data + i), key2);
+    count += popcount(_mm_movemask_pd(less));
+  }
+  for (; i < n; ++i)
+    count += data[i] < key;
+  return count;
+}
+
+#if defined(__AVX2__)
+/// SIMD counting of 64 bit integers. See countLessInt32.
+inline std::size_t countLessInt64(std::int64_t const* data,
+                                  std::size_t n,
+                                  std::int64_t key,
+                                  std::int64_t bias) noexcept
+{
+  std::size_t count = 0;
+  std::size_t i = 0;
+  auto const bias4 = _mm256_set1_epi64x(bias);
+  auto const key4 = _mm256_xor_si256(_mm256_set1_epi64x(key), bias4);
+  for (; i + 4 <= n; i += 4)
+  {
+    auto const values = _mm256_xor_si256(
+        _mm256_loadu_si256(reinterpret_cast<__m256i const*>(data + i)),
+        bias4);
+    auto const less = _mm256_cmpgt_epi64(key4, values);
+    count += popcount(_mm256_movemask_pd(_mm256_castsi256_pd(less)));
+  }
+  for (; i < n; ++i)
+    count += (data[i] ^ bias) < (key ^ bias);
+  return count;
+}
+
+inline std::size_t countLessContiguous(std::int64_t const* data,
+                                       std::size_t n,
+                                       std::int64_t key) noexcept
+{
+  return countLessInt64(data, n, key, 0);
+}
+
+inline std::size_t countLessContiguous(std::uint64_t const* data,
+                                       std::size_t n,
+                                       std::uint64_t key) noexcept
+{
+  return countLessInt64(reinterpret_cast<std::int64_t const*>(data),
+                        n,
+                        static_cast<std::int64_t>(key),
+                        INT64_MIN);
+}
+#endif
+#endif
+
+/// Number of elements in [first, first + n) whose projection is below key.
+template <typename It, typename T, typename Proj>
+inline std::size_t countLess(It first,
+                             std::size_t n,
+                             T key,
+                             Proj proj) noexcept
+{
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < n; ++i)
+    count += proj(first[static_cast<std::ptrdiff_t>(i)]) < key;
+  return count;
+}
+
+/// Contiguous keys can use the SIMD versions.
+template <typename T>
+inline std::size_t countLess(T const* first,
+                             std::size_t n,
+                             T key,
+                             Identity) noexcept
+{
+  return countLessContiguous(first, n, key);
+}
+
+/** Generic lower bound over a sorted range of elements.
+ *
+ * `proj` maps an element to the key it is sorted on.
+ */
+template <typename It, typename Key, typename Comp, typename Proj>
+inline It lowerBound(It first,
+                     It last,
+                     Key const& key,
+                     Comp const& comp,
+                     Proj proj) noexcept
+{
+  using Element = typename std::iterator_traits<It>::value_type;
+  return std::lower_bound(
+      first, last, key, [&](Element const& element, Key const& keyp) {
+        return comp(proj(element), keyp);
+      });
+}
+
+/** Lower bound for arithmetic keys sorted with std::less.
+ *
+ * Halves the range without branching on the comparison, which the compiler
+ * turns into a conditional move, and prefetches both possible next probes to
+ * make up for the lost speculation. Once the range fits in a small window, the
+ * keys less than `key` are counted, which is the offset of the lower bound
+ * in the window. Counting is done with SIMD when the keys are contiguous.
+ */
+template <typename It, typename T, typename Proj>
+inline typename std::enable_if<std::is_arithmetic<T>::value, It>::type
+lowerBound(It first,
+           It last,
+           T const& key,
+           std::less<T> const&,
+           Proj proj) noexcept
+{
+  auto n = static_cast<std::size_t>(last - first);
+  while (n > LOWER_BOUND_WINDOW)
+  {
+    auto const half = n / 2;
+    auto const offset = static_cast<std::ptrdiff_t>(half);
+    // Both candidates for the next probe, so that the load is already in
+    // flight whichever way we go.
+    prefetch(&*first, half / 2);
+    prefetch(&*first, half + half / 2);
+    first += proj(first[offset]) < key ? offset : 0;
+    n -= half;
+  }
+  return first + static_cast<std::ptrdiff_t>(countLess(first, n, key, proj));
+}
+}
+}
+
+#endif /* !KOUH_LOWERBOUND_HPP_ */
@@ -0,0 +1,94 @@
+#ifndef KOUH_MAPPEDFILE_HH_
+#define KOUH_MAPPEDFILE_HH_
+
+#include <cerrno>
+#include <cstddef>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace kouh
+{
+/** A read-only memory mapping of a whole file.
+ *
+ * Pages are loaded on first access and shared with every other process that
+ * maps the same file. Meant to back FlatMapView and FlatUnorderedSetView,
+ * which must not outlive it. POSIX only.
+ */
+class MappedFile
+{
+public:
+  MappedFile() noexcept = default;
+  /// Maps the file at path. Throws std::system_error on failure.
+  explicit MappedFile(std::string const& path)
+  {
+    auto const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+      throw std::system_error(errno, std::generic_category(), path);
+    struct stat status;
+    if (::fstat(fd, &status) < 0)
+      fail(fd, path);
+    this->length = static_cast<std::size_t>(status.st_size);
+    // mmap refuses empty mappings: an empty file maps to no memory.
+    if (this->length > 0)
+    {
+      auto const mapping =
+          ::mmap(nullptr, this->length, PROT_READ, MAP_SHARED, fd, 0);
+      if (mapping == MAP_FAILED)
+        fail(fd, path);
+      this->address = mapping;
+    }
+    ::close(fd);
+  }
+  MappedFile(MappedFile const& b) = delete;
+  MappedFile(MappedFile&& b) noexcept
+    : address(b.address), length(b.length)
+  {
+    b.address = nullptr;
+    b.length = 0;
+  }
+  ~MappedFile() noexcept
+  {
+    if (this->address != nullptr)
+      ::munmap(this->address, this->length);
+  }
+
+  MappedFile& operator=(MappedFile const& rhs) = delete;
+  MappedFile& operator=(MappedFile&& rhs) noexcept
+  {
+    MappedFile tmp{std::move(rhs)};
+    std::swap(this->address, tmp.address);
+    std::swap(this->length, tmp.length);
+    return *this;
+  }
+
+  /// Returns the first byte of the file, aligned to a page.
+  void const* data() const noexcept
+  {
+    return this->address;
+  }
+  /// Returns the size of the file.
+  std::size_t size() const noexcept
+  {
+    return this->length;
+  }
+
+private:
+  [[noreturn]] static void fail(int fd, std::string const& path)
+  {
+    auto const error = errno;
+    ::close(fd);
+    throw std::system_error(error, std::generic_category(), path);
+  }
+
+  void* address = nullptr;
+  std::size_t length = 0;
+};
+}
+
+#endif /* !KOUH_MAPPEDFILE_HH_ */
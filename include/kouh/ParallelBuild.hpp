@@ -0,0 +1,123 @@
+#ifndef KOUH_PARALLELBUILD_HPP_
+#define KOUH_PARALLELBUILD_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+/** Number of elements from which bulk builds sort and deduplicate on several
+ * threads. Define it to a larger value than any container to disable them.
+ */
+#ifndef KOUH_PARALLEL_BUILD_THRESHOLD
+#define KOUH_PARALLEL_BUILD_THRESHOLD (std::size_t{1} << 17)
+#endif
+
+/* Define KOUH_BUILD_THREADS to fix the number of threads of bulk builds.
+ * It defaults to std::thread::hardware_concurrency().
+ */
+
+namespace kouh
+{
+namespace detail
+{
+constexpr std::size_t PARALLEL_BUILD_THRESHOLD = KOUH_PARALLEL_BUILD_THRESHOLD;
+
+/** Returns the number of threads to work on n elements with.
+ * Each thread gets at least half the threshold, below which starting it
+ * costs more than it saves.
+ */
+inline std::size_t buildThreads(std::size_t n) noexcept
+{
+  if (n < PARALLEL_BUILD_THRESHOLD)
+    return 1;
+#ifdef KOUH_BUILD_THREADS
+  std::size_t const threads = KOUH_BUILD_THREADS;
+#else
+  std::size_t const threads = std::thread::hardware_concurrency();
+#endif
+  auto const most = n / (PARALLEL_BUILD_THRESHOLD / 2);
+  return std::max(std::size_t{1}, std::min(threads, most));
+}
+
+/** Runs f(0), ..., f(count - 1), each on its own thread.
+ * The calling thread runs f(0), and whatever could not be given a thread.
+ * Rethrows the first exception f threw, once all calls are done.
+ */
+template <typename F>
+void parallelFor(std::size_t count, F const& f)
+{
+  std::vector<std::exception_ptr> errors(count);
+  auto const run = [&](std::size_t i) {
+    try
+    {
+      f(i);
+    }
+    catch (...)
+    {
+      errors[i] = std::current_exception();
+    }
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(count);
+  std::size_t i = 1;
+  try
+  {
+    for (; i < count; ++i)
+      threads.emplace_back(run, i);
+  }
+  catch (std::system_error const&)
+  {
+    // Out of threads: the rest runs here.
+  }
+  for (; i < count; ++i)
+    run(i);
+  run(0);
+  for (auto& thread : threads)
+    thread.join();
+  for (auto const& error : errors)
+    if (error)
+      std::rethrow_exception(error);
+}
+
+/** std::stable_sort, on buildThreads(last - first) threads.
+ *
+ * Each thread sorts a chunk, then neighbouring chunks are merged in pairs,
+ * in parallel, until one is left. Merges keep the elements of the left chunk
+ * first, so the sort stays stable.
+ */
+template <typename It, typename Less>
+void parallelStableSort(It first, It last, Less const& less)
+{
+  auto const n = static_cast<std::size_t>(last - first);
+  auto const chunks = buildThreads(n);
+  if (chunks <= 1)
+  {
+    std::stable_sort(first, last, less);
+    return;
+  }
+  std::vector<It> bounds;
+  bounds.reserve(chunks + 1);
+  for (std::size_t i = 0; i <= chunks; ++i)
+    bounds.push_back(first + static_cast<std::ptrdiff_t>(n * i / chunks));
+
+  parallelFor(chunks, [&](std::size_t i) {
+    std::stable_sort(bounds[i], bounds[i + 1], less);
+  });
+  for (std::size_t width = 1; width < chunks; width *= 2)
+  {
+    parallelFor((chunks + 2 * width - 1) / (2 * width), [&](std::size_t i) {
+      auto const low = 2 * width * i;
+      auto const middle = low + width;
+      auto const high = std::min(low + 2 * width, chunks);
+      if (middle < high)
+        std::inplace_merge(bounds[low], bounds[middle], bounds[high], less);
+    });
+  }
+}
+}
+}
+
+#endif /* !KOUH_PARALLELBUILD_HPP_ */
@@ -0,0 +1,265 @@
+#ifndef KOUH_PERFECTHASH_HH_
+#define KOUH_PERFECTHASH_HH_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace kouh
+{
+namespace detail
+{
+/** A minimal perfect hash over a fixed set of hash values.
+ *
+ * Built with hash-and-displace (CHD): hashes are spread over buckets of about
+ * BUCKET_LOAD hashes each. Buckets are placed largest first, each one trying
+ * displacements until all its hashes land in free slots. Lookups then cost
+ * one displacement load and a hash mix, and map the m distinct hashes it was
+ * built with onto [0, m) without collision.
+ *
+ * Keys may share a hash, with a weak hash or a 32 bits size_t. The first key
+ * with a given hash takes its slot, and the others go to overflow positions
+ * after the m slots. They are looked up by hash, in a sorted array that is
+ * empty unless such keys exist.
+ *
+ * Hashes not in the set map to an arbitrary slot; callers compare the key
+ * they find there.
+ */
+class PerfectHashIndex
+{
+public:
+  /// Average number of hashes per bucket.
+  static constexpr std::size_t BUCKET_LOAD = 4;
+  /// Displacements tried for a bucket before trying another seed.
+  static constexpr std::uint32_t MAX_DISPLACEMENT = 1u << 20;
+  /// Seeds tried before giving up.
+  static constexpr std::uint64_t MAX_SEED = 16;
+  /// Returned by find when no position matches.
+  static constexpr std::size_t NOT_FOUND =
+      std::numeric_limits<std::size_t>::max();
+
+  PerfectHashIndex() noexcept = default;
+
+  /** Builds the index over hashes, which may contain equal values.
+   * Returns, for each position, the index in hashes of the element to store
+   * there: first the element of each slot, then the overflow.
+   */
+  std::vector<std::size_t> build(std::vector<std::size_t> const& hashes)
+  {
+    assert(hashes.size() <= std::numeric_limits<std::uint32_t>::max());
+    this->displacements.clear();
+    this->overflow.clear();
+    this->slotCount = 0;
+    if (hashes.empty())
+      return {};
+    std::vector<std::uint32_t> slots(hashes.size());
+    for (this->seed = 0; this->seed < MAX_SEED; ++this->seed)
+    {
+      if (!this->tryBuild(hashes, slots))
+        continue;
+      std::vector<std::size_t> order(this->slotCount, std::size_t{NOT_FOUND});
+      for (std::size_t i = 0; i < hashes.size(); ++i)
+      {
+        if (order[slots[i]] == NOT_FOUND)
+          order[slots[i]] = i;
+        else
+        {
+          this->overflow.emplace_back(hashes[i], order.size());
+          order.push_back(i);
+        }
+      }
+      std::sort(this->overflow.begin(), this->overflow.end());
+      return order;
+    }
+    throw std::runtime_error("Could not build a perfect hash");
+  }
+
+  /// Returns the slot of given hash.
+  std::size_t slot(std::size_t hash) const noexcept
+  {
+    auto const x = mix(hash ^ this->seed);
+    auto const d = this->displacements[this->bucket(x)];
+    return reduce(mix(x ^ displacementKey(d)), this->slotCount);
+  }
+  /** Returns the position with given hash for which match(position) is true,
+   * or NOT_FOUND. The index must not be empty.
+   */
+  template <typename Match>
+  std::size_t find(std::size_t hash, Match match) const
+  {
+    auto const s = this->slot(hash);
+    if (match(s))
+      return s;
+    if (this->overflow.empty())
+      return NOT_FOUND;
+    auto it = std::lower_bound(this->overflow.begin(),
+                               this->overflow.end(),
+                               std::make_pair(hash, std::size_t{0}));
+    for (; it != this->overflow.end() && it->first == hash; ++it)
+      if (match(it->second))
+        return it->second;
+    return NOT_FOUND;
+  }
+
+  /// Returns the number of slots, which is the number of distinct hashes.
+  std::size_t size() const noexcept
+  {
+    return this->slotCount;
+  }
+
+private:
+  /// Murmur3's 64 bits finalizer.
+  static std::uint64_t mix(std::uint64_t x) noexcept
+  {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+  }
+  static std::uint64_t displacementKey(std::uint32_t d) noexcept
+  {
+    return d * 0x9e3779b97f4a7c15ull;
+  }
+  /// Maps the low 32 bits of x onto [0, n) without a division.
+  static std::uint32_t reduce(std::uint64_t x, std::uint32_t n) noexcept
+  {
+    return static_cast<std::uint32_t>(((x & 0xffffffffull) * n) >> 32);
+  }
+  std::uint32_t bucket(std::uint64_t x) const noexcept
+  {
+    return reduce(x >> 32,
+                  static_cast<std::uint32_t>(this->displacements.size()));
+  }
+
+  /** Tries to place every hash with the current seed.
+   * Equal hashes get the same slot.
+   */
+  bool tryBuild(std::vector<std::size_t> const& hashes,
+                std::vector<std::uint32_t>& slots)
+  {
+    auto const n = hashes.size();
+    auto const bucketCount = (n + BUCKET_LOAD - 1) / BUCKET_LOAD;
+    this->displacements.assign(bucketCount, 0);
+
+    // Group hashes by bucket, counting sort style.
+    std::vector<std::uint64_t> mixed(n);
+    std::vector<std::uint32_t> bucketOf(n);
+    std::vector<std::size_t> offsets(bucketCount + 1, 0);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      mixed[i] = mix(hashes[i] ^ this->seed);
+      bucketOf[i] = this->bucket(mixed[i]);
+      ++offsets[bucketOf[i] + 1];
+    }
+    std::size_t largest = 0;
+    for (std::size_t b = 0; b < bucketCount; ++b)
+    {
+      if (offsets[b + 1] > largest)
+        largest = offsets[b + 1];
+      offsets[b + 1] += offsets[b];
+    }
+    std::vector<std::uint32_t> members(n);
+    {
+      auto fill = offsets;
+      for (std::size_t i = 0; i < n; ++i)
+        members[fill[bucketOf[i]]++] = static_cast<std::uint32_t>(i);
+    }
+
+    // Equal hashes land in the same bucket. Keep the first of them only,
+    // at the front of the bucket, and give the others its slot at the end.
+    std::vector<std::size_t> sizes(bucketCount);
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> equal;
+    std::size_t distinct = 0;
+    for (std::size_t b = 0; b < bucketCount; ++b)
+    {
+      auto const first = members.begin() +
+                         static_cast<std::ptrdiff_t>(offsets[b]);
+      auto last = first;
+      for (auto it = first;
+           it != members.begin() + static_cast<std::ptrdiff_t>(offsets[b + 1]);
+           ++it)
+      {
+        auto const same = std::find_if(first, last, [&](std::uint32_t i) {
+          return mixed[i] == mixed[*it];
+        });
+        if (same != last)
+          equal.emplace_back(*it, *same);
+        else
+          *last++ = *it;
+      }
+      sizes[b] = static_cast<std::size_t>(last - first);
+      distinct += sizes[b];
+    }
+    this->slotCount = static_cast<std::uint32_t>(distinct);
+
+    // Order buckets by decreasing size, counting sort style again.
+    std::vector<std::vector<std::uint32_t>> bySize(largest + 1);
+    for (std::size_t b = 0; b < bucketCount; ++b)
+      bySize[sizes[b]].push_back(static_cast<std::uint32_t>(b));
+
+    std::vector<bool> taken(distinct, false);
+    for (auto size = largest; size > 0; --size)
+    {
+      for (auto const b : bySize[size])
+      {
+        auto const first = members.begin() +
+                           static_cast<std::ptrdiff_t>(offsets[b]);
+        auto const last = first + static_cast<std::ptrdiff_t>(size);
+        if (!this->place(b, first, last, mixed, taken, slots))
+          return false;
+      }
+    }
+    for (auto const& pair : equal)
+      slots[pair.first] = slots[pair.second];
+    return true;
+  }
+
+  /// Finds a displacement that puts members of bucket b into free slots.
+  bool place(std::uint32_t b,
+             std::vector<std::uint32_t>::const_iterator first,
+             std::vector<std::uint32_t>::const_iterator last,
+             std::vector<std::uint64_t> const& mixed,
+             std::vector<bool>& taken,
+             std::vector<std::uint32_t>& slots)
+  {
+    for (std::uint32_t d = 0; d < MAX_DISPLACEMENT; ++d)
+    {
+      auto const key = displacementKey(d);
+      auto it = first;
+      for (; it != last; ++it)
+      {
+        auto const s = reduce(mix(mixed[*it] ^ key), this->slotCount);
+        if (taken[s])
+          break;
+        taken[s] = true;
+        slots[*it] = s;
+      }
+      if (it == last)
+      {
+        this->displacements[b] = d;
+        return true;
+      }
+      // Roll back the slots this displacement took.
+      for (auto undo = first; undo != it; ++undo)
+        taken[slots[*undo]] = false;
+    }
+    return false;
+  }
+
+  std::vector<std::uint32_t> displacements;
+  /// (hash, position) of the elements that did not get their slot.
+  std::vector<std::pair<std::size_t, std::size_t>> overflow;
+  std::uint64_t seed = 0;
+  std::uint32_t slotCount = 0;
+};
+}
+}
+
+#endif /* !KOUH_PERFECTHASH_HH_ */
@@ -0,0 +1,186 @@
+#ifndef KOUH_PERFECTHASHMAP_HPP_
+#define KOUH_PERFECTHASHMAP_HPP_
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <kouh/FlatMap.hpp>
+#include <kouh/PerfectHash.hh>
+
+namespace kouh
+{
+/** A read-only map over a minimal perfect hash of its keys.
+ *
+ * Elements are stored in a vector, each one at the slot the perfect hash
+ * gives its key. A lookup hashes the key, reads one displacement and
+ * compares the key in the only slot it can be in: it runs in constant time,
+ * with at most two cache misses. Keys whose hash equals that of another key
+ * are stored after the slots, and also looked up by hash.
+ *
+ * This is what freeze returns for a FlatMap. Building it takes a few passes
+ * over the elements; it is meant for maps that are built once and searched
+ * often.
+ */
+template <typename KeyType,
+          typename ValueType,
+          typename Hash = std::hash<KeyType>,
+          typename KeyEqual = std::equal_to<KeyType>>
+class PerfectHashMap
+{
+public:
+  using PairType = std::pair<KeyType, ValueType>;
+  using value_type = PairType;
+  using ContainerType = std::vector<PairType>;
+  using size_type = typename ContainerType::size_type;
+  using iterator = typename ContainerType::const_iterator;
+  using const_iterator = typename ContainerType::const_iterator;
+
+  PerfectHashMap() noexcept = default;
+  /** Construct from a range of pairs with distinct keys.
+   * Keys may hash to the same value, which only slows their lookups down.
+   */
+  template <typename InputIt>
+  PerfectHashMap(InputIt first,
+                 InputIt last,
+                 Hash const& h = Hash{},
+                 KeyEqual const& eq = KeyEqual{})
+    : hasher(h), equal(eq)
+  {
+    ContainerType pairs(first, last);
+    std::vector<std::size_t> hashes;
+    hashes.reserve(pairs.size());
+    for (auto const& pair : pairs)
+      hashes.push_back(this->hasher(pair.first));
+    // Move each element to its position.
+    this->values.reserve(pairs.size());
+    for (auto const i : this->index.build(hashes))
+      this->values.push_back(std::move(pairs[i]));
+  }
+  PerfectHashMap(PerfectHashMap const& b) = default;
+  PerfectHashMap(PerfectHashMap&& b) noexcept = default;
+  ~PerfectHashMap() noexcept = default;
+
+  PerfectHashMap& operator=(PerfectHashMap const& rhs) = default;
+  PerfectHashMap& operator=(PerfectHashMap&& rhs) noexcept = default;
+
+  /// Returns the number of elements in the PerfectHashMap.
+  size_type size() const noexcept
+  {
+    return this->values.size();
+  }
+  /// Returns true if there are no elements in the PerfectHashMap.
+  bool empty() const noexcept
+  {
+    return this->values.empty();
+  }
+
+  /// Elements are iterated in slot order, which is unspecified.
+  const_iterator begin() const noexcept
+  {
+    return this->values.begin();
+  }
+  const_iterator end() const noexcept
+  {
+    return this->values.end();
+  }
+  const_iterator cbegin() const noexcept
+  {
+    return this->values.cbegin();
+  }
+  const_iterator cend() const noexcept
+  {
+    return this->values.cend();
+  }
+
+  Hash hash_function() const
+  {
+    return this->hasher;
+  }
+  KeyEqual key_eq() const
+  {
+    return this->equal;
+  }
+
+  /** Find the position of the value for given key.
+   * Returns end() if no match was found.
+   */
+  const_iterator find(KeyType const& key) const
+  {
+    if (this->empty())
+      return this->end();
+    auto const pos =
+        this->index.find(this->hasher(key), [&](std::size_t i) {
+          return this->equal(this->values[i].first, key);
+        });
+    if (pos == detail::PerfectHashIndex::NOT_FOUND)
+      return this->end();
+    return this->begin() + static_cast<std::ptrdiff_t>(pos);
+  }
+  /// Returns 1 if key is in the PerfectHashMap, 0 otherwise.
+  size_type count(KeyType const& key) const
+  {
+    return this->contains(key) ? 1 : 0;
+  }
+  /// Returns true if key is in the PerfectHashMap, false otherwise.
+  bool contains(KeyType const& key) const
+  {
+    return this->find(key) != this->end();
+  }
+  ValueType const& at(KeyType const& key) const
+  {
+    auto const it = this->find(key);
+    if (it != this->end())
+      return it->second;
+    throw std::out_of_range("Invalid access at PerfectHashMap::at const");
+  }
+
+private:
+  detail::PerfectHashIndex index;
+  ContainerType values;
+  Hash hasher;
+  KeyEqual equal;
+};
+
+/** Builds a read-only copy of fm with constant time lookups.
+ * The keys are indexed by a minimal perfect hash, see PerfectHashMap.
+ */
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search,
+          typename Hash = std::hash<KeyType>,
+          typename KeyEqual = std::equal_to<KeyType>>
+PerfectHashMap<KeyType, ValueType, Hash, KeyEqual> freeze(
+    FlatMap<KeyType, ValueType, Comp, Alloc, Search> const& fm,
+    Hash const& h = Hash{},
+    KeyEqual const& eq = KeyEqual{})
+{
+  return {fm.begin(), fm.end(), h, eq};
+}
+/// Same as above, but moves the elements out of fm, which is left empty.
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search,
+          typename Hash = std::hash<KeyType>,
+          typename KeyEqual = std::equal_to<KeyType>>
+PerfectHashMap<KeyType, ValueType, Hash, KeyEqual> freeze(
+    FlatMap<KeyType, ValueType, Comp, Alloc, Search>&& fm,
+    Hash const& h = Hash{},
+    KeyEqual const& eq = KeyEqual{})
+{
+  auto pairs = fm.extract();
+  return {std::make_move_iterator(pairs.begin()),
+          std::make_move_iterator(pairs.end()),
+          h,
+          eq};
+}
+}
+
+#endif /* !KOUH_PERFECTHASHMAP_HPP_ */
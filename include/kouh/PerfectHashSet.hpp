@@ -0,0 +1,160 @@
+#ifndef KOUH_PERFECTHASHSET_HPP_
+#define KOUH_PERFECTHASHSET_HPP_
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include <kouh/FlatUnorderedSet.hpp>
+#include <kouh/PerfectHash.hh>
+
+namespace kouh
+{
+/** A read-only set over a minimal perfect hash of its values.
+ *
+ * The set counterpart of PerfectHashMap, and what freeze returns for a
+ * FlatUnorderedSet. Lookups run in constant time, instead of its linear
+ * scan.
+ */
+template <typename ValueType,
+          typename Hash = std::hash<ValueType>,
+          typename KeyEqual = std::equal_to<ValueType>>
+class PerfectHashSet
+{
+public:
+  using value_type = ValueType;
+  using ContainerType = std::vector<value_type>;
+  using size_type = typename ContainerType::size_type;
+  using iterator = typename ContainerType::const_iterator;
+  using const_iterator = typename ContainerType::const_iterator;
+
+  PerfectHashSet() noexcept = default;
+  /** Construct from a range of distinct values.
+   * Values may hash to the same value, which only slows their lookups down.
+   */
+  template <typename InputIt>
+  PerfectHashSet(InputIt first,
+                 InputIt last,
+                 Hash const& h = Hash{},
+                 KeyEqual const& eq = KeyEqual{})
+    : hasher(h), equal(eq)
+  {
+    ContainerType input(first, last);
+    std::vector<std::size_t> hashes;
+    hashes.reserve(input.size());
+    for (auto const& value : input)
+      hashes.push_back(this->hasher(value));
+    // Move each element to its position.
+    this->values.reserve(input.size());
+    for (auto const i : this->index.build(hashes))
+      this->values.push_back(std::move(input[i]));
+  }
+  PerfectHashSet(PerfectHashSet const& b) = default;
+  PerfectHashSet(PerfectHashSet&& b) noexcept = default;
+  ~PerfectHashSet() noexcept = default;
+
+  PerfectHashSet& operator=(PerfectHashSet const& rhs) = default;
+  PerfectHashSet& operator=(PerfectHashSet&& rhs) noexcept = default;
+
+  size_type size() const noexcept
+  {
+    return this->values.size();
+  }
+  bool empty() const noexcept
+  {
+    return this->values.empty();
+  }
+
+  /// Values are iterated in slot order, which is unspecified.
+  const_iterator begin() const noexcept
+  {
+    return this->values.begin();
+  }
+  const_iterator end() const noexcept
+  {
+    return this->values.end();
+  }
+  const_iterator cbegin() const noexcept
+  {
+    return this->values.cbegin();
+  }
+  const_iterator cend() const noexcept
+  {
+    return this->values.cend();
+  }
+
+  Hash hash_function() const
+  {
+    return this->hasher;
+  }
+  KeyEqual key_eq() const
+  {
+    return this->equal;
+  }
+
+  /** Find the position of val.
+   * Returns end() if no match was found.
+   */
+  const_iterator find(value_type const& val) const
+  {
+    if (this->empty())
+      return this->end();
+    auto const pos =
+        this->index.find(this->hasher(val), [&](std::size_t i) {
+          return this->equal(this->values[i], val);
+        });
+    if (pos == detail::PerfectHashIndex::NOT_FOUND)
+      return this->end();
+    return this->begin() + static_cast<std::ptrdiff_t>(pos);
+  }
+  size_type count(value_type const& val) const
+  {
+    return this->contains(val) ? 1 : 0;
+  }
+  bool contains(value_type const& val) const
+  {
+    return this->find(val) != this->end();
+  }
+
+private:
+  detail::PerfectHashIndex index;
+  ContainerType values;
+  Hash hasher;
+  KeyEqual equal;
+};
+
+/** Builds a read-only copy of fus with constant time lookups.
+ * The values are indexed by a minimal perfect hash, see PerfectHashSet.
+ */
+template <typename ValueType,
+          typename Comparator,
+          typename Alloc,
+          typename Hash = std::hash<ValueType>>
+PerfectHashSet<ValueType, Hash, Comparator> freeze(
+    FlatUnorderedSet<ValueType, Comparator, Alloc> const& fus,
+    Hash const& h = Hash{})
+{
+  return {fus.begin(), fus.end(), h, fus.key_eq()};
+}
+/// Same as above, but moves the values out of fus, which is left empty.
+template <typename ValueType,
+          typename Comparator,
+          typename Alloc,
+          typename Hash = std::hash<ValueType>>
+PerfectHashSet<ValueType, Hash, Comparator> freeze(
+    FlatUnorderedSet<ValueType, Comparator, Alloc>&& fus,
+    Hash const& h = Hash{})
+{
+  PerfectHashSet<ValueType, Hash, Comparator> ret{
+      std::make_move_iterator(fus.begin()),
+      std::make_move_iterator(fus.end()),
+      h,
+      fus.key_eq()};
+  fus.clear();
+  return ret;
+}
+}
+
+#endif /* !KOUH_PERFECTHASHSET_HPP_ */
@@ -0,0 +1,17 @@
+#ifndef KOUH_PMR_HH_
+#define KOUH_PMR_HH_
+
+/** Detection of std::pmr.
+ *
+ * Defines KOUH_HAS_PMR when <memory_resource> is available, which requires
+ * C++17. The containers only declare their kouh::pmr aliases then.
+ */
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define KOUH_HAS_PMR 1
+#endif
+#endif
+
+#endif /* !KOUH_PMR_HH_ */
@@ -0,0 +1,34 @@
+#ifndef KOUH_PREFETCH_HH_
+#define KOUH_PREFETCH_HH_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace kouh
+{
+namespace detail
+{
+/// Size of a cache line on the targets we care about.
+constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+/** Hints the CPU to bring the cache line holding `base[idx]` into the cache.
+ *
+ * `idx` may point past the end of the array: prefetches never fault, and the
+ * address is computed on integers so no out-of-bounds pointer is formed.
+ * Does nothing on compilers without __builtin_prefetch.
+ */
+template <typename T>
+inline void prefetch(T const* base, std::size_t idx) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+  auto const addr = reinterpret_cast<std::uintptr_t>(base) + idx * sizeof(T);
+  __builtin_prefetch(reinterpret_cast<void const*>(addr));
+#else
+  static_cast<void>(base);
+  static_cast<void>(idx);
+#endif
+}
+}
+}
+
+#endif /* !KOUH_PREFETCH_HH_ */
@@ -0,0 +1,546 @@
+#ifndef KOUH_SEARCHPOLICY_HPP_
+#define KOUH_SEARCHPOLICY_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <kouh/LowerBound.hpp>
+
+namespace kouh
+{
+/** Search policies for FlatMap.
+ *
+ * A search policy finds the lower bound of a key in the sorted elements of a
+ * FlatMap. It provides:
+ *   - `It lowerBound(first, last, key, comp, proj) const`, which must return
+ *     the same iterator as a binary search, whatever state the policy is in;
+ *   - `void train(first, last, proj) noexcept`, which the FlatMap calls after
+ *     the operations that already run in linear time (construction, bulk
+ *     insertion, merges, bulk erasure, replace);
+ *   - `void inserted(first, last, pos, proj) noexcept` and
+ *     `void erased(first, last, pos) noexcept`, called after a single element
+ *     was inserted at pos, or erased from before pos. A policy may ignore
+ *     them, if it copes with a stale model of the keys.
+ */
+
+/// Plain binary search. The default, for any key type.
+struct BinarySearch
+{
+  template <typename It, typename Proj>
+  void train(It, It, Proj) noexcept
+  {
+  }
+  template <typename It, typename Proj>
+  void inserted(It, It, It, Proj) noexcept
+  {
+  }
+  template <typename It>
+  void erased(It, It, It) noexcept
+  {
+  }
+
+  template <typename It, typename Key, typename Comp, typename Proj>
+  It lowerBound(It first,
+                It last,
+                Key const& key,
+                Comp const& comp,
+                Proj proj) const noexcept
+  {
+    return detail::lowerBound(first, last, key, comp, proj);
+  }
+};
+
+/** Interpolation search, for arithmetic keys close to uniformly distributed.
+ *
+ * Each round guesses the position of the key from the values at both ends of
+ * the range. Guesses tend to land on the same side of the key, which would
+ * only move one end of the range: a guard probe, sqrt(n) elements further,
+ * moves the other one. On uniform keys, a range of n elements shrinks to
+ * about sqrt(n) elements per round.
+ *
+ * After MAX_ROUNDS rounds, or once the range is small, the rest is left to
+ * binary search, so that skewed keys cost at most a few extra probes.
+ */
+struct InterpolationSearch
+{
+  /// Rounds of two probes made before falling back to binary search.
+  static constexpr std::size_t MAX_ROUNDS = 3;
+
+  template <typename It, typename Proj>
+  void train(It, It, Proj) noexcept
+  {
+  }
+  template <typename It, typename Proj>
+  void inserted(It, It, It, Proj) noexcept
+  {
+  }
+  template <typename It>
+  void erased(It, It, It) noexcept
+  {
+  }
+
+  template <typename It, typename Key, typename Comp, typename Proj>
+  It lowerBound(It first,
+                It last,
+                Key const& key,
+                Comp const& comp,
+                Proj proj) const noexcept
+  {
+    static_assert(std::is_arithmetic<Key>::value,
+                  "InterpolationSearch needs arithmetic keys");
+    using Difference = typename std::iterator_traits<It>::difference_type;
+    if (first == last || !comp(proj(*first), key))
+      return first;
+    if (comp(proj(*(last - 1)), key))
+      return last;
+    // The lower bound is in (low, high]: the element at low is less than key
+    // and the one at high is not. Their values are kept, so that each probe
+    // only loads the element it guesses.
+    Difference low = 0;
+    Difference high = last - first - 1;
+    auto lowValue = static_cast<double>(proj(*first));
+    auto highValue = static_cast<double>(proj(*(last - 1)));
+    auto const target = static_cast<double>(key);
+    // Narrows (low, high] to the side of pos the lower bound is on.
+    auto probe = [&](Difference pos) {
+      auto const& posKey = proj(first[pos]);
+      if (comp(posKey, key))
+      {
+        low = pos;
+        lowValue = static_cast<double>(posKey);
+        return true;
+      }
+      high = pos;
+      highValue = static_cast<double>(posKey);
+      return false;
+    };
+    for (std::size_t round = 0; round < MAX_ROUNDS; ++round)
+    {
+      auto const n = high - low;
+      if (n <= static_cast<Difference>(detail::LOWER_BOUND_WINDOW))
+        break;
+      auto const guess =
+          (target - lowValue) / (highValue - lowValue) * static_cast<double>(n);
+      // NaNs and keys that are not ordered like numbers probe the middle.
+      auto const offset = guess >= 1 && guess < static_cast<double>(n)
+                              ? static_cast<Difference>(guess)
+                              : n / 2;
+      auto const guard =
+          static_cast<Difference>(std::sqrt(static_cast<double>(n)));
+      auto const mid = low + offset;
+      // Whichever guard is probed, its load is already in flight.
+      detail::prefetch(&*first,
+                       static_cast<std::size_t>(std::max(mid - guard, low)));
+      detail::prefetch(&*first,
+                       static_cast<std::size_t>(std::min(mid + guard, high)));
+      if (probe(mid))
+      {
+        if (mid + guard < high)
+          probe(mid + guard);
+      }
+      else if (mid - guard > low)
+        probe(mid - guard);
+    }
+    return detail::lowerBound(
+        first + low + 1, first + high + 1, key, comp, proj);
+  }
+};
+
+/** A piecewise linear model of the position of the keys.
+ *
+ * train splits the keys in segments over which the position of a key is a
+ * linear function of its value, give or take MAX_ERROR. A lookup finds the
+ * segment of the key, predicts its position and only searches the
+ * 2 * MAX_ERROR + 1 elements around it. Uniform keys need a single segment.
+ *
+ * If the elements around the prediction do not bracket the key, because
+ * elements were inserted or erased since the last training, the whole range
+ * is binary searched instead. For arithmetic keys only.
+ */
+struct LearnedSegmentSearch
+{
+  /// Maximum distance between a predicted and an actual position.
+  static constexpr std::size_t MAX_ERROR = 16;
+
+  template <typename It, typename Proj>
+  void train(It first, It last, Proj proj) noexcept
+  {
+    this->segments.clear();
+    try
+    {
+      this->fit(first, last, proj);
+    }
+    catch (std::bad_alloc const&)
+    {
+      // Without a model, every lookup falls back to binary search.
+      this->segments.clear();
+    }
+  }
+  /// The model goes stale, lookups check it is still right.
+  template <typename It, typename Proj>
+  void inserted(It, It, It, Proj) noexcept
+  {
+  }
+  template <typename It>
+  void erased(It, It, It) noexcept
+  {
+  }
+
+  template <typename It, typename Key, typename Comp, typename Proj>
+  It lowerBound(It first,
+                It last,
+                Key const& key,
+                Comp const& comp,
+                Proj proj) const noexcept
+  {
+    static_assert(std::is_arithmetic<Key>::value,
+                  "LearnedSegmentSearch needs arithmetic keys");
+    using Difference = typename std::iterator_traits<It>::difference_type;
+    auto const n = static_cast<std::size_t>(last - first);
+    if (this->segments.empty() || n == 0)
+      return detail::lowerBound(first, last, key, comp, proj);
+
+    auto const x = static_cast<double>(key);
+    auto segment = std::upper_bound(
+        this->segments.begin(),
+        this->segments.end(),
+        x,
+        [](double value, Segment const& s) { return value < s.firstKey; });
+    if (segment != this->segments.begin())
+      --segment;
+    auto const guess = static_cast<double>(segment->start) +
+                       segment->slope * (x - segment->firstKey);
+    // Written so that NaNs predict 0.
+    auto const predicted =
+        guess > 0 ? static_cast<std::size_t>(
+                        std::min(guess, static_cast<double>(n)))
+                  : 0;
+    auto const low = predicted > MAX_ERROR ? predicted - MAX_ERROR : 0;
+    auto const high = std::min(predicted + MAX_ERROR + 1, n);
+    auto const windowFirst = first + static_cast<Difference>(low);
+    auto const windowLast = first + static_cast<Difference>(high);
+    // The lower bound is in the window if the element before it is less than
+    // key and the element at its end is not.
+    if ((low == 0 || comp(proj(*(windowFirst - 1)), key)) &&
+        (high == n || !comp(proj(*windowLast), key)))
+      return detail::lowerBound(windowFirst, windowLast, key, comp, proj);
+    return detail::lowerBound(first, last, key, comp, proj);
+  }
+
+  /// Returns the number of segments of the model.
+  std::size_t segmentCount() const noexcept
+  {
+    return this->segments.size();
+  }
+
+private:
+  struct Segment
+  {
+    double firstKey;
+    double slope;
+    std::size_t start;
+  };
+
+  /** Greedy "shrinking cone" fitting.
+   * A segment grows as long as some slope keeps every key in it within
+   * MAX_ERROR of its position.
+   */
+  template <typename It, typename Proj>
+  void fit(It first, It last, Proj proj)
+  {
+    using Difference = typename std::iterator_traits<It>::difference_type;
+    auto const n = static_cast<std::size_t>(last - first);
+    auto const error = static_cast<double>(MAX_ERROR);
+    std::size_t start = 0;
+    double firstKey = 0;
+    double minSlope = 0;
+    double maxSlope = std::numeric_limits<double>::infinity();
+    auto close = [&]() {
+      auto const slope =
+          maxSlope == std::numeric_limits<double>::infinity()
+              ? 0
+              : (minSlope + maxSlope) / 2;
+      this->segments.push_back({firstKey, slope, start});
+    };
+
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      auto const x =
+          static_cast<double>(proj(first[static_cast<Difference>(i)]));
+      if (i == 0)
+      {
+        firstKey = x;
+        continue;
+      }
+      auto const dx = x - firstKey;
+      auto const dy = static_cast<double>(i - start);
+      bool fits;
+      if (dx <= 0)
+        // Keys that collapse to the same double share a prediction.
+        fits = dy <= error;
+      else
+      {
+        auto const lowSlope = std::max(minSlope, (dy - error) / dx);
+        auto const highSlope = std::min(maxSlope, (dy + error) / dx);
+        fits = lowSlope <= highSlope;
+        if (fits)
+        {
+          minSlope = lowSlope;
+          maxSlope = highSlope;
+        }
+      }
+      if (!fits)
+      {
+        close();
+        start = i;
+        firstKey = x;
+        minSlope = 0;
+        maxSlope = std::numeric_limits<double>::infinity();
+      }
+    }
+    if (n > 0)
+      close();
+  }
+
+  std::vector<Segment> segments;
+};
+
+/** Binary search over a cache of fixed-width key prefixes, for string keys.
+ *
+ * Comparing strings follows a pointer to their bytes, and a binary search
+ * over long strings misses the cache on every probe. This keeps, next to the
+ * elements, an array of 8 bytes of each key read as a big-endian integer: a
+ * lookup binary searches that dense array, and only compares whole keys
+ * among the few elements whose prefix ties with the key.
+ *
+ * The 8 bytes are taken after the prefix that all keys share, so that keys
+ * like paths or URLs, which all start alike, still get distinct prefixes.
+ *
+ * Unlike the other policies, the cache is kept up to date on every insertion
+ * and erasure, which costs a move of 8 bytes per element after the position.
+ * If memory runs out, it is dropped and lookups use a plain binary search
+ * until the next training.
+ *
+ * Keys must be strings ordered by their bytes: the comparator must be
+ * std::less of the key type, or std::less<>. Lookup keys may be anything
+ * with data() and size(), like std::string_view, or C strings. Other lookup
+ * types use a plain binary search.
+ */
+struct PrefixCacheSearch
+{
+  template <typename It, typename Proj>
+  void train(It first, It last, Proj proj) noexcept
+  {
+    this->prefixes.clear();
+    try
+    {
+      this->build(first, last, proj);
+    }
+    catch (std::bad_alloc const&)
+    {
+      this->prefixes.clear();
+    }
+  }
+  template <typename It, typename Proj>
+  void inserted(It first, It last, It pos, Proj proj) noexcept
+  {
+    auto const& key = proj(*pos);
+    auto const n = static_cast<std::size_t>(last - first);
+    if (n == 1 || n != this->prefixes.size() + 1 ||
+        this->sharedLength(key.data(), key.size()) < this->shared.size())
+    {
+      // A key that does not start with the shared prefix changes all of them.
+      this->train(first, last, proj);
+      return;
+    }
+    try
+    {
+      this->prefixes.insert(this->prefixes.begin() + (pos - first),
+                            this->prefixOf(key.data(), key.size()));
+    }
+    catch (std::bad_alloc const&)
+    {
+      this->prefixes.clear();
+    }
+  }
+  template <typename It>
+  void erased(It first, It last, It pos) noexcept
+  {
+    if (static_cast<std::size_t>(last - first) + 1 != this->prefixes.size())
+    {
+      this->prefixes.clear();
+      return;
+    }
+    // The shared prefix is still shared by the remaining keys.
+    this->prefixes.erase(this->prefixes.begin() + (pos - first));
+  }
+
+  template <typename It, typename Key, typename Comp, typename Proj>
+  It lowerBound(It first,
+                It last,
+                Key const& key,
+                Comp const& comp,
+                Proj proj) const noexcept
+  {
+    using KeyType = typename std::decay<decltype(proj(*first))>::type;
+    static_assert(std::is_same<Comp, std::less<KeyType>>::value ||
+                      std::is_same<Comp, std::less<>>::value,
+                  "PrefixCacheSearch needs keys ordered by their bytes");
+    return this->lowerBound(
+        first, last, key, comp, proj, IsByteString<Key>{});
+  }
+
+  /// Returns the number of cached prefixes, 0 once the cache was dropped.
+  std::size_t prefixCount() const noexcept
+  {
+    return this->prefixes.size();
+  }
+
+private:
+  /// Whether the bytes of a K can be read with bytesOf.
+  template <typename K, typename = void>
+  struct IsByteString : std::is_convertible<K const&, char const*>
+  {
+  };
+  template <typename K>
+  struct IsByteString<
+      K,
+      typename std::conditional<true,
+                                void,
+                                decltype(std::declval<K const&>().data(),
+                                         std::declval<K const&>().size())>::
+          type> : std::true_type
+  {
+  };
+
+  static std::pair<char const*, std::size_t> bytesOf(char const* key) noexcept
+  {
+    return {key, std::char_traits<char>::length(key)};
+  }
+  template <typename K>
+  static auto bytesOf(K const& key) noexcept
+      -> decltype(std::pair<char const*, std::size_t>(key.data(), key.size()))
+  {
+    return {key.data(), key.size()};
+  }
+
+  template <typename It, typename Key, typename Comp, typename Proj>
+  It lowerBound(It first,
+                It last,
+                Key const& key,
+                Comp const& comp,
+                Proj proj,
+                std::false_type) const noexcept
+  {
+    return detail::lowerBound(first, last, key, comp, proj);
+  }
+  template <typename It, typename Key, typename Comp, typename Proj>
+  It lowerBound(It first,
+                It last,
+                Key const& key,
+                Comp const& comp,
+                Proj proj,
+                std::true_type) const noexcept
+  {
+    auto const n = static_cast<std::size_t>(last - first);
+    if (n == 0 || this->prefixes.size() != n)
+      return detail::lowerBound(first, last, key, comp, proj);
+    auto const bytes = bytesOf(key);
+    // Keys that do not start with the shared prefix are outside the range.
+    auto const length = this->sharedLength(bytes.first, bytes.second);
+    if (length < this->shared.size())
+    {
+      if (length == bytes.second ||
+          static_cast<unsigned char>(bytes.first[length]) <
+              static_cast<unsigned char>(this->shared[length]))
+        return first;
+      return last;
+    }
+    auto const prefix = this->prefixOf(bytes.first, bytes.second);
+    // Positions of the prefixes equal to the key's, in [low, high).
+    auto const position = [this](std::uint64_t p) {
+      auto const data = this->prefixes.data();
+      auto const size = this->prefixes.size();
+      return static_cast<std::size_t>(
+          detail::lowerBound(data,
+                             data + size,
+                             p,
+                             std::less<std::uint64_t>{},
+                             detail::Identity{}) -
+          data);
+    };
+    auto const low = position(prefix);
+    auto const high = prefix == std::numeric_limits<std::uint64_t>::max()
+                          ? n
+                          : position(prefix + 1);
+    return detail::lowerBound(first + static_cast<std::ptrdiff_t>(low),
+                              first + static_cast<std::ptrdiff_t>(high),
+                              key,
+                              comp,
+                              proj);
+  }
+
+  template <typename It, typename Proj>
+  void build(It first, It last, Proj proj)
+  {
+    if (first == last)
+    {
+      this->shared.clear();
+      return;
+    }
+    // Keys are sorted: the prefix of the first and last keys is shared by all.
+    auto const& front = proj(*first);
+    auto const& back = proj(*(last - 1));
+    auto const size = std::min(front.size(), back.size());
+    std::size_t length = 0;
+    while (length < size && front[length] == back[length])
+      ++length;
+    this->shared.assign(front.data(), length);
+    this->prefixes.reserve(static_cast<std::size_t>(last - first));
+    for (; first != last; ++first)
+    {
+      auto const& key = proj(*first);
+      this->prefixes.push_back(this->prefixOf(key.data(), key.size()));
+    }
+  }
+
+  /// Returns how many bytes of the shared prefix key starts with.
+  std::size_t sharedLength(char const* key, std::size_t size) const noexcept
+  {
+    auto const length = std::min(size, this->shared.size());
+    std::size_t i = 0;
+    while (i < length && key[i] == this->shared[i])
+      ++i;
+    return i;
+  }
+
+  /// The 8 bytes of key after the shared prefix, zero padded, big-endian.
+  std::uint64_t prefixOf(char const* key, std::size_t size) const noexcept
+  {
+    std::uint64_t prefix = 0;
+    for (std::size_t i = 0; i < 8; ++i)
+    {
+      auto const pos = this->shared.size() + i;
+      prefix <<= 8;
+      if (pos < size)
+        prefix |= static_cast<unsigned char>(key[pos]);
+    }
+    return prefix;
+  }
+
+  std::string shared;
+  std::vector<std::uint64_t> prefixes;
+};
+}
+
+#endif /* !KOUH_SEARCHPOLICY_HPP_ */
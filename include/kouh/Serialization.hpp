@@ -0,0 +1,402 @@
+#ifndef KOUH_SERIALIZATION_HPP_
+#define KOUH_SERIALIZATION_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include <kouh/LowerBound.hpp>
+
+namespace kouh
+{
+/** A string stored in a serialized container.
+ *
+ * Points into the buffer the container was read from, which must outlive it.
+ */
+class MappedString
+{
+public:
+  MappedString() noexcept = default;
+  MappedString(char const* d, std::size_t s) noexcept : first(d), length(s)
+  {
+  }
+
+  char const* data() const noexcept
+  {
+    return this->first;
+  }
+  std::size_t size() const noexcept
+  {
+    return this->length;
+  }
+  bool empty() const noexcept
+  {
+    return this->length == 0;
+  }
+  char const* begin() const noexcept
+  {
+    return this->first;
+  }
+  char const* end() const noexcept
+  {
+    return this->first + this->length;
+  }
+  /// Copies the string out of the buffer.
+  std::string str() const
+  {
+    return {this->first, this->length};
+  }
+
+  /// Compares like std::string::compare.
+  int compare(char const* d, std::size_t s) const noexcept
+  {
+    auto const n = this->length < s ? this->length : s;
+    auto const cmp = n > 0 ? std::memcmp(this->first, d, n) : 0;
+    if (cmp != 0)
+      return cmp;
+    return this->length < s ? -1 : (this->length > s ? 1 : 0);
+  }
+
+private:
+  char const* first = "";
+  std::size_t length = 0;
+};
+
+inline bool operator==(MappedString const& a, std::string const& b) noexcept
+{
+  return a.compare(b.data(), b.size()) == 0;
+}
+inline bool operator==(std::string const& a, MappedString const& b) noexcept
+{
+  return b == a;
+}
+inline bool operator!=(MappedString const& a, std::string const& b) noexcept
+{
+  return !(a == b);
+}
+inline bool operator!=(std::string const& a, MappedString const& b) noexcept
+{
+  return !(b == a);
+}
+
+namespace detail
+{
+/** Header of a serialized container.
+ *
+ * A serialized container is this header, followed by one column for its keys
+ * and, for maps, one for its values. All integers are in the byte order of
+ * the machine that wrote the file, and columns start on 8 bytes boundaries.
+ */
+struct SerializedHeader
+{
+  /// "kouhflat", which identifies the format.
+  static constexpr std::uint64_t MAGIC = 0x74616c6668756f6bull;
+  static constexpr std::uint32_t VERSION = 1;
+  /// Reads differently on a machine of the other byte order.
+  static constexpr std::uint32_t ENDIAN_CHECK = 0x01020304;
+  /// Element size recorded for string columns.
+  static constexpr std::uint32_t STRING_COLUMN = 0;
+
+  enum Kind : std::uint32_t
+  {
+    Map = 1,
+    UnorderedSet = 2
+  };
+
+  std::uint64_t magic;
+  std::uint32_t version;
+  std::uint32_t byteOrder;
+  std::uint32_t kind;
+  /// Size of a key, or STRING_COLUMN.
+  std::uint32_t keySize;
+  /// Size of a value, or STRING_COLUMN. 0 for sets.
+  std::uint32_t valueSize;
+  std::uint32_t reserved;
+  std::uint64_t count;
+  /// Offsets of the key and value columns from the start of the header.
+  std::uint64_t keyOffset;
+  std::uint64_t valueOffset;
+  /// Size of the header and all the columns.
+  std::uint64_t totalSize;
+};
+
+/// Returns size, rounded up to the alignment of columns.
+constexpr std::uint64_t columnAlign(std::uint64_t size) noexcept
+{
+  return (size + 7) & ~std::uint64_t{7};
+}
+
+inline void writeBytes(std::ostream& out, void const* data, std::size_t size)
+{
+  out.write(static_cast<char const*>(data),
+            static_cast<std::streamsize>(size));
+}
+
+inline void writePadding(std::ostream& out, std::uint64_t size)
+{
+  static char const zeros[8] = {};
+  writeBytes(out, zeros, static_cast<std::size_t>(columnAlign(size) - size));
+}
+
+/** A column of trivially copyable elements, stored as an array.
+ */
+template <typename T>
+class SerializedColumn
+{
+  static_assert(std::is_trivially_copyable<T>::value,
+                "Only trivially copyable types and std::string can be "
+                "serialized");
+  static_assert(alignof(T) <= 8, "Columns are only aligned on 8 bytes");
+#ifdef __cpp_lib_has_unique_object_representations
+  // Padding bytes would be written as is, and make files differ.
+  static_assert(std::has_unique_object_representations<T>::value ||
+                    std::is_floating_point<T>::value,
+                "Types with padding bytes cannot be serialized");
+#endif
+
+public:
+  using reference = T const&;
+
+  static constexpr std::uint32_t ELEMENT_SIZE = sizeof(T);
+
+  /// Returns the size of the column of given elements.
+  template <typename It, typename Get>
+  static std::uint64_t byteSize(It first, It last, Get)
+  {
+    return static_cast<std::uint64_t>(last - first) * sizeof(T);
+  }
+
+  template <typename It, typename Get>
+  static void write(std::ostream& out, It first, It last, Get get)
+  {
+    for (; first != last; ++first)
+    {
+      T const& element = get(*first);
+      writeBytes(out, &element, sizeof(T));
+    }
+  }
+
+  SerializedColumn() noexcept = default;
+  /// Reads the column of count elements in [data, data + size).
+  SerializedColumn(char const* data, std::uint64_t size, std::uint64_t count)
+  {
+    if (count > size / sizeof(T))
+      throw std::invalid_argument("Truncated column");
+    this->elements = reinterpret_cast<T const*>(data);
+  }
+
+  reference operator[](std::size_t i) const noexcept
+  {
+    return this->elements[i];
+  }
+
+  bool equal(std::size_t i, T const& key) const noexcept
+  {
+    return this->elements[i] == key;
+  }
+  /// Returns the index of the first of the n elements not less than key.
+  std::size_t lowerBound(T const& key, std::size_t n) const noexcept
+  {
+    return static_cast<std::size_t>(
+        detail::lowerBound(this->elements,
+                           this->elements + n,
+                           key,
+                           std::less<T>{},
+                           Identity{}) -
+        this->elements);
+  }
+
+private:
+  T const* elements = nullptr;
+};
+
+/** A column of strings: count + 1 offsets, then the bytes of the strings.
+ * String i is [offsets[i], offsets[i + 1]) in the bytes.
+ */
+template <>
+class SerializedColumn<std::string>
+{
+public:
+  using reference = MappedString;
+
+  static constexpr std::uint32_t ELEMENT_SIZE =
+      SerializedHeader::STRING_COLUMN;
+
+  template <typename It, typename Get>
+  static std::uint64_t byteSize(It first, It last, Get get)
+  {
+    std::uint64_t size = (static_cast<std::uint64_t>(last - first) + 1) *
+                         sizeof(std::uint64_t);
+    for (; first != last; ++first)
+      size += get(*first).size();
+    return size;
+  }
+
+  template <typename It, typename Get>
+  static void write(std::ostream& out, It first, It last, Get get)
+  {
+    std::uint64_t offset = 0;
+    writeBytes(out, &offset, sizeof(offset));
+    for (auto it = first; it != last; ++it)
+    {
+      offset += get(*it).size();
+      writeBytes(out, &offset, sizeof(offset));
+    }
+    for (; first != last; ++first)
+    {
+      std::string const& element = get(*first);
+      writeBytes(out, element.data(), element.size());
+    }
+  }
+
+  SerializedColumn() noexcept = default;
+  SerializedColumn(char const* data, std::uint64_t size, std::uint64_t count)
+  {
+    if (count >= size / sizeof(std::uint64_t))
+      throw std::invalid_argument("Truncated column");
+    auto const offsetsSize = (count + 1) * sizeof(std::uint64_t);
+    this->offsets = reinterpret_cast<std::uint64_t const*>(data);
+    this->bytes = data + offsetsSize;
+    // Only the offsets are read, not the strings they point to.
+    for (std::uint64_t i = 0; i < count; ++i)
+      if (this->offsets[i] > this->offsets[i + 1])
+        throw std::invalid_argument("Corrupted string column");
+    if (this->offsets[count] > size - offsetsSize)
+      throw std::invalid_argument("Truncated column");
+  }
+
+  reference operator[](std::size_t i) const noexcept
+  {
+    return {this->bytes + this->offsets[i],
+            static_cast<std::size_t>(this->offsets[i + 1] - this->offsets[i])};
+  }
+
+  bool equal(std::size_t i, std::string const& key) const noexcept
+  {
+    return (*this)[i].compare(key.data(), key.size()) == 0;
+  }
+  std::size_t lowerBound(std::string const& key, std::size_t n) const noexcept
+  {
+    std::size_t first = 0;
+    while (n > 0)
+    {
+      auto const half = n / 2;
+      if ((*this)[first + half].compare(key.data(), key.size()) < 0)
+      {
+        first += half + 1;
+        n -= half + 1;
+      }
+      else
+        n = half;
+    }
+    return first;
+  }
+
+private:
+  std::uint64_t const* offsets = nullptr;
+  char const* bytes = nullptr;
+};
+
+/// Stands for the values of a set, which has none.
+struct NoValue
+{
+};
+
+/// An empty column.
+template <>
+class SerializedColumn<NoValue>
+{
+public:
+  static constexpr std::uint32_t ELEMENT_SIZE = 0;
+
+  template <typename It, typename Get>
+  static std::uint64_t byteSize(It, It, Get)
+  {
+    return 0;
+  }
+  template <typename It, typename Get>
+  static void write(std::ostream&, It, It, Get)
+  {
+  }
+};
+
+/** Writes a container of count elements: the header, the keys and the
+ * values. getKey and getValue map an element to its key and value; without
+ * a ValueType, there is no value column.
+ */
+template <typename KeyType,
+          typename ValueType,
+          typename It,
+          typename GetKey,
+          typename GetValue>
+void serializeColumns(std::ostream& out,
+                      SerializedHeader::Kind kind,
+                      It first,
+                      It last,
+                      GetKey getKey,
+                      GetValue getValue)
+{
+  using KeyColumn = SerializedColumn<KeyType>;
+  using ValueColumn = SerializedColumn<ValueType>;
+  SerializedHeader header{};
+  header.magic = SerializedHeader::MAGIC;
+  header.version = SerializedHeader::VERSION;
+  header.byteOrder = SerializedHeader::ENDIAN_CHECK;
+  header.kind = kind;
+  header.keySize = KeyColumn::ELEMENT_SIZE;
+  header.valueSize = ValueColumn::ELEMENT_SIZE;
+  header.count = static_cast<std::uint64_t>(last - first);
+  auto const keySize = KeyColumn::byteSize(first, last, getKey);
+  auto const valueSize = ValueColumn::byteSize(first, last, getValue);
+  header.keyOffset = columnAlign(sizeof(SerializedHeader));
+  header.valueOffset = header.keyOffset + columnAlign(keySize);
+  header.totalSize = header.valueOffset + columnAlign(valueSize);
+
+  writeBytes(out, &header, sizeof(header));
+  writePadding(out, sizeof(header));
+  KeyColumn::write(out, first, last, getKey);
+  writePadding(out, keySize);
+  ValueColumn::write(out, first, last, getValue);
+  writePadding(out, valueSize);
+  if (!out)
+    throw std::runtime_error("Could not write serialized container");
+}
+
+/** Checks the header at data describes a container of given kind and types.
+ * Throws std::invalid_argument otherwise.
+ */
+template <typename KeyType, typename ValueType>
+SerializedHeader const& readHeader(void const* data,
+                                   std::size_t size,
+                                   SerializedHeader::Kind kind)
+{
+  if (reinterpret_cast<std::uintptr_t>(data) % 8 != 0)
+    throw std::invalid_argument("Serialized data must be aligned on 8 bytes");
+  if (size < sizeof(SerializedHeader))
+    throw std::invalid_argument("Not a serialized kouh container");
+  auto const& header = *static_cast<SerializedHeader const*>(data);
+  if (header.magic != SerializedHeader::MAGIC ||
+      header.version != SerializedHeader::VERSION)
+    throw std::invalid_argument("Not a serialized kouh container");
+  if (header.byteOrder != SerializedHeader::ENDIAN_CHECK)
+    throw std::invalid_argument("Serialized with another byte order");
+  if (header.kind != kind ||
+      header.keySize != SerializedColumn<KeyType>::ELEMENT_SIZE ||
+      header.valueSize != SerializedColumn<ValueType>::ELEMENT_SIZE)
+    throw std::invalid_argument("Serialized container has other types");
+  if (header.totalSize > size || header.keyOffset > header.valueOffset ||
+      header.valueOffset > header.totalSize ||
+      header.keyOffset < sizeof(SerializedHeader) ||
+      header.keyOffset % 8 != 0 || header.valueOffset % 8 != 0)
+    throw std::invalid_argument("Truncated serialized container");
+  return header;
+}
+}
+}
+
+#endif /* !KOUH_SERIALIZATION_HPP_ */
@@ -0,0 +1,505 @@
+#ifndef KOUH_SMALLFLATMAP_HPP_
+#define KOUH_SMALLFLATMAP_HPP_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+#include <kouh/LowerBound.hpp>
+#include <kouh/SmallVector.hpp>
+#include <kouh/SortedVector.hpp>
+
+namespace kouh
+{
+/** A FlatMap that keeps up to N elements inside the object.
+ *
+ * Elements are stored in a SmallVector, so that a SmallFlatMap with at most
+ * N elements never allocates. It behaves like a FlatMap otherwise, and
+ * shares its sorted vector core. The underlying container that extract(),
+ * replace() and the adopting constructors work with is the SmallVector.
+ *
+ * Moving a SmallFlatMap whose elements are inline moves them one by one and
+ * invalidates iterators.
+ */
+template <typename KeyType,
+          typename ValueType,
+          std::size_t N,
+          typename Comp = std::less<KeyType>>
+class SmallFlatMap
+{
+public:
+  using PairType = std::pair<KeyType, ValueType>;
+  using value_type = PairType;
+  using ContainerType = SmallVector<PairType, N>;
+  using size_type = typename ContainerType::size_type;
+  using difference_type = typename ContainerType::difference_type;
+  using iterator = typename ContainerType::iterator;
+  using const_iterator = typename ContainerType::const_iterator;
+  using reverse_iterator = typename ContainerType::reverse_iterator;
+  using const_reverse_iterator = typename ContainerType::const_reverse_iterator;
+
+  SmallFlatMap() noexcept = default;
+  SmallFlatMap(std::initializer_list<PairType> l) : container(l)
+  {
+    this->sortAndDedup(0, DuplicatePolicy::KeepFirst);
+  }
+  /** Construct from an unsorted range of pairs.
+   * The range is copied once, then sorted and deduplicated in a single pass.
+   */
+  template <typename InputIt>
+  SmallFlatMap(InputIt first,
+               InputIt last,
+               DuplicatePolicy policy = DuplicatePolicy::KeepFirst)
+    : container(first, last)
+  {
+    this->sortAndDedup(0, policy);
+  }
+  /** Construct by adopting an unsorted SmallVector of pairs.
+   * The SmallVector is sorted and deduplicated in place.
+   */
+  explicit SmallFlatMap(ContainerType&& c,
+                        DuplicatePolicy policy = DuplicatePolicy::KeepFirst)
+    : container(std::move(c))
+  {
+    this->sortAndDedup(0, policy);
+  }
+  /** Construct by adopting a SmallVector that is already sorted and unique.
+   * Runs in constant time if its elements are on the heap.
+   */
+  SmallFlatMap(sorted_unique_t, ContainerType&& c, Comp const& cmp = Comp{})
+    : container(std::move(c)), comp(cmp)
+  {
+    assert(this->isSortedUnique());
+  }
+  SmallFlatMap(SmallFlatMap const& b) = default;
+  SmallFlatMap(SmallFlatMap&& b) = default;
+  ~SmallFlatMap() noexcept = default;
+
+  SmallFlatMap& operator=(SmallFlatMap const& rhs) = default;
+  SmallFlatMap& operator=(SmallFlatMap&& rhs) = default;
+
+  /// Returns the number of elements in the SmallFlatMap.
+  size_type size() const noexcept
+  {
+    return this->container.size();
+  }
+  /// Returns true if there are no elements in the SmallFlatMap.
+  bool empty() const noexcept
+  {
+    return this->container.empty();
+  }
+  /// Returns true if the elements are stored inside the object.
+  bool isInline() const noexcept
+  {
+    return this->container.isInline();
+  }
+
+  iterator begin() noexcept
+  {
+    return this->container.begin();
+  }
+  iterator end() noexcept
+  {
+    return this->container.end();
+  }
+  const_iterator begin() const noexcept
+  {
+    return this->container.begin();
+  }
+  const_iterator end() const noexcept
+  {
+    return this->container.end();
+  }
+  const_iterator cbegin() const noexcept
+  {
+    return this->container.cbegin();
+  }
+  const_iterator cend() const noexcept
+  {
+    return this->container.cend();
+  }
+
+  /// Returns the comparator used to order keys.
+  Comp key_comp() const
+  {
+    return this->comp;
+  }
+
+  /** Find the position of the value for given key.
+   * Returns end() if no match was found.
+   */
+  iterator find(KeyType const& key) noexcept
+  {
+    auto const it = this->lowerBound(key);
+    if (this->holds(it, key))
+      return it;
+    return this->end();
+  }
+  const_iterator find(KeyType const& key) const noexcept
+  {
+    auto const it = this->lowerBound(key);
+    if (this->holds(it, key))
+      return it;
+    return this->end();
+  }
+  /// Returns 1 if key is in the SmallFlatMap, 0 otherwise.
+  size_type count(KeyType const& key) const noexcept
+  {
+    return this->contains(key) ? 1 : 0;
+  }
+  /// Returns true if key is in the SmallFlatMap, false otherwise.
+  bool contains(KeyType const& key) const noexcept
+  {
+    return this->find(key) != this->end();
+  }
+  /** Returns the value for given key, inserting a value-initialized one if
+   * the key is not present.
+   */
+  ValueType& operator[](KeyType const& key)
+  {
+    return this->tryEmplace(key).first->second;
+  }
+  ValueType& operator[](KeyType&& key)
+  {
+    return this->tryEmplace(std::move(key)).first->second;
+  }
+  ValueType& at(KeyType const& key)
+  {
+    auto const it = this->find(key);
+    if (it != this->end())
+      return it->second;
+    throw std::out_of_range("Invalid access at SmallFlatMap::at");
+  }
+  ValueType const& at(KeyType const& key) const
+  {
+    auto const it = this->find(key);
+    if (it != this->end())
+      return it->second;
+    throw std::out_of_range("Invalid access at SmallFlatMap::at const");
+  }
+
+  /// Returns an iterator to the first element whose key is not less than key.
+  iterator lower_bound(KeyType const& key) noexcept
+  {
+    return this->lowerBound(key);
+  }
+  const_iterator lower_bound(KeyType const& key) const noexcept
+  {
+    return this->lowerBound(key);
+  }
+  /// Returns an iterator to the first element whose key is greater than key.
+  iterator upper_bound(KeyType const& key) noexcept
+  {
+    return detail::upperBound(
+        this->begin(), this->end(), key, this->comp, detail::PairFirst{});
+  }
+  const_iterator upper_bound(KeyType const& key) const noexcept
+  {
+    return detail::upperBound(
+        this->begin(), this->end(), key, this->comp, detail::PairFirst{});
+  }
+  /// Returns the range of elements whose key is equivalent to key.
+  std::pair<iterator, iterator> equal_range(KeyType const& key) noexcept
+  {
+    auto const first = this->lowerBound(key);
+    if (this->holds(first, key))
+      return {first, first + 1};
+    return {first, first};
+  }
+  std::pair<const_iterator, const_iterator> equal_range(
+      KeyType const& key) const noexcept
+  {
+    auto const first = this->lowerBound(key);
+    if (this->holds(first, key))
+      return {first, first + 1};
+    return {first, first};
+  }
+
+  // Heterogeneous lookup
+  // These overloads take any type that Comp can compare to KeyType. They are
+  // only available when Comp declares `is_transparent`.
+  template <typename K,
+            typename = typename detail::EnableIfTransparent<Comp, K>::type>
+  iterator find(K const& key) noexcept
+  {
+    auto const it = this->lowerBound(key);
+    if (this->holds(it, key))
+      return it;
+    return this->end();
+  }
+  template <typename K,
+            typename = typename detail::EnableIfTransparent<Comp, K>::type>
+  const_iterator find(K const& key) const noexcept
+  {
+    auto const it = this->lowerBound(key);
+    if (this->holds(it, key))
+      return it;
+    return this->end();
+  }
+  template <typename K,
+            typename = typename detail::EnableIfTransparent<Comp, K>::type>
+  size_type count(K const& key) const noexcept
+  {
+    return this->contains(key) ? 1 : 0;
+  }
+  template <typename K,
+            typename = typename detail::EnableIfTransparent<Comp, K>::type>
+  bool contains(K const& key) const noexcept
+  {
+    return this->find(key) != this->end();
+  }
+  template <typename K,
+            typename = typename detail::EnableIfTransparent<Comp, K>::type>
+  ValueType& at(K const& key)
+  {
+    auto const it = this->find(key);
+    if (it != this->end())
+      return it->second;
+    throw std::out_of_range("Invalid access at SmallFlatMap::at");
+  }
+  template <typename K,
+            typename = typename detail::EnableIfTransparent<Comp, K>::type>
+  ValueType const& at(K const& key) const
+  {
+    auto const it = this->find(key);
+    if (it != this->end())
+      return it->second;
+    throw std::out_of_range("Invalid access at SmallFlatMap::at const");
+  }
+  template <typename K,
+            typename = typename detail::EnableIfTransparent<Comp, K>::type>
+  iterator lower_bound(K const& key) noexcept
+  {
+    return this->lowerBound(key);
+  }
+  template <typename K,
+            typename = typename detail::EnableIfTransparent<Comp, K>::type>
+  const_iterator lower_bound(K const& key) const noexcept
+  {
+    return this->lowerBound(key);
+  }
+  template <typename K,
+            typename = typename detail::EnableIfTransparent<Comp, K>::type>
+  iterator upper_bound(K const& key) noexcept
+  {
+    return detail::upperBound(
+        this->begin(), this->end(), key, this->comp, detail::PairFirst{});
+  }
+  template <typename K,
+            typename = typename detail::EnableIfTransparent<Comp, K>::type>
+  const_iterator upper_bound(K const& key) const noexcept
+  {
+    return detail::upperBound(
+        this->begin(), this->end(), key, this->comp, detail::PairFirst{});
+  }
+  template <typename K,
+            typename = typename detail::EnableIfTransparent<Comp, K>::type>
+  std::pair<iterator, iterator> equal_range(K const& key) noexcept
+  {
+    auto const first = this->lowerBound(key);
+    if (this->holds(first, key))
+      return {first, first + 1};
+    return {first, first};
+  }
+  template <typename K,
+            typename = typename detail::EnableIfTransparent<Comp, K>::type>
+  std::pair<const_iterator, const_iterator> equal_range(K const& key) const
+      noexcept
+  {
+    auto const first = this->lowerBound(key);
+    if (this->holds(first, key))
+      return {first, first + 1};
+    return {first, first};
+  }
+
+  /// Removes element whose key is key. Does nothing if key is not found.
+  iterator erase(KeyType const& key) noexcept
+  {
+    auto const it = this->find(key);
+    if (it != this->end())
+      return this->container.erase(it);
+    return this->end();
+  }
+  iterator erase(const_iterator it) noexcept
+  {
+    return this->container.erase(it);
+  }
+  /// Removes the elements in [first, last).
+  iterator erase(const_iterator first, const_iterator last) noexcept
+  {
+    return this->container.erase(first, last);
+  }
+  /// Removes every element. Heap storage, if any, is kept.
+  void clear() noexcept
+  {
+    this->container.clear();
+  }
+  /** Moves the underlying SmallVector out of the SmallFlatMap.
+   * The SmallFlatMap is left empty.
+   */
+  ContainerType extract() noexcept
+  {
+    ContainerType ret{std::move(this->container)};
+    this->container.clear();
+    return ret;
+  }
+  /** Replaces the underlying SmallVector with one that is already sorted and
+   * unique.
+   */
+  void replace(ContainerType&& c) noexcept
+  {
+    this->container = std::move(c);
+    assert(this->isSortedUnique());
+  }
+  /** Keeps only the elements for which pred(element) is true.
+   * Returns the number of removed elements.
+   */
+  template <typename Pred>
+  size_type retain(Pred pred)
+  {
+    auto const last = std::remove_if(
+        this->begin(), this->end(), [&](PairType const& pair) {
+          return !pred(pair);
+        });
+    auto const count = static_cast<size_type>(this->end() - last);
+    this->container.erase(last, this->end());
+    return count;
+  }
+  /// In-place insertion.
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args)
+  {
+    PairType pair(std::forward<Args>(args)...);
+    auto const it = detail::uniqueInsertionPoint(
+        this->container, pair.first, this->comp, detail::PairFirst{});
+    if (this->holds(it, pair.first))
+      return {it, false};
+    return {this->container.insert(it, std::move(pair)), true};
+  }
+  /** In-place insertion, next to hint.
+   * Returns an iterator to the inserted element, or to the element that
+   * prevented insertion.
+   */
+  template <typename... Args>
+  iterator emplace_hint(const_iterator hint, Args&&... args)
+  {
+    PairType pair(std::forward<Args>(args)...);
+    auto const it = detail::uniqueHintedInsertionPoint(
+        this->container, hint, pair.first, this->comp, detail::PairFirst{});
+    if (this->holds(it, pair.first))
+      return it;
+    return this->container.insert(it, std::move(pair));
+  }
+  /** In-place insertion of a value for key.
+   * Nothing is constructed if the key is already present.
+   */
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(KeyType const& key, Args&&... args)
+  {
+    return this->tryEmplace(key, std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(KeyType&& key, Args&&... args)
+  {
+    return this->tryEmplace(std::move(key), std::forward<Args>(args)...);
+  }
+  /// Inserts obj for key, or assigns it to the existing value.
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(KeyType const& key, M&& obj)
+  {
+    auto const ret = this->tryEmplace(key, std::forward<M>(obj));
+    if (!ret.second)
+      ret.first->second = std::forward<M>(obj);
+    return ret;
+  }
+
+  /** Bulk insertion of an unsorted range.
+   * Elements are appended, sorted once and merged with the existing ones.
+   * With DuplicatePolicy::KeepFirst, keys already in the SmallFlatMap are
+   * left untouched. With DuplicatePolicy::KeepLast, they are overwritten.
+   */
+  template <typename InputIt>
+  void insert(InputIt first,
+              InputIt last,
+              DuplicatePolicy policy = DuplicatePolicy::KeepFirst)
+  {
+    auto const sortedCount = this->container.size();
+    this->container.insert(this->container.end(), first, last);
+    this->sortAndDedup(sortedCount, policy);
+  }
+
+private:
+  /** Restores the invariants after elements were appended.
+   * The first `sortedCount` elements must already be sorted and unique.
+   */
+  void sortAndDedup(size_type sortedCount, DuplicatePolicy policy)
+  {
+    detail::sortTail(
+        this->container, sortedCount, this->comp, detail::PairFirst{});
+    detail::dedupSorted(
+        this->container, this->comp, detail::PairFirst{}, policy);
+  }
+  bool isSortedUnique() const noexcept
+  {
+    return detail::isSortedOn(
+        this->begin(), this->end(), this->comp, detail::PairFirst{}, true);
+  }
+  /// Whether it points to the element with given key.
+  template <typename K>
+  bool holds(const_iterator it, K const& key) const noexcept
+  {
+    return it != this->end() && detail::isKeyEqual(this->comp, key, it->first);
+  }
+  template <typename K>
+  iterator lowerBound(K const& key) noexcept
+  {
+    return detail::lowerBound(
+        this->begin(), this->end(), key, this->comp, detail::PairFirst{});
+  }
+  template <typename K>
+  const_iterator lowerBound(K const& key) const noexcept
+  {
+    return detail::lowerBound(
+        this->begin(), this->end(), key, this->comp, detail::PairFirst{});
+  }
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> tryEmplace(K&& key, Args&&... args)
+  {
+    auto const it = detail::uniqueInsertionPoint(
+        this->container, key, this->comp, detail::PairFirst{});
+    if (this->holds(it, key))
+      return {it, false};
+    return {this->container.emplace(
+                it,
+                std::piecewise_construct,
+                std::forward_as_tuple(std::forward<K>(key)),
+                std::forward_as_tuple(std::forward<Args>(args)...)),
+            true};
+  }
+
+  ContainerType container;
+  Comp comp;
+};
+
+/** Removes the elements for which pred(element) is true.
+ * Returns the number of removed elements.
+ */
+template <typename KeyType,
+          typename ValueType,
+          std::size_t N,
+          typename Comp,
+          typename Pred>
+typename SmallFlatMap<KeyType, ValueType, N, Comp>::size_type erase_if(
+    SmallFlatMap<KeyType, ValueType, N, Comp>& map, Pred pred)
+{
+  using PairType = typename SmallFlatMap<KeyType, ValueType, N, Comp>::PairType;
+  return map.retain([&](PairType const& pair) { return !pred(pair); });
+}
+}
+
+#endif /* !KOUH_SMALLFLATMAP_HPP_ */
@@ -0,0 +1,179 @@
+#ifndef KOUH_SMALLFLATUNORDEREDSET_HPP_
+#define KOUH_SMALLFLATUNORDEREDSET_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <utility>
+
+#include <kouh/SmallVector.hpp>
+
+namespace kouh
+{
+/** A FlatUnorderedSet that keeps up to N values inside the object.
+ *
+ * Values are stored in a SmallVector, so that a SmallFlatUnorderedSet with
+ * at most N values never allocates. It behaves like a FlatUnorderedSet
+ * otherwise.
+ */
+template <typename ValueType,
+          std::size_t N,
+          typename Comparator = std::equal_to<ValueType>>
+class SmallFlatUnorderedSet
+{
+public:
+  using value_type = ValueType;
+  using ContainerType = SmallVector<value_type, N>;
+  using size_type = typename ContainerType::size_type;
+  using iterator = typename ContainerType::iterator;
+  using const_iterator = typename ContainerType::const_iterator;
+  using reverse_iterator = typename ContainerType::reverse_iterator;
+  using const_reverse_iterator = typename ContainerType::const_reverse_iterator;
+
+  SmallFlatUnorderedSet() noexcept = default;
+  SmallFlatUnorderedSet(std::initializer_list<value_type> l) : container{l}
+  {
+  }
+  SmallFlatUnorderedSet(SmallFlatUnorderedSet const& b) = default;
+  SmallFlatUnorderedSet(SmallFlatUnorderedSet&& b) = default;
+  ~SmallFlatUnorderedSet() noexcept = default;
+
+  SmallFlatUnorderedSet& operator=(SmallFlatUnorderedSet const& rhs) = default;
+  SmallFlatUnorderedSet& operator=(SmallFlatUnorderedSet&& rhs) = default;
+
+  size_type size() const noexcept
+  {
+    return this->container.size();
+  }
+  bool empty() const noexcept
+  {
+    return this->container.empty();
+  }
+  /// Returns true if the values are stored inside the object.
+  bool isInline() const noexcept
+  {
+    return this->container.isInline();
+  }
+
+  iterator begin() noexcept
+  {
+    return this->container.begin();
+  }
+  iterator end() noexcept
+  {
+    return this->container.end();
+  }
+  const_iterator begin() const noexcept
+  {
+    return this->container.begin();
+  }
+  const_iterator end() const noexcept
+  {
+    return this->container.end();
+  }
+  const_iterator cbegin() const noexcept
+  {
+    return this->container.cbegin();
+  }
+  const_iterator cend() const noexcept
+  {
+    return this->container.cend();
+  }
+
+  iterator find(value_type const& val) noexcept
+  {
+    return std::find_if(
+        this->begin(), this->end(), [&](value_type const& container_value) {
+          return this->equals_pred(container_value, val);
+        });
+  }
+  const_iterator find(value_type const& val) const noexcept
+  {
+    return std::find_if(
+        this->begin(), this->end(), [&](value_type const& container_value) {
+          return this->equals_pred(container_value, val);
+        });
+  }
+  size_type count(value_type const& val) const noexcept
+  {
+    return this->contains(val) ? 1 : 0;
+  }
+  bool contains(value_type const& val) const noexcept
+  {
+    return this->find(val) != this->end();
+  }
+
+  size_type erase(value_type const& val)
+  {
+    auto const it = this->find(val);
+    if (it == this->end())
+      return 0;
+    this->erase(it);
+    return 1;
+  }
+  iterator erase(iterator it)
+  {
+    // Move last element where deletion happens.
+    auto const last_it = this->end() - 1;
+    if (it != last_it)
+      *it = std::move(*last_it);
+    this->container.pop_back();
+    return it;
+  }
+
+  /// Removes every value. Heap storage, if any, is kept.
+  void clear()
+  {
+    this->container.clear();
+  }
+  /** Keeps only the values for which pred(value) is true.
+   * Returns the number of removed values.
+   */
+  template <typename Pred>
+  size_type retain(Pred pred)
+  {
+    auto const last = std::remove_if(
+        this->begin(), this->end(), [&](value_type const& value) {
+          return !pred(value);
+        });
+    auto const count = static_cast<size_type>(this->end() - last);
+    this->container.erase(last, this->end());
+    return count;
+  }
+
+  /** In-place insertion.
+   * The value is built before searching, so that inserting a duplicate into
+   * a full inline set does not spill it to the heap.
+   */
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args)
+  {
+    value_type value(std::forward<Args>(args)...);
+    auto const it = this->find(value);
+    if (it != this->end())
+      return {it, false};
+    this->container.emplace_back(std::move(value));
+    return {this->end() - 1, true};
+  }
+
+private:
+  ContainerType container;
+  Comparator equals_pred;
+};
+
+/** Removes the values for which pred(value) is true.
+ * Returns the number of removed values.
+ */
+template <typename ValueType,
+          std::size_t N,
+          typename Comparator,
+          typename Pred>
+typename SmallFlatUnorderedSet<ValueType, N, Comparator>::size_type erase_if(
+    SmallFlatUnorderedSet<ValueType, N, Comparator>& set, Pred pred)
+{
+  return set.retain([&](ValueType const& value) { return !pred(value); });
+}
+}
+
+#endif /* !KOUH_SMALLFLATUNORDEREDSET_HPP_ */
@@ -0,0 +1,347 @@
+#ifndef KOUH_SMALLVECTOR_HPP_
+#define KOUH_SMALLVECTOR_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace kouh
+{
+/** A std::vector that stores up to N elements inside the object.
+ *
+ * Elements only go to the heap once there are more than N of them, so that
+ * small vectors never allocate. Once spilled, the storage stays on the heap
+ * until the SmallVector is destroyed or moved from.
+ *
+ * Iterators are plain pointers. Moving a SmallVector whose elements are
+ * inline moves them one by one and thus invalidates iterators, unlike
+ * std::vector.
+ */
+template <typename T, std::size_t N>
+class SmallVector
+{
+  static_assert(N > 0, "A SmallVector needs room for at least one element");
+
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = T&;
+  using const_reference = T const&;
+  using pointer = T*;
+  using const_pointer = T const*;
+  using iterator = T*;
+  using const_iterator = T const*;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  /// Number of elements stored without allocating.
+  static constexpr size_type INLINE_CAPACITY = N;
+
+  SmallVector() noexcept : ptr{this->inlineData()}, count{0}, cap{N}
+  {
+  }
+  SmallVector(std::initializer_list<T> l) : SmallVector()
+  {
+    this->insert(this->end(), l.begin(), l.end());
+  }
+  template <typename InputIt>
+  SmallVector(InputIt first, InputIt last) : SmallVector()
+  {
+    this->insert(this->end(), first, last);
+  }
+  SmallVector(SmallVector const& b) : SmallVector()
+  {
+    this->reserve(b.size());
+    std::uninitialized_copy(b.begin(), b.end(), this->ptr);
+    this->count = b.count;
+  }
+  SmallVector(SmallVector&& b) noexcept(
+      std::is_nothrow_move_constructible<T>::value)
+    : SmallVector()
+  {
+    this->takeFrom(b);
+  }
+  ~SmallVector() noexcept
+  {
+    this->clear();
+    this->release();
+  }
+
+  SmallVector& operator=(SmallVector const& rhs)
+  {
+    if (this != &rhs)
+    {
+      this->clear();
+      this->reserve(rhs.size());
+      std::uninitialized_copy(rhs.begin(), rhs.end(), this->ptr);
+      this->count = rhs.count;
+    }
+    return *this;
+  }
+  SmallVector& operator=(SmallVector&& rhs) noexcept(
+      std::is_nothrow_move_constructible<T>::value)
+  {
+    if (this != &rhs)
+    {
+      this->clear();
+      this->release();
+      this->takeFrom(rhs);
+    }
+    return *this;
+  }
+
+  size_type size() const noexcept
+  {
+    return this->count;
+  }
+  bool empty() const noexcept
+  {
+    return this->count == 0;
+  }
+  size_type capacity() const noexcept
+  {
+    return this->cap;
+  }
+  /// Returns true if the elements are stored inside the object.
+  bool isInline() const noexcept
+  {
+    return this->ptr == this->inlineData();
+  }
+
+  iterator begin() noexcept
+  {
+    return this->ptr;
+  }
+  iterator end() noexcept
+  {
+    return this->ptr + this->count;
+  }
+  const_iterator begin() const noexcept
+  {
+    return this->ptr;
+  }
+  const_iterator end() const noexcept
+  {
+    return this->ptr + this->count;
+  }
+  const_iterator cbegin() const noexcept
+  {
+    return this->ptr;
+  }
+  const_iterator cend() const noexcept
+  {
+    return this->ptr + this->count;
+  }
+
+  T* data() noexcept
+  {
+    return this->ptr;
+  }
+  T const* data() const noexcept
+  {
+    return this->ptr;
+  }
+  T& operator[](size_type idx) noexcept
+  {
+    return this->ptr[idx];
+  }
+  T const& operator[](size_type idx) const noexcept
+  {
+    return this->ptr[idx];
+  }
+  T& front() noexcept
+  {
+    return this->ptr[0];
+  }
+  T const& front() const noexcept
+  {
+    return this->ptr[0];
+  }
+  T& back() noexcept
+  {
+    return this->ptr[this->count - 1];
+  }
+  T const& back() const noexcept
+  {
+    return this->ptr[this->count - 1];
+  }
+
+  /// Makes room for n elements. Never shrinks.
+  void reserve(size_type n)
+  {
+    if (n > this->cap)
+      this->reallocate(n);
+  }
+  template <typename... Args>
+  T& emplace_back(Args&&... args)
+  {
+    if (this->count == this->cap)
+    {
+      // args may refer to an element, build before moving them.
+      T value(std::forward<Args>(args)...);
+      this->reallocate(this->nextCapacity());
+      ::new (static_cast<void*>(this->end())) T(std::move(value));
+    }
+    else
+      ::new (static_cast<void*>(this->end())) T(std::forward<Args>(args)...);
+    ++this->count;
+    return this->back();
+  }
+  void push_back(T const& value)
+  {
+    this->emplace_back(value);
+  }
+  void push_back(T&& value)
+  {
+    this->emplace_back(std::move(value));
+  }
+  void pop_back() noexcept
+  {
+    this->back().~T();
+    --this->count;
+  }
+  /// Constructs an element before pos. Returns an iterator to it.
+  template <typename... Args>
+  iterator emplace(const_iterator pos, Args&&... args)
+  {
+    auto const idx = pos - this->cbegin();
+    if (pos == this->cend())
+    {
+      this->emplace_back(std::forward<Args>(args)...);
+      return this->begin() + idx;
+    }
+    T value(std::forward<Args>(args)...);
+    if (this->count == this->cap)
+      this->reallocate(this->nextCapacity());
+    auto const where = this->begin() + idx;
+    ::new (static_cast<void*>(this->end())) T(std::move(this->back()));
+    ++this->count;
+    std::move_backward(where, this->end() - 2, this->end() - 1);
+    *where = std::move(value);
+    return where;
+  }
+  iterator insert(const_iterator pos, T const& value)
+  {
+    return this->emplace(pos, value);
+  }
+  iterator insert(const_iterator pos, T&& value)
+  {
+    return this->emplace(pos, std::move(value));
+  }
+  /// Inserts [first, last) before pos. Returns an iterator to the first one.
+  template <typename InputIt>
+  iterator insert(const_iterator pos, InputIt first, InputIt last)
+  {
+    auto const idx = pos - this->cbegin();
+    auto const oldCount = static_cast<difference_type>(this->count);
+    for (; first != last; ++first)
+      this->emplace_back(*first);
+    std::rotate(this->begin() + idx, this->begin() + oldCount, this->end());
+    return this->begin() + idx;
+  }
+  iterator erase(const_iterator pos) noexcept
+  {
+    return this->erase(pos, pos + 1);
+  }
+  /// Removes [first, last). The following elements are moved once.
+  iterator erase(const_iterator first, const_iterator last) noexcept
+  {
+    auto const where = this->begin() + (first - this->cbegin());
+    auto const n = static_cast<size_type>(last - first);
+    std::move(where + n, this->end(), where);
+    for (size_type i = 0; i < n; ++i)
+      this->pop_back();
+    return where;
+  }
+  /// Destroys every element. The storage is kept.
+  void clear() noexcept
+  {
+    while (this->count != 0)
+      this->pop_back();
+  }
+
+private:
+  using Storage = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+  T* inlineData() noexcept
+  {
+    return reinterpret_cast<T*>(this->storage);
+  }
+  T const* inlineData() const noexcept
+  {
+    return reinterpret_cast<T const*>(this->storage);
+  }
+  size_type nextCapacity() const noexcept
+  {
+    return this->cap * 2;
+  }
+  /// Moves the elements to a heap buffer of n elements.
+  void reallocate(size_type n)
+  {
+    std::allocator<T> alloc;
+    auto const newPtr = alloc.allocate(n);
+    size_type moved = 0;
+    try
+    {
+      for (; moved < this->count; ++moved)
+        ::new (static_cast<void*>(newPtr + moved))
+            T(std::move_if_noexcept(this->ptr[moved]));
+    }
+    catch (...)
+    {
+      for (size_type i = 0; i < moved; ++i)
+        newPtr[i].~T();
+      alloc.deallocate(newPtr, n);
+      throw;
+    }
+    auto const oldCount = this->count;
+    this->clear();
+    this->release();
+    this->ptr = newPtr;
+    this->count = oldCount;
+    this->cap = n;
+  }
+  /// Frees the heap buffer, if any. Elements must have been destroyed.
+  void release() noexcept
+  {
+    if (!this->isInline())
+      std::allocator<T>{}.deallocate(this->ptr, this->cap);
+    this->ptr = this->inlineData();
+    this->cap = N;
+  }
+  /// Takes the elements of b, which is left empty. This must be empty.
+  void takeFrom(SmallVector& b) noexcept(
+      std::is_nothrow_move_constructible<T>::value)
+  {
+    if (b.isInline())
+    {
+      for (auto& value : b)
+      {
+        ::new (static_cast<void*>(this->end())) T(std::move(value));
+        ++this->count;
+      }
+      b.clear();
+      return;
+    }
+    this->ptr = b.ptr;
+    this->count = b.count;
+    this->cap = b.cap;
+    b.ptr = b.inlineData();
+    b.count = 0;
+    b.cap = N;
+  }
+
+  T* ptr;
+  size_type count;
+  size_type cap;
+  Storage storage[N];
+};
+}
+
+#endif /* !KOUH_SMALLVECTOR_HPP_ */
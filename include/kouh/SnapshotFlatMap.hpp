@@ -0,0 +1,353 @@
+#ifndef KOUH_SNAPSHOTFLATMAP_HPP_
+#define KOUH_SNAPSHOTFLATMAP_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <kouh/FlatMap.hpp>
+#include <kouh/Prefetch.hh>
+
+namespace kouh
+{
+/** A FlatMap read by many threads and updated by read-copy-update.
+ *
+ * Readers never lock: snapshot() pins the current version of the map and
+ * returns it as an immutable Snapshot, in a bounded number of steps whatever
+ * the writers do. Writers copy the current version, apply their changes to
+ * the copy and publish it atomically. Readers that pinned the previous
+ * version keep reading it, while new snapshots see the new one.
+ *
+ * An update copies the whole map, so batch modifications in one call to
+ * update(). Writers are serialized by a mutex.
+ *
+ * Replaced versions are freed by the writer once no Snapshot holds them: at
+ * the end of the update that replaced them if they were not pinned, or by a
+ * later update or call to reclaim(). Readers never free memory.
+ *
+ * Taking a Snapshot writes to counters shared by all readers. Threads that
+ * read in a loop should use a Reader instead, which keeps its Snapshot and
+ * only takes a new one when a new version has been published.
+ *
+ * No Snapshot or Reader may outlive the SnapshotFlatMap.
+ */
+template <typename KeyType,
+          typename ValueType,
+          typename Comp = std::less<KeyType>,
+          typename Alloc = std::allocator<std::pair<KeyType, ValueType>>,
+          typename Search = BinarySearch>
+class SnapshotFlatMap
+{
+  struct Version;
+
+public:
+  using MapType = FlatMap<KeyType, ValueType, Comp, Alloc, Search>;
+  using PairType = typename MapType::PairType;
+  using size_type = typename MapType::size_type;
+  class Snapshot;
+  class Reader;
+
+  SnapshotFlatMap() : SnapshotFlatMap(MapType{})
+  {
+  }
+  explicit SnapshotFlatMap(MapType map)
+    : current{new Version{std::move(map), 0}}
+  {
+  }
+  SnapshotFlatMap(SnapshotFlatMap const& b) = delete;
+  SnapshotFlatMap(SnapshotFlatMap&& b) = delete;
+  ~SnapshotFlatMap() noexcept
+  {
+    delete this->current.load(std::memory_order_relaxed);
+  }
+
+  SnapshotFlatMap& operator=(SnapshotFlatMap const& rhs) = delete;
+  SnapshotFlatMap& operator=(SnapshotFlatMap&& rhs) = delete;
+
+  /// Pins the current version of the map. Wait-free.
+  Snapshot snapshot() const noexcept;
+
+  /** Publishes a copy of the current map, modified by f.
+   * f is called with a MapType&. If it throws, nothing is published.
+   * Returns the number of the published version.
+   */
+  template <typename F>
+  std::uint64_t update(F&& f);
+  /** Publishes map, which replaces the current one.
+   * Returns the number of the published version.
+   */
+  std::uint64_t publish(MapType map);
+
+  /** Frees the replaced versions no Snapshot holds anymore.
+   * Returns the number of replaced versions that are still held.
+   */
+  size_type reclaim();
+
+private:
+  struct Version
+  {
+    Version(MapType m, std::uint64_t n) : map(std::move(m)), number(n)
+    {
+    }
+
+    // Read by every lookup.
+    MapType const map;
+    std::uint64_t const number;
+    // Keeps the writes to readers from invalidating the line of map.
+    char padding[detail::CACHE_LINE_SIZE];
+    /// Number of Snapshots holding this version.
+    std::atomic<size_type> readers{0};
+    char padding2[detail::CACHE_LINE_SIZE];
+  };
+
+  std::uint64_t publishLocked(std::unique_ptr<Version> version);
+  void reclaimLocked() noexcept;
+  void waitForAcquisitions() noexcept;
+
+  // Read by every reader, written by writers only.
+  std::atomic<Version*> current;
+  /// Selects the counter of acquiring below new snapshots increment.
+  std::atomic<std::uint64_t> epoch{0};
+  char padding[detail::CACHE_LINE_SIZE];
+  /** Number of snapshots between reading current and incrementing the
+   * readers of its version, by parity of the epoch they started in.
+   */
+  mutable std::atomic<size_type> acquiring[2] = {};
+  char padding2[detail::CACHE_LINE_SIZE];
+  // Writers only.
+  std::mutex writer;
+  std::vector<std::unique_ptr<Version>> replaced;
+};
+
+/** A pinned version of a SnapshotFlatMap.
+ *
+ * The map it points to never changes, and stays alive until the Snapshot is
+ * destroyed. An empty Snapshot, default-constructed or moved from, points to
+ * no map.
+ */
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+class SnapshotFlatMap<KeyType, ValueType, Comp, Alloc, Search>::Snapshot
+{
+public:
+  Snapshot() noexcept = default;
+  Snapshot(Snapshot const& b) = delete;
+  Snapshot(Snapshot&& b) noexcept : version(b.version)
+  {
+    b.version = nullptr;
+  }
+  ~Snapshot() noexcept
+  {
+    if (this->version != nullptr)
+      this->version->readers.fetch_sub(1, std::memory_order_release);
+  }
+
+  Snapshot& operator=(Snapshot const& rhs) = delete;
+  Snapshot& operator=(Snapshot&& rhs) noexcept
+  {
+    Snapshot tmp{std::move(rhs)};
+    std::swap(this->version, tmp.version);
+    return *this;
+  }
+
+  MapType const& operator*() const noexcept
+  {
+    return this->version->map;
+  }
+  MapType const* operator->() const noexcept
+  {
+    return &this->version->map;
+  }
+  /// Returns the number of the version, which each update increments.
+  std::uint64_t number() const noexcept
+  {
+    return this->version->number;
+  }
+  explicit operator bool() const noexcept
+  {
+    return this->version != nullptr;
+  }
+
+private:
+  friend class SnapshotFlatMap;
+  friend class Reader;
+
+  explicit Snapshot(Version* v) noexcept : version(v)
+  {
+  }
+
+  Version* version = nullptr;
+};
+
+/** Keeps a Snapshot of a SnapshotFlatMap for a thread that reads repeatedly.
+ *
+ * get() returns the kept Snapshot, and only takes a new one if a version was
+ * published since. Reading an unchanged map then costs a single load of a
+ * pointer that is rarely written, instead of writes to shared counters.
+ *
+ * The kept version stays alive until the next call to get() that sees a new
+ * one, so threads that stop reading should destroy or refresh their Reader.
+ * A Reader is used by one thread at a time.
+ */
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+class SnapshotFlatMap<KeyType, ValueType, Comp, Alloc, Search>::Reader
+{
+public:
+  explicit Reader(SnapshotFlatMap const& m) noexcept
+    : map(&m), kept(m.snapshot())
+  {
+  }
+
+  /// Returns a Snapshot of the latest version.
+  Snapshot const& get() noexcept
+  {
+    // The kept version cannot be freed, so its address cannot be reused by
+    // a newer one.
+    if (this->map->current.load(std::memory_order_acquire) !=
+        this->kept.version)
+      this->kept = this->map->snapshot();
+    return this->kept;
+  }
+
+private:
+  SnapshotFlatMap const* map;
+  Snapshot kept;
+};
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+auto SnapshotFlatMap<KeyType, ValueType, Comp, Alloc, Search>::snapshot()
+    const noexcept -> Snapshot
+{
+  // A writer frees a replaced version only after both counters have been
+  // seen at zero since it was replaced. The version loaded here is therefore
+  // alive until its readers are incremented.
+  auto const parity = this->epoch.load() & 1;
+  this->acquiring[parity].fetch_add(1);
+  auto const version = this->current.load();
+  version->readers.fetch_add(1, std::memory_order_relaxed);
+  this->acquiring[parity].fetch_sub(1, std::memory_order_release);
+  return Snapshot{version};
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+template <typename F>
+std::uint64_t
+SnapshotFlatMap<KeyType, ValueType, Comp, Alloc, Search>::update(F&& f)
+{
+  std::lock_guard<std::mutex> lock{this->writer};
+  MapType map{this->current.load(std::memory_order_relaxed)->map};
+  std::forward<F>(f)(map);
+  auto const number = this->current.load(std::memory_order_relaxed)->number;
+  return this->publishLocked(
+      std::unique_ptr<Version>{new Version{std::move(map), number + 1}});
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+std::uint64_t
+SnapshotFlatMap<KeyType, ValueType, Comp, Alloc, Search>::publish(MapType map)
+{
+  std::lock_guard<std::mutex> lock{this->writer};
+  auto const number = this->current.load(std::memory_order_relaxed)->number;
+  return this->publishLocked(
+      std::unique_ptr<Version>{new Version{std::move(map), number + 1}});
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+auto SnapshotFlatMap<KeyType, ValueType, Comp, Alloc, Search>::reclaim()
+    -> size_type
+{
+  std::lock_guard<std::mutex> lock{this->writer};
+  this->reclaimLocked();
+  return this->replaced.size();
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+std::uint64_t
+SnapshotFlatMap<KeyType, ValueType, Comp, Alloc, Search>::publishLocked(
+    std::unique_ptr<Version> version)
+{
+  auto const number = version->number;
+  // Nothing may throw once the version is published.
+  this->replaced.reserve(this->replaced.size() + 1);
+  this->replaced.emplace_back(this->current.exchange(version.release()));
+  this->waitForAcquisitions();
+  this->reclaimLocked();
+  return number;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+void SnapshotFlatMap<KeyType, ValueType, Comp, Alloc, Search>::
+    reclaimLocked() noexcept
+{
+  // Once replaced and past waitForAcquisitions, a version gets no new
+  // readers: a count of zero is final.
+  auto const end = std::remove_if(
+      this->replaced.begin(),
+      this->replaced.end(),
+      [](std::unique_ptr<Version> const& version) {
+        return version->readers.load(std::memory_order_acquire) == 0;
+      });
+  this->replaced.erase(end, this->replaced.end());
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename Comp,
+          typename Alloc,
+          typename Search>
+void SnapshotFlatMap<KeyType, ValueType, Comp, Alloc, Search>::
+    waitForAcquisitions() noexcept
+{
+  // A snapshot that loaded the replaced version started before it was
+  // replaced, in the current epoch or, if it read the epoch late, in the one
+  // before. Moving through two epochs waits for both counters to drain,
+  // while new snapshots count on the other one. This only waits for a few
+  // instructions of each snapshot, never for Snapshots to be released.
+  for (int i = 0; i < 2; ++i)
+  {
+    auto const parity = this->epoch.fetch_add(1) & 1;
+    while (this->acquiring[parity].load() != 0)
+      std::this_thread::yield();
+  }
+}
+}
+
+#endif /* !KOUH_SNAPSHOTFLATMAP_HPP_ */
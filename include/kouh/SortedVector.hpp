@@ -0,0 +1,275 @@
+#ifndef KOUH_SORTEDVECTOR_HPP_
+#define KOUH_SORTEDVECTOR_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <kouh/LowerBound.hpp>
+#include <kouh/ParallelBuild.hpp>
+
+namespace kouh
+{
+/** Which element to keep when a bulk insertion meets duplicate keys.
+ *
+ * KeepFirst behaves like repeated calls to emplace: the first element seen
+ * with a given key (or the one already in the container) is kept.
+ * KeepLast behaves like repeated assignments: the last element seen wins.
+ */
+enum class DuplicatePolicy
+{
+  KeepFirst,
+  KeepLast
+};
+
+/** Tag type to construct containers from data that is already sorted.
+ *
+ * The data must be sorted according to the container's comparator and must
+ * not contain duplicate keys. This is only checked in debug builds.
+ */
+struct sorted_unique_t
+{
+  explicit sorted_unique_t() = default;
+};
+constexpr sorted_unique_t sorted_unique{};
+
+/** Tag type to construct multi containers from data that is already sorted.
+ *
+ * The data must be sorted according to the container's comparator, and may
+ * contain duplicate keys. This is only checked in debug builds.
+ */
+struct sorted_equivalent_t
+{
+  explicit sorted_equivalent_t() = default;
+};
+constexpr sorted_equivalent_t sorted_equivalent{};
+
+namespace detail
+{
+/** Has a `type` member alias if Comp declares `is_transparent`.
+ *
+ * K is only there to make the check depend on a template parameter of the
+ * member function being declared, so that it is a SFINAE context.
+ */
+template <typename Comp, typename K, typename = void>
+struct EnableIfTransparent
+{
+};
+template <typename Comp, typename K>
+struct EnableIfTransparent<
+    Comp,
+    K,
+    typename std::conditional<true, void, typename Comp::is_transparent>::type>
+{
+  using type = void;
+};
+
+// Sorted vector core
+// The flat containers all store their elements in a std::vector sorted on
+// their key. The helpers below work on such vectors and are shared between
+// them. `proj` maps an element to its key, like for lowerBound.
+
+/// Returns whether neither a nor b is ordered before the other.
+template <typename Comp, typename A, typename B>
+inline bool isKeyEqual(Comp const& comp, A const& a, B const& b) noexcept
+{
+  return comp(a, b) == false && comp(b, a) == false;
+}
+
+/// Returns the first element whose key is greater than key.
+template <typename It, typename Key, typename Comp, typename Proj>
+inline It upperBound(It first,
+                     It last,
+                     Key const& key,
+                     Comp const& comp,
+                     Proj proj) noexcept
+{
+  using Element = typename std::iterator_traits<It>::value_type;
+  return std::upper_bound(
+      first, last, key, [&](Key const& keyp, Element const& element) {
+        return comp(keyp, proj(element));
+      });
+}
+
+/** Where an element with given key belongs in a container of unique keys.
+ *
+ * Keys often come in increasing order. Appending them needs no search, so
+ * the last element is checked first.
+ */
+template <typename Container, typename Key, typename Comp, typename Proj>
+inline typename Container::iterator uniqueInsertionPoint(Container& c,
+                                                         Key const& key,
+                                                         Comp const& comp,
+                                                         Proj proj) noexcept
+{
+  if (c.empty() || comp(proj(c.back()), key))
+    return c.end();
+  return lowerBound(c.begin(), c.end(), key, comp, proj);
+}
+
+/** Where an element with given key belongs in a container of equivalent
+ * keys. Like std::multimap, this is after the elements with the same key.
+ */
+template <typename Container, typename Key, typename Comp, typename Proj>
+inline typename Container::iterator equivalentInsertionPoint(
+    Container& c, Key const& key, Comp const& comp, Proj proj) noexcept
+{
+  if (c.empty() || !comp(key, proj(c.back())))
+    return c.end();
+  return upperBound(c.begin(), c.end(), key, comp, proj);
+}
+
+/// Same as uniqueInsertionPoint, but tries hint before anything else.
+template <typename Container, typename Key, typename Comp, typename Proj>
+inline typename Container::iterator uniqueHintedInsertionPoint(
+    Container& c,
+    typename Container::const_iterator hint,
+    Key const& key,
+    Comp const& comp,
+    Proj proj) noexcept
+{
+  auto const first = c.cbegin();
+  auto const last = c.cend();
+  if ((hint == first || comp(proj(*(hint - 1)), key)) &&
+      (hint == last || !comp(proj(*hint), key)))
+    return c.begin() + (hint - first);
+  return uniqueInsertionPoint(c, key, comp, proj);
+}
+
+/** Same as equivalentInsertionPoint, but tries hint before anything else.
+ * Like std::multimap, the element goes right before hint when it can.
+ */
+template <typename Container, typename Key, typename Comp, typename Proj>
+inline typename Container::iterator equivalentHintedInsertionPoint(
+    Container& c,
+    typename Container::const_iterator hint,
+    Key const& key,
+    Comp const& comp,
+    Proj proj) noexcept
+{
+  auto const first = c.cbegin();
+  auto const last = c.cend();
+  if ((hint == first || !comp(key, proj(*(hint - 1)))) &&
+      (hint == last || !comp(proj(*hint), key)))
+    return c.begin() + (hint - first);
+  return equivalentInsertionPoint(c, key, comp, proj);
+}
+
+/** Sorts the elements appended after the first `sortedCount` ones, which
+ * must already be sorted, and merges them with the rest.
+ *
+ * Both sorts are stable so that, among equal keys, elements keep their order
+ * of arrival. Many new elements are sorted on several threads, see
+ * ParallelBuild.hpp.
+ */
+template <typename Container, typename Comp, typename Proj>
+void sortTail(Container& c,
+              typename Container::size_type sortedCount,
+              Comp const& comp,
+              Proj proj)
+{
+  using Element = typename Container::value_type;
+  auto const keyLess = [&](Element const& a, Element const& b) {
+    return comp(proj(a), proj(b));
+  };
+  using Difference = typename Container::difference_type;
+  auto const middle = c.begin() + static_cast<Difference>(sortedCount);
+  parallelStableSort(middle, c.end(), keyLess);
+  std::inplace_merge(c.begin(), middle, c.end(), keyLess);
+}
+
+/** Removes elements with duplicate keys from sorted [first, last).
+ * policy tells which element of a run of equal keys is kept. Returns the end
+ * of the elements kept.
+ */
+template <typename It, typename Comp, typename Proj>
+It dedupRange(It first,
+              It last,
+              Comp const& comp,
+              Proj proj,
+              DuplicatePolicy policy)
+{
+  if (first == last)
+    return last;
+  auto out = first;
+  auto it = first;
+  while (++it != last)
+  {
+    if (comp(proj(*out), proj(*it)))
+    {
+      if (++out != it)
+        *out = std::move(*it);
+    }
+    else if (policy == DuplicatePolicy::KeepLast)
+      *out = std::move(*it);
+  }
+  return ++out;
+}
+
+/** Removes elements with duplicate keys from a sorted container.
+ * policy tells which element of a run of equal keys is kept.
+ *
+ * Large containers are cut in chunks that do not split runs of equal keys,
+ * deduplicated on several threads, then moved back together.
+ */
+template <typename Container, typename Comp, typename Proj>
+void dedupSorted(Container& c,
+                 Comp const& comp,
+                 Proj proj,
+                 DuplicatePolicy policy)
+{
+  using Difference = typename Container::difference_type;
+  using Iterator = typename Container::iterator;
+  auto const n = c.size();
+  auto const chunks = buildThreads(n);
+  if (chunks <= 1)
+  {
+    c.erase(dedupRange(c.begin(), c.end(), comp, proj, policy), c.end());
+    return;
+  }
+
+  auto const first = c.begin();
+  auto const last = c.end();
+  std::vector<Iterator> bounds{first};
+  for (std::size_t i = 1; i < chunks; ++i)
+  {
+    auto bound = std::max(
+        bounds.back(), first + static_cast<Difference>(n * i / chunks));
+    while (bound != first && bound != last &&
+           !comp(proj(*(bound - 1)), proj(*bound)))
+      ++bound;
+    bounds.push_back(bound);
+  }
+  bounds.push_back(last);
+  std::vector<Iterator> ends(chunks);
+  parallelFor(chunks, [&](std::size_t i) {
+    ends[i] = dedupRange(bounds[i], bounds[i + 1], comp, proj, policy);
+  });
+
+  auto out = ends[0];
+  for (std::size_t i = 1; i < chunks; ++i)
+    out = out == bounds[i] ? ends[i] : std::move(bounds[i], ends[i], out);
+  c.erase(out, last);
+}
+
+/** Whether [first, last) is sorted, and has no duplicate keys if unique is
+ * set. Used for debug assertions.
+ */
+template <typename It, typename Comp, typename Proj>
+bool isSortedOn(It first, It last, Comp const& comp, Proj proj, bool unique)
+{
+  using Element = typename std::iterator_traits<It>::value_type;
+  return std::adjacent_find(first,
+                            last,
+                            [&](Element const& a, Element const& b) {
+                              return unique ? !comp(proj(a), proj(b)) :
+                                              comp(proj(b), proj(a));
+                            }) == last;
+}
+}
+}
+
+#endif /* !KOUH_SORTEDVECTOR_HPP_ */
@@ -0,0 +1,389 @@
+#ifndef KOUH_SPLITFLATMAP_HPP_
+#define KOUH_SPLITFLATMAP_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <kouh/FlatMap.hpp>
+#include <kouh/LowerBound.hpp>
+
+namespace kouh
+{
+namespace detail
+{
+/** Iterator over a SplitFlatMap.
+ *
+ * Walks the key and value vectors in lockstep. Dereferencing yields a
+ * std::pair of references rather than a reference to a pair, since no such
+ * pair exists in memory.
+ *
+ * Forward and stronger iterators must have a real reference type, so this
+ * one is only advertised as an input iterator. It still has the operations
+ * of a random access iterator, for code that knows it is a proxy.
+ */
+template <typename KeyType, typename ValueType>
+class SplitFlatMapIterator
+{
+public:
+  using iterator_category = std::input_iterator_tag;
+  using value_type =
+      std::pair<KeyType, typename std::remove_const<ValueType>::type>;
+  using difference_type = std::ptrdiff_t;
+  using reference = std::pair<KeyType const&, ValueType&>;
+
+  /// Gives operator-> something to point to.
+  class pointer
+  {
+  public:
+    explicit pointer(reference r) noexcept : ref{r}
+    {
+    }
+    reference* operator->() noexcept
+    {
+      return &this->ref;
+    }
+
+  private:
+    reference ref;
+  };
+
+  SplitFlatMapIterator() noexcept : key{nullptr}, value{nullptr}
+  {
+  }
+  SplitFlatMapIterator(KeyType const* k, ValueType* v) noexcept
+    : key{k}, value{v}
+  {
+  }
+  /// Allows conversion from iterator to const_iterator.
+  template <typename OtherValueType,
+            typename = typename std::enable_if<
+                std::is_convertible<OtherValueType*, ValueType*>::value>::type>
+  SplitFlatMapIterator(
+      SplitFlatMapIterator<KeyType, OtherValueType> const& b) noexcept
+    : key{b.keyPtr()}, value{b.valuePtr()}
+  {
+  }
+
+  reference operator*() const noexcept
+  {
+    return reference{*this->key, *this->value};
+  }
+  pointer operator->() const noexcept
+  {
+    return pointer{**this};
+  }
+  reference operator[](difference_type n) const noexcept
+  {
+    return *(*this + n);
+  }
+
+  SplitFlatMapIterator& operator++() noexcept
+  {
+    ++this->key;
+    ++this->value;
+    return *this;
+  }
+  SplitFlatMapIterator operator++(int) noexcept
+  {
+    auto ret = *this;
+    ++*this;
+    return ret;
+  }
+  SplitFlatMapIterator& operator--() noexcept
+  {
+    --this->key;
+    --this->value;
+    return *this;
+  }
+  SplitFlatMapIterator operator--(int) noexcept
+  {
+    auto ret = *this;
+    --*this;
+    return ret;
+  }
+  SplitFlatMapIterator& operator+=(difference_type n) noexcept
+  {
+    this->key += n;
+    this->value += n;
+    return *this;
+  }
+  SplitFlatMapIterator& operator-=(difference_type n) noexcept
+  {
+    return *this += -n;
+  }
+  SplitFlatMapIterator operator+(difference_type n) const noexcept
+  {
+    auto ret = *this;
+    return ret += n;
+  }
+  SplitFlatMapIterator operator-(difference_type n) const noexcept
+  {
+    auto ret = *this;
+    return ret -= n;
+  }
+  difference_type operator-(SplitFlatMapIterator const& b) const noexcept
+  {
+    return this->key - b.key;
+  }
+
+  bool operator==(SplitFlatMapIterator const& b) const noexcept
+  {
+    return this->key == b.key;
+  }
+  bool operator!=(SplitFlatMapIterator const& b) const noexcept
+  {
+    return this->key != b.key;
+  }
+  bool operator<(SplitFlatMapIterator const& b) const noexcept
+  {
+    return this->key < b.key;
+  }
+  bool operator>(SplitFlatMapIterator const& b) const noexcept
+  {
+    return this->key > b.key;
+  }
+  bool operator<=(SplitFlatMapIterator const& b) const noexcept
+  {
+    return this->key <= b.key;
+  }
+  bool operator>=(SplitFlatMapIterator const& b) const noexcept
+  {
+    return this->key >= b.key;
+  }
+
+  KeyType const* keyPtr() const noexcept
+  {
+    return this->key;
+  }
+  ValueType* valuePtr() const noexcept
+  {
+    return this->value;
+  }
+
+private:
+  KeyType const* key;
+  ValueType* value;
+};
+}
+
+/** A flattened associative container with keys and values stored apart.
+ *
+ * The SplitFlatMap behaves like a FlatMap, but keeps keys and values in two
+ * separate std::vectors (structure-of-arrays). Lookups only touch the densely
+ * packed keys, which pays off when values are large compared to keys.
+ *
+ * Since no std::pair is stored, dereferencing an iterator yields a
+ * std::pair<KeyType const&, ValueType&> by value.
+ */
+template <typename KeyType,
+          typename ValueType,
+          typename Comp = std::less<KeyType>>
+class SplitFlatMap
+{
+  static_assert(!std::is_same<KeyType, bool>::value &&
+                    !std::is_same<ValueType, bool>::value,
+                "std::vector<bool> does not provide contiguous storage");
+
+public:
+  using PairType = std::pair<KeyType, ValueType>;
+  using value_type = PairType;
+  using KeyContainerType = std::vector<KeyType>;
+  using ValueContainerType = std::vector<ValueType>;
+  using size_type = typename KeyContainerType::size_type;
+  using difference_type = typename KeyContainerType::difference_type;
+  using iterator = detail::SplitFlatMapIterator<KeyType, ValueType>;
+  using const_iterator =
+      detail::SplitFlatMapIterator<KeyType, ValueType const>;
+
+  SplitFlatMap() noexcept = default;
+  SplitFlatMap(std::initializer_list<PairType> l)
+  {
+    // Let FlatMap sort and deduplicate, then split the pairs.
+    auto pairs = FlatMap<KeyType, ValueType, Comp>{l}.extract();
+    this->keys_.reserve(pairs.size());
+    this->values_.reserve(pairs.size());
+    for (auto& pair : pairs)
+    {
+      this->keys_.push_back(std::move(pair.first));
+      this->values_.push_back(std::move(pair.second));
+    }
+  }
+  SplitFlatMap(SplitFlatMap const& b) = default;
+  SplitFlatMap(SplitFlatMap&& b) noexcept = default;
+  ~SplitFlatMap() noexcept = default;
+
+  SplitFlatMap& operator=(SplitFlatMap const& rhs) = default;
+  SplitFlatMap& operator=(SplitFlatMap&& rhs) noexcept = default;
+
+  /// Returns the number of elements in the SplitFlatMap.
+  size_type size() const noexcept
+  {
+    return this->keys_.size();
+  }
+  /// Returns true if there are no elements in the SplitFlatMap.
+  bool empty() const noexcept
+  {
+    return this->keys_.empty();
+  }
+
+  iterator begin() noexcept
+  {
+    return iterator{this->keys_.data(), this->values_.data()};
+  }
+  iterator end() noexcept
+  {
+    return this->begin() + static_cast<difference_type>(this->size());
+  }
+  const_iterator begin() const noexcept
+  {
+    return const_iterator{this->keys_.data(), this->values_.data()};
+  }
+  const_iterator end() const noexcept
+  {
+    return this->begin() + static_cast<difference_type>(this->size());
+  }
+  const_iterator cbegin() const noexcept
+  {
+    return this->begin();
+  }
+  const_iterator cend() const noexcept
+  {
+    return this->end();
+  }
+
+  /// Sorted keys, in the same order as values().
+  KeyContainerType const& keys() const noexcept
+  {
+    return this->keys_;
+  }
+  /// Values, in the same order as keys().
+  ValueContainerType const& values() const noexcept
+  {
+    return this->values_;
+  }
+
+  /** Find the position of the value for given key.
+   * Returns end() if no match was found.
+   */
+  iterator find(KeyType const& key) noexcept
+  {
+    auto const idx = this->indexOf(key);
+    return this->begin() + static_cast<difference_type>(idx);
+  }
+  /** Find the position of the value for given key.
+   * Returns cend() if no match was found.
+   */
+  const_iterator find(KeyType const& key) const noexcept
+  {
+    auto const idx = this->indexOf(key);
+    return this->begin() + static_cast<difference_type>(idx);
+  }
+  ValueType& operator[](KeyType const& key)
+  {
+    auto const idx = this->lowerBound(key);
+    if (idx != this->size() && this->isKeyEqual(key, this->keys_[idx]))
+      return this->values_[idx];
+    return *this->insertAt(idx, key, ValueType{}).valuePtr();
+  }
+  ValueType& at(KeyType const& key)
+  {
+    auto const idx = this->indexOf(key);
+    if (idx != this->size())
+      return this->values_[idx];
+    throw std::out_of_range("Invalid access at SplitFlatMap::at");
+  }
+  ValueType const& at(KeyType const& key) const
+  {
+    auto const idx = this->indexOf(key);
+    if (idx != this->size())
+      return this->values_[idx];
+    throw std::out_of_range("Invalid access at SplitFlatMap::at const");
+  }
+
+  /// Removes element whose key is key. Does nothing if key is not found.
+  iterator erase(KeyType const& key) noexcept
+  {
+    auto const idx = this->indexOf(key);
+    if (idx != this->size())
+      return this->erase(this->begin() + static_cast<difference_type>(idx));
+    return this->end();
+  }
+  iterator erase(const_iterator it) noexcept
+  {
+    auto const idx = it - this->cbegin();
+    this->keys_.erase(this->keys_.begin() + idx);
+    this->values_.erase(this->values_.begin() + idx);
+    return this->begin() + idx;
+  }
+  /// Removes every element.
+  void clear() noexcept
+  {
+    this->keys_.clear();
+    this->values_.clear();
+  }
+  /// In-place insertion.
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args)
+  {
+    PairType pair{std::forward<Args>(args)...};
+    auto const idx = this->lowerBound(pair.first);
+    if (idx != this->size() && this->isKeyEqual(pair.first, this->keys_[idx]))
+      return {this->begin() + static_cast<difference_type>(idx), false};
+    auto const it =
+        this->insertAt(idx, std::move(pair.first), std::move(pair.second));
+    return {it, true};
+  }
+
+private:
+  /// Index of the first key not less than key.
+  size_type lowerBound(KeyType const& key) const noexcept
+  {
+    auto const first = this->keys_.data();
+    auto const it = detail::lowerBound(
+        first, first + this->size(), key, this->comp, detail::Identity{});
+    return static_cast<size_type>(it - first);
+  }
+  /// Index of key, or size() if it is not present.
+  size_type indexOf(KeyType const& key) const noexcept
+  {
+    auto const idx = this->lowerBound(key);
+    if (idx != this->size() && this->isKeyEqual(key, this->keys_[idx]))
+      return idx;
+    return this->size();
+  }
+  bool isKeyEqual(KeyType const& a, KeyType const& b) const noexcept
+  {
+    return this->comp(a, b) == false && this->comp(b, a) == false;
+  }
+  template <typename K, typename V>
+  iterator insertAt(size_type idx, K&& key, V&& value)
+  {
+    auto const offset = static_cast<difference_type>(idx);
+    this->keys_.emplace(this->keys_.begin() + offset, std::forward<K>(key));
+    try
+    {
+      this->values_.emplace(this->values_.begin() + offset,
+                            std::forward<V>(value));
+    }
+    catch (...)
+    {
+      this->keys_.erase(this->keys_.begin() + offset);
+      throw;
+    }
+    return this->begin() + offset;
+  }
+
+  KeyContainerType keys_;
+  ValueContainerType values_;
+  Comp comp;
+};
+}
+
+#endif /* !KOUH_SPLITFLATMAP_HPP_ */
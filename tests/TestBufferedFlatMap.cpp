@@ -0,0 +1,100 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+
+#include <kouh/BufferedFlatMap.hpp>
+
+template <typename Key, typename Value>
+using BufferedFlatMap = kouh::BufferedFlatMap<Key, Value>;
+
+TEST_CASE("[BufferedFlatMap] Initialization", "[BufferedFlatMap]")
+{
+  BufferedFlatMap<int, int> bfm{};
+  CHECK(bfm.size() == 0);
+  CHECK(bfm.empty());
+  CHECK(bfm.begin() == bfm.end());
+}
+
+TEST_CASE("[BufferedFlatMap] Insertion and lookup", "[BufferedFlatMap]")
+{
+  BufferedFlatMap<int, std::string> bfm{4};
+
+  CHECK(bfm.emplace(3, "3"));
+  CHECK(bfm.emplace(1, "1"));
+  CHECK(bfm.try_emplace(2, "2"));
+  CHECK(bfm.buffered() == 3);
+
+  SECTION("Lookups see buffered elements")
+  {
+    CHECK(bfm.size() == 3);
+    CHECK(bfm.contains(1));
+    CHECK(bfm.at(2) == "2");
+    CHECK(*bfm.findValue(3) == "3");
+    CHECK(bfm.findValue(4) == nullptr);
+    CHECK_THROWS_AS(bfm.at(4), std::out_of_range);
+  }
+
+  SECTION("Duplicates are rejected from both parts")
+  {
+    CHECK(!bfm.emplace(3, "three"));
+    bfm.flush();
+    CHECK(bfm.buffered() == 0);
+    CHECK(!bfm.emplace(3, "three"));
+    CHECK(!bfm.try_emplace(1, "one"));
+    CHECK(bfm.at(3) == "3");
+    CHECK(bfm.size() == 3);
+  }
+
+  SECTION("A full buffer is merged")
+  {
+    for (int i = 10; i < 20; ++i)
+      bfm[i] = std::to_string(i);
+    CHECK(bfm.size() == 13);
+    CHECK(bfm.buffered() <= 4);
+    for (int i = 10; i < 20; ++i)
+      CHECK(bfm.at(i) == std::to_string(i));
+  }
+
+  SECTION("Iteration is ordered")
+  {
+    bfm.flush();
+    bfm.emplace(0, "0");
+    bfm.emplace(5, "5");
+    bfm.emplace(2, "2");
+    auto const& cbfm = bfm;
+    int expected = 0;
+    for (auto const& pair : cbfm)
+    {
+      CHECK(pair.first == expected);
+      CHECK(pair.second == std::to_string(expected));
+      expected = expected == 3 ? 5 : expected + 1;
+    }
+    CHECK(expected == 6);
+    CHECK(std::distance(cbfm.begin(), cbfm.end()) == 5);
+    // Const iteration leaves the buffer alone, mutable iteration merges it.
+    CHECK(bfm.buffered() == 2);
+    CHECK(bfm.begin()->first == 0);
+    CHECK(bfm.buffered() == 0);
+  }
+
+  SECTION("erase")
+  {
+    bfm.flush();
+    bfm.emplace(5, "5");
+    CHECK(bfm.erase(5) == 1);
+    CHECK(bfm.erase(1) == 1);
+    CHECK(bfm.erase(42) == 0);
+    CHECK(bfm.size() == 2);
+    CHECK(!bfm.contains(1));
+  }
+
+  SECTION("clear")
+  {
+    bfm.flush();
+    bfm.emplace(5, "5");
+    bfm.clear();
+    CHECK(bfm.empty());
+  }
+}
@@ -0,0 +1,224 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <kouh/ChunkedFlatMap.hpp>
+
+// Small leaves so that splits and merges happen with few elements.
+template <typename Key, typename Value>
+using ChunkedFlatMap = kouh::ChunkedFlatMap<Key, Value, std::less<Key>, 8>;
+
+namespace
+{
+template <typename Map, typename Key, typename Value>
+void checkSame(Map const& cfm, std::map<Key, Value> const& reference)
+{
+  REQUIRE(cfm.size() == reference.size());
+  REQUIRE(std::equal(cfm.begin(),
+                     cfm.end(),
+                     reference.begin(),
+                     [](std::pair<Key, Value> const& a,
+                        std::pair<Key const, Value> const& b) {
+                       return a.first == b.first && a.second == b.second;
+                     }));
+}
+}
+
+TEST_CASE("[ChunkedFlatMap] Initialization", "[ChunkedFlatMap]")
+{
+  SECTION("Empty")
+  {
+    ChunkedFlatMap<int, int> cfm{};
+    CHECK(cfm.size() == 0);
+    CHECK(cfm.empty());
+    CHECK(cfm.begin() == cfm.end());
+    CHECK(cfm.find(4) == cfm.end());
+  }
+
+  SECTION("Init list spanning several leaves")
+  {
+    ChunkedFlatMap<int, int> cfm = {{5, 5},
+                                    {1, 1},
+                                    {9, 9},
+                                    {3, 3},
+                                    {7, 7},
+                                    {2, 2},
+                                    {8, 8},
+                                    {4, 4},
+                                    {6, 6},
+                                    {0, 0},
+                                    {1, 10}};
+    CHECK(cfm.size() == 10);
+    CHECK(cfm.at(1) == 1);
+    int expected = 0;
+    for (auto const& pair : cfm)
+      CHECK(pair.first == expected++);
+    CHECK(expected == 10);
+  }
+}
+
+TEST_CASE("[ChunkedFlatMap] Copy", "[ChunkedFlatMap]")
+{
+  // A single leaf, filled to three quarters.
+  ChunkedFlatMap<int, int> const cfm = {
+      {0, 0}, {2, 2}, {4, 4}, {6, 6}, {8, 8}, {10, 10}};
+  auto copy = cfm;
+  CHECK(std::equal(copy.begin(), copy.end(), cfm.begin(), cfm.end()));
+
+  // The copied leaf has room left, and is not reallocated.
+  auto const first = &*copy.begin();
+  copy.emplace(1, 1);
+  CHECK(&*copy.begin() == first);
+
+  ChunkedFlatMap<int, int> assigned;
+  assigned = cfm;
+  auto const assignedFirst = &*assigned.begin();
+  assigned.emplace(3, 3);
+  CHECK(&*assigned.begin() == assignedFirst);
+  CHECK(assigned.size() == 7);
+  CHECK(cfm.size() == 6);
+}
+
+TEST_CASE("[ChunkedFlatMap] Move", "[ChunkedFlatMap]")
+{
+  ChunkedFlatMap<int, int> cfm;
+  for (int i = 0; i < 10; ++i)
+    cfm.emplace(i, i);
+
+  auto moved = std::move(cfm);
+  CHECK(moved.size() == 10);
+  CHECK(cfm.size() == 0);
+  CHECK(cfm.empty());
+  CHECK(cfm.begin() == cfm.end());
+
+  cfm.emplace(1, 1);
+  CHECK(cfm.size() == 1);
+  cfm = std::move(moved);
+  CHECK(cfm.size() == 10);
+  CHECK(moved.size() == 0);
+  CHECK(moved.empty());
+  CHECK(moved.begin() == moved.end());
+  CHECK(moved.erase(3) == 0);
+  CHECK(moved.size() == 0);
+}
+
+TEST_CASE("[ChunkedFlatMap] Underfull leaves", "[ChunkedFlatMap]")
+{
+  // Bulk construction fills leaves of 64 with 48 elements.
+  std::vector<std::pair<int, int>> pairs;
+  for (int i = 0; i < 48 * 64; ++i)
+    pairs.emplace_back(i, i);
+  kouh::ChunkedFlatMap<int, int, std::less<int>, 64> cfm{
+      kouh::FlatMap<int, int>(pairs.begin(), pairs.end())};
+  std::map<int, int> reference(pairs.begin(), pairs.end());
+  // Every leaf but a lone one holds more than 64 / 4 elements.
+  auto const bounded = [&cfm]() {
+    return cfm.leafCount() <= cfm.size() / 17 + 1;
+  };
+  auto const eraseIf = [&](auto predicate) {
+    for (auto const& pair : pairs)
+    {
+      if (predicate(pair.first))
+      {
+        REQUIRE(cfm.erase(pair.first) == reference.erase(pair.first));
+        REQUIRE(bounded());
+      }
+    }
+    checkSame(cfm, reference);
+  };
+
+  // Empty every other leaf but for one element, next to full leaves.
+  eraseIf([](int key) { return key / 48 % 2 == 1 && key % 48 != 0; });
+  // Then erase every other key from the other leaves.
+  eraseIf([](int key) { return key / 48 % 2 == 0 && key % 2 == 1; });
+  CHECK(cfm.size() == 32 * 25);
+}
+
+TEST_CASE("[ChunkedFlatMap] Lookup", "[ChunkedFlatMap]")
+{
+  ChunkedFlatMap<std::string, int> cfm = {
+      {"4", 4}, {"8", 8}, {"42", 42}, {"1337", 1337}, {"4269", 4269}};
+
+  CHECK(cfm.find("42")->second == 42);
+  CHECK(cfm.find("foo") == cfm.end());
+  CHECK(cfm.count("8") == 1);
+  CHECK(!cfm.contains("foo"));
+  CHECK(cfm.at("1337") == 1337);
+  CHECK_THROWS_AS(cfm.at("foo"), std::out_of_range);
+  cfm["4"] = 2;
+  CHECK(cfm.at("4") == 2);
+  cfm["0"] = 0;
+  CHECK(cfm.size() == 6);
+  CHECK(cfm.begin()->first == "0");
+
+  auto const& ccfm = cfm;
+  CHECK(ccfm.find("8")->second == 8);
+  CHECK(ccfm.find("foo") == ccfm.cend());
+}
+
+TEST_CASE("[ChunkedFlatMap] Against std::map", "[ChunkedFlatMap]")
+{
+  ChunkedFlatMap<int, int> cfm;
+  std::map<int, int> reference;
+  std::mt19937 rng{42};
+  std::uniform_int_distribution<int> keys{0, 300};
+
+  for (int i = 0; i < 2000; ++i)
+  {
+    auto const key = keys(rng);
+    if (i % 3 == 2)
+    {
+      REQUIRE(cfm.erase(key) == reference.erase(key));
+    }
+    else
+    {
+      auto const ret = cfm.emplace(key, i);
+      auto const expected = reference.emplace(key, i);
+      REQUIRE(ret.second == expected.second);
+      REQUIRE(ret.first->first == key);
+      REQUIRE(ret.first->second == expected.first->second);
+    }
+  }
+  checkSame(cfm, reference);
+
+  SECTION("Erase by iterator while iterating")
+  {
+    for (auto it = cfm.begin(); it != cfm.end();)
+    {
+      if (it->first % 2 == 0)
+        it = cfm.erase(it);
+      else
+        ++it;
+    }
+    for (auto it = reference.begin(); it != reference.end();)
+    {
+      if (it->first % 2 == 0)
+        it = reference.erase(it);
+      else
+        ++it;
+    }
+    checkSame(cfm, reference);
+  }
+
+  SECTION("Backwards iteration")
+  {
+    auto it = cfm.end();
+    for (auto rit = reference.rbegin(); rit != reference.rend(); ++rit)
+      REQUIRE((--it)->first == rit->first);
+    CHECK(it == cfm.begin());
+  }
+
+  SECTION("Erase everything")
+  {
+    for (int key = 0; key <= 300; ++key)
+      cfm.erase(key);
+    CHECK(cfm.empty());
+    CHECK(cfm.begin() == cfm.end());
+    cfm.emplace(1, 1);
+    CHECK(cfm.size() == 1);
+  }
+}
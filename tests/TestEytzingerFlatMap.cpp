@@ -0,0 +1,112 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <kouh/EytzingerFlatMap.hpp>
+
+template <typename Key, typename Value>
+using EytzingerFlatMap = kouh::EytzingerFlatMap<Key, Value>;
+
+template <typename Key, typename Value>
+using FlatMap = kouh::FlatMap<Key, Value>;
+
+TEST_CASE("[EytzingerFlatMap] Initialization", "[EytzingerFlatMap]")
+{
+  SECTION("Empty")
+  {
+    EytzingerFlatMap<int, int> efm{};
+    CHECK(efm.size() == 0);
+    CHECK(efm.empty());
+    CHECK(efm.begin() == efm.end());
+    CHECK(efm.find(4) == efm.end());
+  }
+
+  SECTION("From FlatMap")
+  {
+    FlatMap<std::string, int> const fm = {{"4", 4}, {"8", 8}, {"42", 42}};
+    EytzingerFlatMap<std::string, int> efm{fm};
+    CHECK(efm.size() == 3);
+    CHECK(fm.size() == 3);
+    CHECK(efm.at("42") == 42);
+  }
+
+  SECTION("From moved FlatMap")
+  {
+    FlatMap<std::string, int> fm = {{"4", 4}, {"8", 8}, {"42", 42}};
+    EytzingerFlatMap<std::string, int> efm{std::move(fm)};
+    CHECK(efm.size() == 3);
+    CHECK(efm.at("8") == 8);
+  }
+}
+
+TEST_CASE("[EytzingerFlatMap] Lookup and iteration", "[EytzingerFlatMap]")
+{
+  // Exercise complete, almost complete and lopsided trees.
+  for (int n = 1; n < 70; ++n)
+  {
+    FlatMap<int, int> fm;
+    for (int i = 0; i < n; ++i)
+      fm.emplace(2 * i, i);
+    EytzingerFlatMap<int, int> const efm{fm};
+    REQUIRE(efm.size() == static_cast<std::size_t>(n));
+
+    int expected = 0;
+    for (auto const& pair : efm)
+    {
+      REQUIRE(pair.first == 2 * expected);
+      REQUIRE(pair.second == expected);
+      ++expected;
+    }
+    REQUIRE(expected == n);
+
+    expected = n;
+    for (auto it = efm.end(); it != efm.begin();)
+    {
+      --it;
+      --expected;
+      REQUIRE(it->first == 2 * expected);
+    }
+    REQUIRE(expected == 0);
+
+    for (int i = -1; i <= 2 * n; ++i)
+    {
+      auto const it = efm.find(i);
+      if (i >= 0 && i % 2 == 0 && i < 2 * n)
+      {
+        REQUIRE(it != efm.end());
+        REQUIRE(it->second == i / 2);
+        REQUIRE(efm.contains(i));
+      }
+      else
+      {
+        REQUIRE(it == efm.end());
+        REQUIRE(efm.count(i) == 0);
+      }
+    }
+  }
+}
+
+TEST_CASE("[EytzingerFlatMap] Proxy iterators", "[EytzingerFlatMap]")
+{
+  // References are proxies, so only the input iterator category holds.
+  using Iterator = EytzingerFlatMap<int, int>::const_iterator;
+  CHECK((std::is_same<std::iterator_traits<Iterator>::iterator_category,
+                      std::input_iterator_tag>::value));
+}
+
+TEST_CASE("[EytzingerFlatMap] at / toFlatMap", "[EytzingerFlatMap]")
+{
+  FlatMap<std::string, int> const fm = {
+      {"4", 4}, {"8", 8}, {"42", 42}, {"1337", 1337}, {"4269", 4269}};
+  EytzingerFlatMap<std::string, int> const efm{fm};
+
+  CHECK(efm.at("4269") == 4269);
+  CHECK_THROWS_AS(efm.at("foo"), std::out_of_range);
+
+  auto const back = efm.toFlatMap();
+  CHECK(std::equal(back.begin(), back.end(), fm.begin(), fm.end()));
+}
@@ -1,5 +1,18 @@
 #include <catch2/catch.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
 #include <kouh/FlatMap.hpp>
 
 template <typename Key, typename Value>
@@ -28,6 +41,53 @@ struct NoCopy
 
   int a;
 };
+
+/// Bump allocator over a fixed buffer. Memory is only reclaimed all at once.
+struct Arena
+{
+  alignas(std::max_align_t) unsigned char buffer[1 << 16];
+  std::size_t used = 0;
+};
+
+template <typename T>
+struct ArenaAllocator
+{
+  using value_type = T;
+
+  explicit ArenaAllocator(Arena& a) noexcept : arena{&a}
+  {
+  }
+  template <typename U>
+  ArenaAllocator(ArenaAllocator<U> const& b) noexcept : arena{b.arena}
+  {
+  }
+
+  T* allocate(std::size_t n)
+  {
+    auto const align = alignof(std::max_align_t);
+    auto const offset = (this->arena->used + align - 1) / align * align;
+    if (offset + n * sizeof(T) > sizeof(this->arena->buffer))
+      throw std::bad_alloc{};
+    this->arena->used = offset + n * sizeof(T);
+    return reinterpret_cast<T*>(this->arena->buffer + offset);
+  }
+  void deallocate(T*, std::size_t) noexcept
+  {
+  }
+
+  template <typename U>
+  bool operator==(ArenaAllocator<U> const& b) const noexcept
+  {
+    return this->arena == b.arena;
+  }
+  template <typename U>
+  bool operator!=(ArenaAllocator<U> const& b) const noexcept
+  {
+    return this->arena != b.arena;
+  }
+
+  Arena* arena;
+};
 }
 
 TEST_CASE("Initialization", "[FlatMap]")
@@ -227,6 +287,98 @@ TEST_CASE("erase", "[FlatMap]")
   }
 }
 
+TEST_CASE("Ordered lookup", "[FlatMap]")
+{
+  FlatMap<int, int> fm = {{10, 1}, {20, 2}, {30, 3}, {40, 4}};
+  auto const& cfm = fm;
+
+  CHECK(fm.lower_bound(20)->first == 20);
+  CHECK(fm.lower_bound(21)->first == 30);
+  CHECK(fm.lower_bound(41) == fm.end());
+  CHECK(fm.upper_bound(20)->first == 30);
+  CHECK(fm.upper_bound(5) == fm.begin());
+  CHECK(cfm.lower_bound(0) == cfm.begin());
+  CHECK(cfm.upper_bound(40) == cfm.end());
+
+  auto const hit = fm.equal_range(30);
+  CHECK(hit.second - hit.first == 1);
+  CHECK(hit.first->second == 3);
+  auto const miss = cfm.equal_range(25);
+  CHECK(miss.first == miss.second);
+  CHECK(miss.first->first == 30);
+
+  // Time-window style iteration over [15, 35).
+  int sum = 0;
+  for (auto it = fm.lower_bound(15); it != fm.lower_bound(35); ++it)
+    sum += it->second;
+  CHECK(sum == 5);
+}
+
+TEST_CASE("Range erasure", "[FlatMap]")
+{
+  FlatMap<int, std::string> fm;
+  for (int i = 0; i < 10; ++i)
+    fm.emplace(i * 10, std::to_string(i));
+
+  SECTION("erase(first, last)")
+  {
+    auto const it = fm.erase(fm.lower_bound(20), fm.lower_bound(50));
+    CHECK(it->first == 50);
+    CHECK(fm.size() == 7);
+    CHECK(!fm.contains(20));
+    CHECK(!fm.contains(40));
+    CHECK(fm.at(10) == "1");
+    CHECK(fm.at(50) == "5");
+    CHECK(fm.erase(fm.begin(), fm.begin()) == fm.begin());
+    CHECK(fm.size() == 7);
+  }
+
+  SECTION("erase_before")
+  {
+    CHECK(fm.erase_before(35) == 4);
+    CHECK(fm.size() == 6);
+    CHECK(fm.begin()->first == 40);
+    CHECK(fm.erase_before(40) == 0);
+    CHECK(fm.erase_before(1000) == 6);
+    CHECK(fm.empty());
+  }
+}
+
+TEST_CASE("erase_if / retain", "[FlatMap]")
+{
+  FlatMap<int, NoCopy> fm;
+  for (int i = 0; i < 100; ++i)
+    fm.emplace(i, i * 2);
+
+  SECTION("erase_if")
+  {
+    auto const removed =
+        erase_if(fm, [](std::pair<int, NoCopy> const& pair) {
+          return pair.first % 10 == 0;
+        });
+    CHECK(removed == 10);
+    CHECK(fm.size() == 90);
+    CHECK(!fm.contains(50));
+    CHECK(fm.at(51) == 102);
+    CHECK(std::is_sorted(
+        fm.begin(),
+        fm.end(),
+        [](std::pair<int, NoCopy> const& a, std::pair<int, NoCopy> const& b) {
+          return a.first < b.first;
+        }));
+  }
+
+  SECTION("retain")
+  {
+    auto const removed = fm.retain(
+        [](std::pair<int, NoCopy> const& pair) { return pair.second.a < 20; });
+    CHECK(removed == 90);
+    CHECK(fm.size() == 10);
+    CHECK(fm.begin()->first == 0);
+    CHECK((fm.end() - 1)->first == 9);
+  }
+}
+
 TEST_CASE("find", "[FlatMap]")
 {
   FlatMap<std::string, int> fm = {
@@ -330,3 +482,793 @@ TEST_CASE("emplace", "[FlatMap]")
     CHECK(fm.size() == 5);
   }
 }
+
+TEST_CASE("Bulk construction", "[FlatMap]")
+{
+  std::vector<std::pair<int, int>> const unsorted = {
+      {4, 40}, {1, 10}, {3, 30}, {1, 11}, {2, 20}, {4, 41}, {1, 12}};
+
+  SECTION("Init list removes duplicates")
+  {
+    FlatMap<int, int> fm = {{2, 5}, {1, 4}, {2, 2}};
+    CHECK(fm.size() == 2);
+    CHECK(fm.at(1) == 4);
+    CHECK(fm.at(2) == 5);
+  }
+
+  SECTION("Iterator range, first wins")
+  {
+    FlatMap<int, int> fm{unsorted.begin(), unsorted.end()};
+    REQUIRE(fm.size() == 4);
+    CHECK(std::is_sorted(fm.begin(), fm.end()));
+    CHECK(fm.at(1) == 10);
+    CHECK(fm.at(2) == 20);
+    CHECK(fm.at(3) == 30);
+    CHECK(fm.at(4) == 40);
+  }
+
+  SECTION("Iterator range, last wins")
+  {
+    FlatMap<int, int> fm{
+        unsorted.begin(), unsorted.end(), kouh::DuplicatePolicy::KeepLast};
+    REQUIRE(fm.size() == 4);
+    CHECK(fm.at(1) == 12);
+    CHECK(fm.at(2) == 20);
+    CHECK(fm.at(3) == 30);
+    CHECK(fm.at(4) == 41);
+  }
+
+  SECTION("Adopt vector of non-copyable values")
+  {
+    std::vector<std::pair<int, NoCopy>> v;
+    v.emplace_back(3, 3);
+    v.emplace_back(1, 1);
+    v.emplace_back(3, 4);
+    v.emplace_back(2, 2);
+    FlatMap<int, NoCopy> fm{std::move(v)};
+    REQUIRE(fm.size() == 3);
+    CHECK(fm.at(1) == 1);
+    CHECK(fm.at(2) == 2);
+    CHECK(fm.at(3) == 3);
+  }
+
+  SECTION("Empty range")
+  {
+    FlatMap<int, int> fm{unsorted.begin(), unsorted.begin()};
+    CHECK(fm.empty());
+  }
+}
+
+TEST_CASE("Bulk insert", "[FlatMap]")
+{
+  FlatMap<int, int> fm = {{1, 1}, {3, 3}, {5, 5}};
+  std::vector<std::pair<int, int>> const more = {
+      {6, 60}, {3, 30}, {0, 0}, {2, 20}, {6, 61}};
+
+  SECTION("Existing keys are kept")
+  {
+    fm.insert(more.begin(), more.end());
+    REQUIRE(fm.size() == 6);
+    CHECK(std::is_sorted(fm.begin(), fm.end()));
+    CHECK(fm.at(0) == 0);
+    CHECK(fm.at(2) == 20);
+    CHECK(fm.at(3) == 3);
+    CHECK(fm.at(6) == 60);
+  }
+
+  SECTION("Existing keys are overwritten")
+  {
+    fm.insert(more.begin(), more.end(), kouh::DuplicatePolicy::KeepLast);
+    REQUIRE(fm.size() == 6);
+    CHECK(fm.at(1) == 1);
+    CHECK(fm.at(3) == 30);
+    CHECK(fm.at(6) == 61);
+  }
+}
+
+TEST_CASE("Parallel bulk construction", "[FlatMap]")
+{
+  // Large enough to be sorted and deduplicated on several threads.
+  std::vector<std::pair<int, int>> pairs;
+  std::mt19937 rng{42};
+  std::uniform_int_distribution<int> keys{0, 100000};
+  for (int i = 0; i < 400000; ++i)
+    pairs.emplace_back(keys(rng), i);
+  std::map<int, int> first;
+  std::map<int, int> last;
+  for (auto const& pair : pairs)
+  {
+    first.emplace(pair);
+    last[pair.first] = pair.second;
+  }
+  auto const sameAs = [](FlatMap<int, int> const& fm,
+                         std::map<int, int> const& reference) {
+    return fm.size() == reference.size() &&
+           std::equal(fm.begin(),
+                      fm.end(),
+                      reference.begin(),
+                      [](std::pair<int, int> const& a,
+                         std::pair<int const, int> const& b) {
+                        return a.first == b.first && a.second == b.second;
+                      });
+  };
+
+  CHECK(sameAs(FlatMap<int, int>{pairs.begin(), pairs.end()}, first));
+  CHECK(sameAs(FlatMap<int, int>{pairs.begin(),
+                                 pairs.end(),
+                                 kouh::DuplicatePolicy::KeepLast},
+               last));
+
+  FlatMap<int, int> fm = {{-1, 0}, {50000, -1}};
+  fm.insert(pairs.begin(), pairs.end());
+  first.emplace(-1, 0);
+  first[50000] = -1;
+  CHECK(sameAs(fm, first));
+}
+
+TEST_CASE("Sorted unique adoption", "[FlatMap]")
+{
+  std::vector<std::pair<std::string, int>> v = {
+      {"1337", 1337}, {"4", 4}, {"42", 42}, {"8", 8}};
+  auto const data = v.data();
+
+  SECTION("Constructor does not reallocate")
+  {
+    FlatMap<std::string, int> fm{kouh::sorted_unique, std::move(v)};
+    REQUIRE(fm.size() == 4);
+    CHECK(&*fm.begin() == data);
+    CHECK(fm.at("4") == 4);
+    CHECK(fm.at("1337") == 1337);
+  }
+
+  SECTION("Extract moves the vector out")
+  {
+    FlatMap<std::string, int> fm{kouh::sorted_unique, std::move(v)};
+    auto const extracted = fm.extract();
+    CHECK(fm.empty());
+    REQUIRE(extracted.size() == 4);
+    CHECK(extracted.data() == data);
+  }
+
+  SECTION("Replace swaps in a new vector")
+  {
+    FlatMap<std::string, int> fm = {{"foo", 1}};
+    fm.replace(std::move(v));
+    REQUIRE(fm.size() == 4);
+    CHECK(&*fm.begin() == data);
+    CHECK(fm.find("foo") == fm.end());
+    CHECK(fm.at("8") == 8);
+    CHECK(noexcept(fm.replace(std::move(v))));
+  }
+}
+
+namespace
+{
+/// Checks find against every key around the ones in a map of n elements.
+template <typename Key>
+void checkArithmeticFind(int n)
+{
+  FlatMap<Key, int> fm;
+  for (int i = 0; i < n; ++i)
+    fm.emplace(static_cast<Key>(3 * i - n), i);
+  for (int i = -n - 2; i < 2 * n + 2; ++i)
+  {
+    auto const key = static_cast<Key>(i);
+    auto const it = fm.find(key);
+    if ((i + n) % 3 == 0 && i >= -n && i < 2 * n)
+    {
+      REQUIRE(it != fm.end());
+      REQUIRE(it->second == (i + n) / 3);
+    }
+    else
+      REQUIRE(it == fm.end());
+  }
+}
+}
+
+TEST_CASE("Arithmetic keys lookup", "[FlatMap]")
+{
+  for (int n : {0, 1, 2, 5, 15, 16, 17, 33, 100, 257})
+  {
+    checkArithmeticFind<int>(n);
+    checkArithmeticFind<long>(n);
+    checkArithmeticFind<short>(n);
+    checkArithmeticFind<double>(n);
+    checkArithmeticFind<float>(n);
+  }
+
+  SECTION("Unsigned keys with the high bit set")
+  {
+    FlatMap<unsigned int, int> fm = {{1u, 1}, {0x80000000u, 2}, {~0u, 3}};
+    CHECK(fm.at(0x80000000u) == 2);
+    CHECK(fm.at(~0u) == 3);
+    CHECK(fm.find(0x7fffffffu) == fm.end());
+    FlatMap<std::uint64_t, int> fm64 = {
+        {1u, 1}, {std::uint64_t{1} << 63, 2}, {~std::uint64_t{0}, 3}};
+    CHECK(fm64.at(std::uint64_t{1} << 63) == 2);
+    CHECK(fm64.at(~std::uint64_t{0}) == 3);
+  }
+}
+
+namespace
+{
+template <typename Key, typename Search>
+using SearchMap = kouh::FlatMap<Key,
+                                int,
+                                std::less<Key>,
+                                std::allocator<std::pair<Key, int>>,
+                                Search>;
+
+/// Checks lower_bound with Search against the default binary search.
+template <typename Search, typename Key>
+void checkSearchPolicy(std::vector<Key> const& keys)
+{
+  std::vector<std::pair<Key, int>> pairs;
+  for (auto const key : keys)
+    pairs.emplace_back(key, 0);
+  SearchMap<Key, Search> const fm{pairs.begin(), pairs.end()};
+  FlatMap<Key, int> const reference{pairs.begin(), pairs.end()};
+
+  std::vector<Key> probes{std::numeric_limits<Key>::lowest(),
+                          std::numeric_limits<Key>::max()};
+  for (auto const key : keys)
+  {
+    probes.push_back(key);
+    probes.push_back(static_cast<Key>(key - 1));
+    probes.push_back(static_cast<Key>(key + 1));
+  }
+  for (auto const probe : probes)
+    REQUIRE(fm.lower_bound(probe) - fm.begin() ==
+            reference.lower_bound(probe) - reference.begin());
+}
+
+template <typename Search>
+void checkSearchPolicy()
+{
+  std::mt19937 rng{42};
+  std::uniform_int_distribution<int> uniform{-1000000, 1000000};
+  std::vector<int> keys;
+  for (int i = 0; i < 5000; ++i)
+    keys.push_back(uniform(rng));
+  checkSearchPolicy<Search>(keys);
+
+  std::vector<int> skewed;
+  for (int i = 0; i < 1000; ++i)
+    skewed.push_back(i * i * i / 1000);
+  checkSearchPolicy<Search>(skewed);
+
+  std::vector<double> exponential;
+  for (int i = 0; i < 1000; ++i)
+    exponential.push_back(std::ldexp(1.0, i % 900) * (i % 2 ? 1 : -1));
+  checkSearchPolicy<Search>(exponential);
+
+  std::vector<std::uint64_t> wide;
+  for (int i = 0; i < 1000; ++i)
+    wide.push_back(~std::uint64_t{0} - static_cast<std::uint64_t>(i));
+  checkSearchPolicy<Search>(wide);
+
+  for (int n : {0, 1, 2, 17, 100})
+    checkSearchPolicy<Search>(std::vector<int>(keys.begin(), keys.begin() + n));
+}
+}
+
+TEST_CASE("Search policies", "[FlatMap]")
+{
+  checkSearchPolicy<kouh::BinarySearch>();
+  checkSearchPolicy<kouh::InterpolationSearch>();
+  checkSearchPolicy<kouh::LearnedSegmentSearch>();
+
+  SECTION("Uniform keys fit in few segments")
+  {
+    SearchMap<int, kouh::LearnedSegmentSearch> fm;
+    std::vector<std::pair<int, int>> pairs;
+    for (int i = 0; i < 10000; ++i)
+      pairs.emplace_back(7 * i, i);
+    fm.insert(pairs.begin(), pairs.end());
+    CHECK(fm.searchPolicy().segmentCount() == 1);
+    CHECK(fm.at(7 * 1234) == 1234);
+  }
+
+  SECTION("Stale model")
+  {
+    SearchMap<int, kouh::LearnedSegmentSearch> fm;
+    for (int i = 0; i < 1000; ++i)
+      fm.emplace(2 * i, i);
+    fm.erase_before(0);
+    // Single element insertions leave the model behind.
+    for (int i = 0; i < 1000; ++i)
+      fm.emplace(-2 * i - 1, i);
+    for (int i = 0; i < 200; ++i)
+      fm.erase(4 * i);
+    for (int i = -2000; i < 2000; ++i)
+    {
+      auto const erased = i < 800 && i % 4 == 0;
+      auto const expected = i < 0 ? i % 2 != 0 : i % 2 == 0 && !erased;
+      REQUIRE(fm.contains(i) == expected);
+    }
+  }
+}
+
+TEST_CASE("Prefix cache search", "[FlatMap]")
+{
+  using Map = SearchMap<std::string, kouh::PrefixCacheSearch>;
+  std::mt19937 rng{42};
+  // Mostly keys with a long shared prefix, that ties on the next 8 bytes.
+  auto randomKey = [&rng]() {
+    static char const* const parts[] = {
+        "/static/assets/", "/static/assets/images/", "12345678", "a", ""};
+    std::uniform_int_distribution<std::size_t> part{0, 4};
+    std::uniform_int_distribution<int> rare{0, 99};
+    std::string key = rare(rng) == 0 ? "/" : "/static/assets/";
+    for (int i = 0; i < 3; ++i)
+      key += parts[part(rng)];
+    if (rare(rng) == 0)
+      key += '\xff';
+    return key;
+  };
+  auto check = [&](Map const& fm, FlatMap<std::string, int> const& reference) {
+    REQUIRE(fm.size() == reference.size());
+    REQUIRE(fm.searchPolicy().prefixCount() == fm.size());
+    for (int i = 0; i < 50; ++i)
+    {
+      auto const key = randomKey();
+      REQUIRE(fm.lower_bound(key) - fm.begin() ==
+              reference.lower_bound(key) - reference.begin());
+    }
+    for (auto const& key : {std::string{}, std::string{"/"}, std::string{"~"}})
+      REQUIRE(fm.lower_bound(key) - fm.begin() ==
+              reference.lower_bound(key) - reference.begin());
+  };
+
+  Map fm;
+  FlatMap<std::string, int> reference;
+  for (int i = 0; i < 3000; ++i)
+  {
+    auto const key = randomKey();
+    switch (i % 7)
+    {
+    case 0:
+    case 1:
+      fm.emplace(key, i);
+      reference.emplace(key, i);
+      break;
+    case 2:
+      fm.try_emplace(key, i);
+      reference.try_emplace(key, i);
+      break;
+    case 3:
+      fm.insert_or_assign(key, i);
+      reference.insert_or_assign(key, i);
+      break;
+    case 4:
+      fm[key] = i;
+      reference[key] = i;
+      break;
+    default:
+      fm.erase(key);
+      reference.erase(key);
+      if (!fm.empty())
+      {
+        fm.erase(fm.begin());
+        reference.erase(reference.begin());
+      }
+      break;
+    }
+    check(fm, reference);
+  }
+  fm.clear();
+  reference.clear();
+  check(fm, reference);
+  fm.emplace("/", 0);
+  reference.emplace("/", 0);
+  check(fm, reference);
+}
+
+TEST_CASE("Prefix cache search with heterogeneous lookup", "[FlatMap]")
+{
+  kouh::FlatMap<std::string,
+                int,
+                std::less<>,
+                std::allocator<std::pair<std::string, int>>,
+                kouh::PrefixCacheSearch>
+      fm{{"/a/abc", 0}, {"/a/abd", 1}, {"/a/b", 2}, {"/a/bcdefghijk", 3}};
+  REQUIRE(fm.searchPolicy().prefixCount() == 4);
+  CHECK(fm.contains("/a/abd"));
+  CHECK(!fm.contains("/a/abe"));
+  CHECK(fm.find("/a/bcdefghijk")->second == 3);
+  CHECK(fm.lower_bound("/a/bcdefghij")->second == 3);
+  CHECK(fm.lower_bound("/") == fm.begin());
+  CHECK(fm.lower_bound("/b") == fm.end());
+  char const* const key = "/a/b";
+  CHECK(fm.find(key)->second == 2);
+}
+
+namespace
+{
+/// A key that cannot be built from the type it is looked up with.
+struct Id
+{
+  explicit Id(int v) : value{v}
+  {
+  }
+
+  int value;
+};
+
+struct IdLess
+{
+  using is_transparent = void;
+
+  bool operator()(Id const& a, Id const& b) const noexcept
+  {
+    return a.value < b.value;
+  }
+  bool operator()(Id const& a, int b) const noexcept
+  {
+    return a.value < b;
+  }
+  bool operator()(int a, Id const& b) const noexcept
+  {
+    return a < b.value;
+  }
+};
+}
+
+TEST_CASE("Heterogeneous lookup", "[FlatMap]")
+{
+  SECTION("std::string keys with std::less<>")
+  {
+    kouh::FlatMap<std::string, int, std::less<>> fm = {
+        {"4", 4}, {"8", 8}, {"42", 42}, {"1337", 1337}, {"4269", 4269}};
+    char const* const key = "42";
+
+    CHECK(fm.find(key)->second == 42);
+    CHECK(fm.find("foo") == fm.end());
+    CHECK(fm.count(key) == 1);
+    CHECK(fm.contains("4269"));
+    CHECK(!fm.contains("foo"));
+    CHECK(fm.lower_bound("40")->first == "42");
+    CHECK(fm.upper_bound("42")->first == "4269");
+
+    auto const range = fm.equal_range("42");
+    CHECK(range.first->first == "42");
+    CHECK(range.second - range.first == 1);
+    auto const emptyRange = fm.equal_range("40");
+    CHECK(emptyRange.first == emptyRange.second);
+  }
+
+  SECTION("Key not constructible from the lookup type")
+  {
+    kouh::FlatMap<Id, int, IdLess> fm;
+    fm.emplace(Id{4}, 4);
+    fm.emplace(Id{8}, 8);
+    fm.emplace(Id{15}, 15);
+    auto const& cfm = fm;
+
+    CHECK(fm.find(8)->second == 8);
+    CHECK(cfm.find(8)->second == 8);
+    CHECK(cfm.find(9) == cfm.end());
+    CHECK(cfm.count(15) == 1);
+    CHECK(cfm.lower_bound(9)->second == 15);
+    CHECK(cfm.upper_bound(15) == cfm.end());
+    CHECK(cfm.equal_range(4).first == cfm.begin());
+  }
+}
+
+TEST_CASE("count / contains", "[FlatMap]")
+{
+  FlatMap<std::string, int> fm = {{"4", 4}, {"8", 8}};
+  CHECK(fm.count("4") == 1);
+  CHECK(fm.count("foo") == 0);
+  CHECK(fm.contains("8"));
+  CHECK(!fm.contains("foo"));
+}
+
+namespace
+{
+/// Counts how many times it was built from an int.
+struct Counted
+{
+  static int constructions;
+
+  Counted(int v) : value{v}
+  {
+    ++constructions;
+  }
+
+  int value;
+};
+int Counted::constructions = 0;
+}
+
+TEST_CASE("try_emplace / insert_or_assign", "[FlatMap]")
+{
+  FlatMap<std::string, Counted> fm;
+  fm.try_emplace("4", 4);
+  fm.try_emplace("8", 8);
+  Counted::constructions = 0;
+
+  SECTION("try_emplace on existing key constructs nothing")
+  {
+    auto const ret = fm.try_emplace("4", 5);
+    CHECK(!ret.second);
+    CHECK(ret.first == fm.find("4"));
+    CHECK(ret.first->second.value == 4);
+    CHECK(Counted::constructions == 0);
+  }
+
+  SECTION("try_emplace on new key")
+  {
+    auto const ret = fm.try_emplace("1", 1);
+    CHECK(ret.second);
+    CHECK(ret.first == fm.find("1"));
+    CHECK(ret.first->second.value == 1);
+    CHECK(Counted::constructions == 1);
+    CHECK(fm.size() == 3);
+  }
+
+  SECTION("try_emplace leaves moved-from arguments untouched")
+  {
+    FlatMap<int, std::string> fms;
+    fms.try_emplace(1, "one");
+    std::string value = "uno";
+    fms.try_emplace(1, std::move(value));
+    CHECK(value == "uno");
+    CHECK(fms.at(1) == "one");
+  }
+
+  SECTION("try_emplace with an rvalue key")
+  {
+    std::string key = "16";
+    fm.try_emplace(std::move(key), 16);
+    CHECK(fm.at("16").value == 16);
+  }
+
+  SECTION("insert_or_assign")
+  {
+    auto ret = fm.insert_or_assign("4", Counted{5});
+    CHECK(!ret.second);
+    CHECK(fm.at("4").value == 5);
+    ret = fm.insert_or_assign("5", Counted{5});
+    CHECK(ret.second);
+    CHECK(ret.first->second.value == 5);
+    CHECK(fm.size() == 3);
+  }
+
+  SECTION("operator[] with an rvalue key")
+  {
+    FlatMap<std::string, int> fmi;
+    std::string key = "42";
+    fmi[std::move(key)] = 42;
+    CHECK(fmi.at("42") == 42);
+    CHECK(fmi[std::string{"42"}] == 42);
+    CHECK(fmi.size() == 1);
+  }
+}
+
+TEST_CASE("Hinted and in-order insertion", "[FlatMap]")
+{
+  SECTION("In-order appends")
+  {
+    FlatMap<int, int> fm;
+    for (int i = 0; i < 100; ++i)
+      CHECK(fm.emplace(i, i).second);
+    CHECK(!fm.emplace(99, 0).second);
+    CHECK(fm.try_emplace(100, 100).second);
+    CHECK(fm.size() == 101);
+    CHECK(std::is_sorted(fm.begin(), fm.end()));
+  }
+
+  FlatMap<int, int> fm = {{10, 10}, {20, 20}, {30, 30}};
+
+  SECTION("Correct hint")
+  {
+    auto const it = fm.emplace_hint(fm.find(20), 15, 15);
+    CHECK(it->first == 15);
+    CHECK(it == fm.begin() + 1);
+    CHECK(fm.size() == 4);
+  }
+
+  SECTION("Hint at end")
+  {
+    auto const it = fm.emplace_hint(fm.end(), 40, 40);
+    CHECK(it == fm.end() - 1);
+    CHECK(fm.size() == 4);
+  }
+
+  SECTION("Wrong hint")
+  {
+    auto const it = fm.emplace_hint(fm.begin(), 25, 25);
+    CHECK(it->first == 25);
+    CHECK(fm.size() == 4);
+    CHECK(std::is_sorted(fm.begin(), fm.end()));
+  }
+
+  SECTION("Hint on existing key")
+  {
+    auto it = fm.emplace_hint(fm.find(20), 20, 0);
+    CHECK(it == fm.find(20));
+    CHECK(it->second == 20);
+    it = fm.emplace_hint(fm.find(30), 20, 0);
+    CHECK(it == fm.find(20));
+    it = fm.emplace_hint(fm.begin(), 30, 0);
+    CHECK(it == fm.find(30));
+    CHECK(fm.size() == 3);
+  }
+}
+
+TEST_CASE("merge", "[FlatMap]")
+{
+  FlatMap<std::string, int> fm = {{"a", 1}, {"c", 3}, {"e", 5}};
+  FlatMap<std::string, int> other = {{"b", 20}, {"c", 30}, {"f", 60}};
+
+  SECTION("Moved, first wins")
+  {
+    fm.merge(std::move(other));
+    CHECK(other.empty());
+    REQUIRE(fm.size() == 5);
+    CHECK(std::is_sorted(fm.begin(), fm.end()));
+    CHECK(fm.at("b") == 20);
+    CHECK(fm.at("c") == 3);
+    CHECK(fm.at("f") == 60);
+  }
+
+  SECTION("Copied, last wins")
+  {
+    fm.merge(other, kouh::DuplicatePolicy::KeepLast);
+    CHECK(other.size() == 3);
+    REQUIRE(fm.size() == 5);
+    CHECK(fm.at("c") == 30);
+  }
+
+  SECTION("Conflict resolution")
+  {
+    fm.merge(other, [](std::string const& key, int& mine, int const& theirs) {
+      CHECK(key == "c");
+      mine += theirs;
+    });
+    REQUIRE(fm.size() == 5);
+    CHECK(fm.at("c") == 33);
+  }
+
+  SECTION("Non-copyable values")
+  {
+    FlatMap<int, NoCopy> a;
+    a.emplace(1, 1);
+    a.emplace(3, 3);
+    FlatMap<int, NoCopy> b;
+    b.emplace(2, 2);
+    b.emplace(3, 4);
+    a.merge(std::move(b), [](int, NoCopy& mine, NoCopy& theirs) {
+      mine = std::move(theirs);
+    });
+    REQUIRE(a.size() == 3);
+    CHECK(a.at(2) == 2);
+    CHECK(a.at(3) == 4);
+  }
+
+  SECTION("Into itself")
+  {
+    auto const copy = fm;
+    auto const unchanged = [&fm, &copy]() {
+      return std::equal(fm.begin(), fm.end(), copy.begin(), copy.end());
+    };
+    auto const resolve = [](std::string const&, int& mine, int const&) {
+      mine = 0;
+    };
+    fm.merge(std::move(fm));
+    CHECK(unchanged());
+    fm.merge(fm, kouh::DuplicatePolicy::KeepLast);
+    CHECK(unchanged());
+    fm.merge(std::move(fm), resolve);
+    CHECK(unchanged());
+    fm.merge(fm, resolve);
+    CHECK(unchanged());
+  }
+}
+
+TEST_CASE("Set operations", "[FlatMap]")
+{
+  FlatMap<int, int> const a = {{1, 1}, {2, 2}, {4, 4}, {6, 6}};
+  FlatMap<int, int> const b = {{2, 20}, {3, 30}, {6, 60}, {7, 70}};
+
+  SECTION("Union")
+  {
+    auto const u = kouh::setUnion(a, b);
+    REQUIRE(u.size() == 6);
+    CHECK(std::is_sorted(u.begin(), u.end()));
+    CHECK(u.at(2) == 2);
+    CHECK(u.at(7) == 70);
+
+    auto const sum =
+        kouh::setUnion(a, b, [](int, int x, int y) { return x + y; });
+    CHECK(sum.at(6) == 66);
+    CHECK(sum.at(4) == 4);
+  }
+
+  SECTION("Intersection")
+  {
+    auto const i = kouh::setIntersection(a, b);
+    REQUIRE(i.size() == 2);
+    CHECK(i.at(2) == 2);
+    CHECK(i.at(6) == 6);
+
+    auto const product =
+        kouh::setIntersection(a, b, [](int, int x, int y) { return x * y; });
+    CHECK(product.at(2) == 40);
+  }
+
+  SECTION("Difference")
+  {
+    FlatMap<int, std::string> const keys = {{2, "2"}, {4, "4"}, {5, "5"}};
+    auto const d = kouh::setDifference(a, keys);
+    REQUIRE(d.size() == 2);
+    CHECK(d.at(1) == 1);
+    CHECK(d.at(6) == 6);
+  }
+}
+
+TEST_CASE("Batch lookup", "[FlatMap]")
+{
+  for (int n : {0, 1, 2, 3, 17, 100})
+  {
+    FlatMap<std::string, int> fm;
+    for (int i = 0; i < n; ++i)
+      fm.emplace(std::to_string(2 * i), i);
+
+    std::vector<std::string> keys;
+    for (int i = -1; i < 2 * n + 40; ++i)
+      keys.push_back(std::to_string(i));
+
+    std::vector<FlatMap<std::string, int>::const_iterator> found;
+    fm.find_batch(keys.begin(), keys.end(), std::back_inserter(found));
+    std::vector<bool> contained;
+    fm.contains_batch(keys.begin(), keys.end(), std::back_inserter(contained));
+
+    REQUIRE(found.size() == keys.size());
+    REQUIRE(contained.size() == keys.size());
+    auto const& cfm = fm;
+    for (std::size_t i = 0; i < keys.size(); ++i)
+    {
+      REQUIRE(found[i] == cfm.find(keys[i]));
+      REQUIRE(contained[i] == fm.contains(keys[i]));
+    }
+  }
+}
+
+TEST_CASE("Custom allocator", "[FlatMap]")
+{
+  using Map = kouh::
+      FlatMap<int, int, std::less<int>, ArenaAllocator<std::pair<int, int>>>;
+  Arena arena;
+  ArenaAllocator<std::pair<int, int>> const alloc{arena};
+
+  Map fm{alloc};
+  CHECK(arena.used == 0);
+  for (int i = 0; i < 100; ++i)
+    fm.emplace(99 - i, i);
+  CHECK(arena.used > 0);
+  CHECK(fm.get_allocator() == alloc);
+  CHECK(fm.begin()->first == 0);
+  CHECK(fm.at(42) == 57);
+
+  Map other{{{7, 0}, {1000, 1}}, alloc};
+  auto const used = arena.used;
+  fm.merge(std::move(other));
+  CHECK(fm.size() == 101);
+  CHECK(arena.used > used);
+  CHECK(setUnion(fm, fm).get_allocator() == alloc);
+}
+
+#ifdef KOUH_HAS_PMR
+TEST_CASE("pmr alias", "[FlatMap]")
+{
+  std::pmr::monotonic_buffer_resource arena;
+  kouh::pmr::FlatMap<int, int> fm{&arena};
+  fm.emplace(1, 2);
+  CHECK(fm.get_allocator().resource() == &arena);
+  CHECK(fm.at(1) == 2);
+  // Moving a vector from another resource copies its elements.
+  CHECK(!noexcept(fm.replace(fm.extract())));
+}
+#endif
@@ -0,0 +1,195 @@
+#include <catch2/catch.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include <kouh/FlatMap.hpp>
+#include <kouh/FlatMapView.hpp>
+#include <kouh/MappedFile.hh>
+
+using kouh::FlatMap;
+using kouh::FlatMapView;
+
+namespace
+{
+/// Returns the serialized fm, in a buffer aligned like a mapping.
+template <typename Map>
+std::vector<std::uint64_t> serialized(Map const& fm)
+{
+  std::ostringstream out;
+  kouh::serialize(fm, out);
+  auto const bytes = out.str();
+  std::vector<std::uint64_t> ret((bytes.size() + 7) / 8);
+  std::memcpy(ret.data(), bytes.data(), bytes.size());
+  return ret;
+}
+
+template <typename Key, typename Value>
+FlatMapView<Key, Value> view(std::vector<std::uint64_t> const& buffer)
+{
+  return {buffer.data(), buffer.size() * 8};
+}
+}
+
+TEST_CASE("[FlatMapView] Empty", "[FlatMapView]")
+{
+  auto const buffer = serialized(FlatMap<int, int>{});
+  auto const fmv = view<int, int>(buffer);
+  CHECK(fmv.empty());
+  CHECK(fmv.size() == 0);
+  CHECK(fmv.begin() == fmv.end());
+  CHECK(fmv.find(3) == fmv.end());
+  CHECK_THROWS_AS(fmv.at(3), std::out_of_range);
+}
+
+TEST_CASE("[FlatMapView] Trivially copyable types", "[FlatMapView]")
+{
+  FlatMap<std::int64_t, double> fm;
+  for (std::int64_t i = -500; i < 500; ++i)
+    fm.emplace(3 * i, static_cast<double>(i) / 2);
+  auto const buffer = serialized(fm);
+  auto const fmv = view<std::int64_t, double>(buffer);
+  REQUIRE(fmv.size() == fm.size());
+
+  auto it = fmv.begin();
+  for (auto const& pair : fm)
+  {
+    CHECK((*it).first == pair.first);
+    CHECK((*it).second == pair.second);
+    ++it;
+  }
+  CHECK(it == fmv.end());
+  // References are proxies, so only the input iterator category holds.
+  using Iterator = FlatMapView<std::int64_t, double>::const_iterator;
+  CHECK((std::is_same<std::iterator_traits<Iterator>::iterator_category,
+                      std::input_iterator_tag>::value));
+
+  for (std::int64_t key = -1600; key < 1600; ++key)
+  {
+    CHECK(fmv.contains(key) == fm.contains(key));
+    if (fm.contains(key))
+      CHECK(fmv.at(key) == fm.at(key));
+  }
+  CHECK((*fmv.find(42)).second == 7.);
+}
+
+TEST_CASE("[FlatMapView] Strings", "[FlatMapView]")
+{
+  FlatMap<std::string, std::string> fm = {{"", "empty"},
+                                          {"one", "1"},
+                                          {"two", ""},
+                                          {"three", "3"},
+                                          {"a longer key than fits in SSO",
+                                           "and a longer value as well"}};
+  auto const buffer = serialized(fm);
+  auto const fmv = view<std::string, std::string>(buffer);
+  REQUIRE(fmv.size() == fm.size());
+  for (auto const& pair : fm)
+  {
+    auto const it = fmv.find(pair.first);
+    REQUIRE(it != fmv.end());
+    CHECK((*it).first == pair.first);
+    CHECK((*it).second == pair.second);
+    CHECK(fmv.at(pair.first).str() == pair.second);
+  }
+  CHECK(!fmv.contains("on"));
+  CHECK(!fmv.contains("onee"));
+  CHECK(!fmv.contains("zzz"));
+
+  FlatMap<std::string, int> const counts = {{"a", 1}, {"b", 2}};
+  auto const countsBuffer = serialized(counts);
+  CHECK(view<std::string, int>(countsBuffer).at("b") == 2);
+  FlatMap<int, std::string> const names = {{1, "a"}, {2, "b"}};
+  auto const namesBuffer = serialized(names);
+  CHECK(view<int, std::string>(namesBuffer).at(2) == "b");
+}
+
+TEST_CASE("[FlatMapView] Invalid data", "[FlatMapView]")
+{
+  FlatMap<int, int> const fm = {{1, 2}, {3, 4}};
+  auto buffer = serialized(fm);
+  auto const size = buffer.size() * 8;
+
+  // Other types.
+  CHECK_THROWS_AS((FlatMapView<int, double>{buffer.data(), size}),
+                  std::invalid_argument);
+  CHECK_THROWS_AS((FlatMapView<std::string, int>{buffer.data(), size}),
+                  std::invalid_argument);
+  // Truncated.
+  CHECK_THROWS_AS((FlatMapView<int, int>{buffer.data(), size - 8}),
+                  std::invalid_argument);
+  CHECK_THROWS_AS((FlatMapView<int, int>{buffer.data(), 4}),
+                  std::invalid_argument);
+  // Misaligned.
+  CHECK_THROWS_AS(
+      (FlatMapView<int, int>{reinterpret_cast<char const*>(buffer.data()) + 1,
+                             size - 1}),
+      std::invalid_argument);
+  // Not a serialized container.
+  buffer[0] = 0;
+  CHECK_THROWS_AS((FlatMapView<int, int>{buffer.data(), size}),
+                  std::invalid_argument);
+}
+
+TEST_CASE("[FlatMapView] Corrupted string offsets", "[FlatMapView]")
+{
+  FlatMap<std::string, int> const fm = {{"ab", 1}, {"c", 2}, {"def", 3}};
+  auto buffer = serialized(fm);
+  auto const size = buffer.size() * 8;
+  // The offsets 0, 2, 3, 6 follow the header.
+  auto const offsets = sizeof(kouh::detail::SerializedHeader) / 8;
+  REQUIRE(buffer[offsets + 1] == 2);
+  CHECK(view<std::string, int>(buffer).at("c") == 2);
+
+  SECTION("Decreasing")
+  {
+    buffer[offsets + 1] = 5;
+    CHECK_THROWS_AS((FlatMapView<std::string, int>{buffer.data(), size}),
+                    std::invalid_argument);
+  }
+  SECTION("Past the column")
+  {
+    buffer[offsets + 1] = std::uint64_t{1} << 40;
+    buffer[offsets + 2] = std::uint64_t{1} << 40;
+    CHECK_THROWS_AS((FlatMapView<std::string, int>{buffer.data(), size}),
+                    std::invalid_argument);
+  }
+}
+
+TEST_CASE("[FlatMapView] Mapped file", "[FlatMapView]")
+{
+  char const* const path = "TestFlatMapView.bin";
+  FlatMap<std::string, std::uint32_t> fm;
+  for (std::uint32_t i = 0; i < 1000; ++i)
+    fm.emplace("/page/" + std::to_string(i), i);
+  {
+    std::ofstream out{path, std::ios::binary};
+    kouh::serialize(fm, out);
+  }
+
+  {
+    kouh::MappedFile const file{path};
+    FlatMapView<std::string, std::uint32_t> const fmv{file.data(),
+                                                      file.size()};
+    REQUIRE(fmv.size() == fm.size());
+    for (auto const& pair : fm)
+      CHECK(fmv.at(pair.first) == pair.second);
+
+    auto moved = kouh::MappedFile{path};
+    auto other = std::move(moved);
+    CHECK(moved.data() == nullptr);
+    CHECK(other.size() == file.size());
+  }
+  std::remove(path);
+
+  CHECK_THROWS_AS(kouh::MappedFile{path}, std::system_error);
+}
@@ -0,0 +1,118 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <kouh/FlatMultiMap.hpp>
+
+using kouh::FlatMultiMap;
+
+TEST_CASE("[FlatMultiMap] Initialization", "[FlatMultiMap]")
+{
+  SECTION("Empty")
+  {
+    FlatMultiMap<int, int> fmm{};
+    CHECK(fmm.size() == 0);
+    CHECK(fmm.empty());
+    CHECK(fmm.begin() == fmm.end());
+    CHECK(fmm.find(4) == fmm.end());
+  }
+
+  SECTION("Init list keeps duplicates in order")
+  {
+    FlatMultiMap<int, std::string> fmm = {
+        {2, "a"}, {1, "b"}, {2, "c"}, {1, "d"}, {2, "e"}};
+    CHECK(fmm.size() == 5);
+    std::vector<std::string> values;
+    for (auto const& pair : fmm)
+      values.push_back(pair.second);
+    CHECK(values == (std::vector<std::string>{"b", "d", "a", "c", "e"}));
+  }
+}
+
+TEST_CASE("[FlatMultiMap] Lookup", "[FlatMultiMap]")
+{
+  FlatMultiMap<std::string, int> fmm = {
+      {"a", 1}, {"b", 2}, {"b", 3}, {"c", 4}, {"b", 5}};
+
+  CHECK(fmm.count("b") == 3);
+  CHECK(fmm.count("d") == 0);
+  CHECK(fmm.find("b")->second == 2);
+  CHECK(fmm.find("d") == fmm.end());
+  CHECK(fmm.contains("c"));
+  auto const range = fmm.equal_range("b");
+  CHECK(range.second - range.first == 3);
+  CHECK(range.second->first == "c");
+  CHECK(fmm.lower_bound("b") == range.first);
+  CHECK(fmm.upper_bound("b") == range.second);
+
+  auto const& cfmm = fmm;
+  CHECK(cfmm.find("a")->second == 1);
+  CHECK(cfmm.equal_range("a").first == cfmm.begin());
+}
+
+TEST_CASE("[FlatMultiMap] Against std::multimap", "[FlatMultiMap]")
+{
+  FlatMultiMap<int, int> fmm;
+  std::multimap<int, int> reference;
+  std::mt19937 rng{42};
+  std::uniform_int_distribution<int> keys{0, 100};
+
+  for (int i = 0; i < 2000; ++i)
+  {
+    auto const key = keys(rng);
+    if (i % 5 == 4)
+    {
+      REQUIRE(fmm.erase(key) == reference.erase(key));
+    }
+    else
+    {
+      auto const it = fmm.emplace(key, i);
+      reference.emplace(key, i);
+      REQUIRE(it->first == key);
+      REQUIRE(it->second == i);
+    }
+    REQUIRE(fmm.count(key) == reference.count(key));
+  }
+
+  SECTION("Bulk insertion")
+  {
+    std::vector<std::pair<int, int>> more;
+    for (int i = 0; i < 500; ++i)
+      more.emplace_back(keys(rng), -i);
+    fmm.insert(more.begin(), more.end());
+    reference.insert(more.begin(), more.end());
+  }
+
+  REQUIRE(fmm.size() == reference.size());
+  CHECK(std::equal(fmm.begin(),
+                   fmm.end(),
+                   reference.begin(),
+                   [](std::pair<int, int> const& a,
+                      std::pair<int const, int> const& b) {
+                     return a.first == b.first && a.second == b.second;
+                   }));
+}
+
+TEST_CASE("[FlatMultiMap] Parallel bulk construction", "[FlatMultiMap]")
+{
+  // Large enough to be sorted on several threads, which must stay stable.
+  std::vector<std::pair<int, int>> pairs;
+  std::mt19937 rng{42};
+  std::uniform_int_distribution<int> keys{0, 1000};
+  for (int i = 0; i < 400000; ++i)
+    pairs.emplace_back(keys(rng), i);
+  FlatMultiMap<int, int> const fmm{pairs.begin(), pairs.end()};
+  std::multimap<int, int> const reference(pairs.begin(), pairs.end());
+  REQUIRE(fmm.size() == reference.size());
+  CHECK(std::equal(fmm.begin(),
+                   fmm.end(),
+                   reference.begin(),
+                   [](std::pair<int, int> const& a,
+                      std::pair<int const, int> const& b) {
+                     return a.first == b.first && a.second == b.second;
+                   }));
+}
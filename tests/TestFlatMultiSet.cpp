@@ -0,0 +1,82 @@
+#include <catch2/catch.hpp>
+
+#include <random>
+#include <set>
+#include <vector>
+
+#include <kouh/FlatMultiSet.hpp>
+
+using kouh::FlatMultiSet;
+
+TEST_CASE("[FlatMultiSet] Initialization", "[FlatMultiSet]")
+{
+  SECTION("Empty")
+  {
+    FlatMultiSet<int> fms{};
+    CHECK(fms.size() == 0);
+    CHECK(fms.empty());
+    CHECK(fms.begin() == fms.end());
+    CHECK(fms.count(4) == 0);
+  }
+
+  SECTION("Init list keeps duplicates")
+  {
+    FlatMultiSet<int> fms = {4, 1, 3, 1, 2, 4, 4};
+    CHECK(fms.size() == 7);
+    CHECK(std::vector<int>(fms.begin(), fms.end()) ==
+          (std::vector<int>{1, 1, 2, 3, 4, 4, 4}));
+  }
+
+  SECTION("Sorted equivalent adoption")
+  {
+    FlatMultiSet<int> fms{kouh::sorted_equivalent,
+                          std::vector<int>{1, 1, 5, 9}};
+    CHECK(fms.count(1) == 2);
+  }
+}
+
+TEST_CASE("[FlatMultiSet] Lookup", "[FlatMultiSet]")
+{
+  FlatMultiSet<int> fms = {1, 3, 3, 3, 5, 8};
+
+  CHECK(fms.count(3) == 3);
+  CHECK(fms.count(4) == 0);
+  CHECK(fms.find(3) == fms.begin() + 1);
+  CHECK(fms.find(4) == fms.end());
+  CHECK(fms.contains(8));
+  auto const range = fms.equal_range(3);
+  CHECK(range.first == fms.lower_bound(3));
+  CHECK(range.second == fms.upper_bound(3));
+  CHECK(*range.second == 5);
+}
+
+TEST_CASE("[FlatMultiSet] Against std::multiset", "[FlatMultiSet]")
+{
+  FlatMultiSet<int> fms;
+  std::multiset<int> reference;
+  std::mt19937 rng{42};
+  std::uniform_int_distribution<int> keys{0, 100};
+
+  for (int i = 0; i < 2000; ++i)
+  {
+    auto const key = keys(rng);
+    if (i % 5 == 4)
+    {
+      REQUIRE(fms.erase(key) == reference.erase(key));
+    }
+    else if (i % 5 == 3)
+    {
+      auto const hint = fms.lower_bound(keys(rng));
+      REQUIRE(*fms.emplace_hint(hint, key) == key);
+      reference.insert(key);
+    }
+    else
+    {
+      REQUIRE(*fms.insert(key) == key);
+      reference.insert(key);
+    }
+    REQUIRE(fms.count(key) == reference.count(key));
+  }
+  REQUIRE(fms.size() == reference.size());
+  CHECK(std::equal(fms.begin(), fms.end(), reference.begin()));
+}
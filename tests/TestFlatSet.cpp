@@ -0,0 +1,79 @@
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+
+#include <kouh/FlatSet.hpp>
+
+using kouh::FlatSet;
+
+TEST_CASE("[FlatSet] Initialization", "[FlatSet]")
+{
+  SECTION("Empty")
+  {
+    FlatSet<int> fs{};
+    CHECK(fs.size() == 0);
+    CHECK(fs.empty());
+    CHECK(fs.begin() == fs.end());
+    CHECK(fs.find(4) == fs.end());
+  }
+
+  SECTION("Init list")
+  {
+    FlatSet<int> fs = {4, 1, 3, 1, 2};
+    CHECK(fs.size() == 4);
+    CHECK(std::vector<int>(fs.begin(), fs.end()) ==
+          (std::vector<int>{1, 2, 3, 4}));
+  }
+
+  SECTION("Sorted unique adoption")
+  {
+    FlatSet<int> fs{kouh::sorted_unique, std::vector<int>{1, 5, 9}};
+    CHECK(fs.size() == 3);
+    CHECK(fs.contains(5));
+  }
+}
+
+TEST_CASE("[FlatSet] Lookup", "[FlatSet]")
+{
+  FlatSet<std::string> fs = {"4", "8", "42", "1337"};
+
+  CHECK(*fs.find("42") == "42");
+  CHECK(fs.find("foo") == fs.end());
+  CHECK(fs.count("8") == 1);
+  CHECK(fs.count("foo") == 0);
+  CHECK(*fs.lower_bound("41") == "42");
+  CHECK(*fs.upper_bound("42") == "8");
+  auto const hit = fs.equal_range("42");
+  CHECK(hit.second - hit.first == 1);
+  auto const miss = fs.equal_range("5");
+  CHECK(miss.first == miss.second);
+  CHECK(*miss.first == "8");
+}
+
+TEST_CASE("[FlatSet] Modifiers", "[FlatSet]")
+{
+  FlatSet<int> fs;
+  CHECK(fs.insert(3).second);
+  CHECK(fs.emplace(1).second);
+  CHECK(!fs.insert(3).second);
+  CHECK(*fs.emplace_hint(fs.end(), 5) == 5);
+  CHECK(*fs.emplace_hint(fs.begin(), 3) == 3);
+  CHECK(fs.size() == 3);
+
+  std::vector<int> const more{9, 0, 5, 7, 0};
+  fs.insert(more.begin(), more.end());
+  CHECK(std::vector<int>(fs.begin(), fs.end()) ==
+        (std::vector<int>{0, 1, 3, 5, 7, 9}));
+
+  CHECK(fs.erase(3) == 1);
+  CHECK(fs.erase(3) == 0);
+  CHECK(*fs.erase(fs.begin()) == 1);
+  CHECK(fs.size() == 4);
+
+  auto keys = fs.extract();
+  CHECK(fs.empty());
+  keys.push_back(10);
+  fs.replace(std::move(keys));
+  CHECK(fs.contains(10));
+}
@@ -1,6 +1,11 @@
 #include <catch2/catch.hpp>
 
+#include <cstddef>
+#include <memory>
+#include <string>
+
 #include <kouh/FlatUnorderedSet.hpp>
+#include <kouh/PerfectHashSet.hpp>
 
 template <typename Value, typename Pred = std::equal_to<Value>>
 using FlatUnorderedSet = kouh::FlatUnorderedSet<Value, Pred>;
@@ -32,6 +37,44 @@ struct NoCopy
 
   int a;
 };
+
+/// Counts the allocations it makes.
+template <typename T>
+struct CountingAllocator
+{
+  using value_type = T;
+
+  explicit CountingAllocator(int& c) noexcept : count{&c}
+  {
+  }
+  template <typename U>
+  CountingAllocator(CountingAllocator<U> const& b) noexcept : count{b.count}
+  {
+  }
+
+  T* allocate(std::size_t n)
+  {
+    ++*this->count;
+    return std::allocator<T>{}.allocate(n);
+  }
+  void deallocate(T* p, std::size_t n) noexcept
+  {
+    std::allocator<T>{}.deallocate(p, n);
+  }
+
+  template <typename U>
+  bool operator==(CountingAllocator<U> const& b) const noexcept
+  {
+    return this->count == b.count;
+  }
+  template <typename U>
+  bool operator!=(CountingAllocator<U> const& b) const noexcept
+  {
+    return this->count != b.count;
+  }
+
+  int* count;
+};
 }
 
 TEST_CASE("[FlatUnorderedSet] Initialization", "[FlatUnorderedSet]")
@@ -140,6 +183,29 @@ TEST_CASE("[FlatUnorderedSet] erase", "[FlatUnorderedSet]")
   }
 }
 
+TEST_CASE("[FlatUnorderedSet] erase_if / retain", "[FlatUnorderedSet]")
+{
+  FlatUnorderedSet<int> fus = {4, 8, 42, 1337, 4269};
+
+  SECTION("erase_if")
+  {
+    CHECK(erase_if(fus, [](int value) { return value % 2 == 0; }) == 3);
+    CHECK(fus.size() == 2);
+    CHECK(fus.contains(1337));
+    CHECK(fus.contains(4269));
+    CHECK(erase_if(fus, [](int) { return false; }) == 0);
+  }
+
+  SECTION("retain")
+  {
+    CHECK(fus.retain([](int value) { return value < 100; }) == 2);
+    CHECK(fus.size() == 3);
+    CHECK(fus.contains(4));
+    CHECK(fus.contains(8));
+    CHECK(fus.contains(42));
+  }
+}
+
 TEST_CASE("[FlatUnorderedSet] find", "[FlatUnorderedSet]")
 {
   FlatUnorderedSet<int> fus = {4, 8, 42, 1337, 4269};
@@ -216,3 +282,34 @@ TEST_CASE("[FlatUnorderedSet] emplace", "[FlatUnorderedSet]")
     CHECK(fus.size() == 5);
   }
 }
+
+TEST_CASE("[FlatUnorderedSet] Custom allocator", "[FlatUnorderedSet]")
+{
+  int allocations = 0;
+  kouh::FlatUnorderedSet<int, std::equal_to<int>, CountingAllocator<int>> fus{
+      CountingAllocator<int>{allocations}};
+  for (int i = 0; i < 10; ++i)
+    fus.emplace(i);
+  CHECK(allocations > 0);
+  CHECK(fus.size() == 10);
+  CHECK(fus.get_allocator().count == &allocations);
+}
+
+TEST_CASE("[FlatUnorderedSet] freeze", "[FlatUnorderedSet]")
+{
+  FlatUnorderedSet<std::string> fus;
+  for (int i = 0; i < 100; ++i)
+    fus.emplace(std::to_string(i));
+  auto const phs = kouh::freeze(fus);
+  CHECK(phs.size() == 100);
+  for (int i = 0; i < 100; ++i)
+    CHECK(phs.contains(std::to_string(i)));
+  CHECK(phs.find("100") == phs.end());
+  CHECK(phs.count("-1") == 0);
+  CHECK(kouh::freeze(FlatUnorderedSet<int>{}).empty());
+
+  auto const moved = kouh::freeze(std::move(fus));
+  CHECK(moved.size() == 100);
+  CHECK(moved.contains("42"));
+  CHECK(fus.empty());
+}
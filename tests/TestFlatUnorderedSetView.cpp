@@ -0,0 +1,73 @@
+#include <catch2/catch.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <kouh/FlatMap.hpp>
+#include <kouh/FlatMapView.hpp>
+#include <kouh/FlatUnorderedSet.hpp>
+#include <kouh/FlatUnorderedSetView.hpp>
+
+using kouh::FlatUnorderedSet;
+using kouh::FlatUnorderedSetView;
+
+namespace
+{
+/// Returns the serialized container, in a buffer aligned like a mapping.
+template <typename Container>
+std::vector<std::uint64_t> serialized(Container const& c)
+{
+  std::ostringstream out;
+  kouh::serialize(c, out);
+  auto const bytes = out.str();
+  std::vector<std::uint64_t> ret((bytes.size() + 7) / 8);
+  std::memcpy(ret.data(), bytes.data(), bytes.size());
+  return ret;
+}
+}
+
+TEST_CASE("[FlatUnorderedSetView] Values", "[FlatUnorderedSetView]")
+{
+  FlatUnorderedSet<int> fus;
+  for (int i = 0; i < 100; ++i)
+    fus.emplace((i * 37) % 101);
+  auto const buffer = serialized(fus);
+  FlatUnorderedSetView<int> const fusv{buffer.data(), buffer.size() * 8};
+  REQUIRE(fusv.size() == fus.size());
+  // Values keep their order.
+  CHECK(std::vector<int>(fusv.begin(), fusv.end()) ==
+        std::vector<int>(fus.begin(), fus.end()));
+  for (int i = -10; i < 110; ++i)
+    CHECK(fusv.count(i) == fus.count(i));
+}
+
+TEST_CASE("[FlatUnorderedSetView] Strings", "[FlatUnorderedSetView]")
+{
+  FlatUnorderedSet<std::string> fus = {"one", "", "three"};
+  auto const buffer = serialized(fus);
+  FlatUnorderedSetView<std::string> const fusv{buffer.data(),
+                                               buffer.size() * 8};
+  REQUIRE(fusv.size() == 3);
+  CHECK(*fusv.find("three") == "three");
+  CHECK(fusv.contains(""));
+  CHECK(!fusv.contains("on"));
+  CHECK(fusv.find("two") == fusv.end());
+}
+
+TEST_CASE("[FlatUnorderedSetView] Invalid data", "[FlatUnorderedSetView]")
+{
+  auto const set = serialized(FlatUnorderedSet<int>{1, 2, 3});
+  CHECK_THROWS_AS(
+      (FlatUnorderedSetView<std::int64_t>{set.data(), set.size() * 8}),
+      std::invalid_argument);
+  // A map is not a set.
+  auto const map = serialized(kouh::FlatMap<int, int>{{1, 2}});
+  CHECK_THROWS_AS((FlatUnorderedSetView<int>{map.data(), map.size() * 8}),
+                  std::invalid_argument);
+  CHECK_THROWS_AS((kouh::FlatMapView<int, int>{set.data(), set.size() * 8}),
+                  std::invalid_argument);
+}
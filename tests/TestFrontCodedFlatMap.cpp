@@ -0,0 +1,178 @@
+#include <catch2/catch.hpp>
+
+#include <cstddef>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <kouh/FlatMap.hpp>
+#include <kouh/FrontCodedFlatMap.hpp>
+
+using kouh::FlatMap;
+using kouh::FrontCodedFlatMap;
+
+namespace
+{
+/// Returns paths that share long prefixes, like those of a web site.
+std::vector<std::string> randomPaths(std::size_t count, unsigned seed)
+{
+  static char const* const parts[] = {
+      "api", "v1", "v2", "users", "items", "a", "ab", "abc", "", "\xff", "z"};
+  std::mt19937 rng{seed};
+  std::uniform_int_distribution<std::size_t> part{0, 10};
+  std::uniform_int_distribution<std::size_t> depth{0, 5};
+  std::vector<std::string> ret;
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    std::string path;
+    for (auto d = depth(rng); d > 0; --d)
+      path += std::string{"/"} + parts[part(rng)];
+    ret.push_back(path);
+  }
+  return ret;
+}
+
+template <typename ValueType>
+std::vector<std::pair<std::string, ValueType>> elements(
+    FrontCodedFlatMap<ValueType> const& fcm)
+{
+  std::vector<std::pair<std::string, ValueType>> ret;
+  for (auto const& element : fcm)
+    ret.emplace_back(element.first, element.second);
+  return ret;
+}
+}
+
+TEST_CASE("[FrontCodedFlatMap] Empty", "[FrontCodedFlatMap]")
+{
+  FrontCodedFlatMap<int> const fcm;
+  CHECK(fcm.empty());
+  CHECK(fcm.size() == 0);
+  CHECK(fcm.begin() == fcm.end());
+  CHECK(fcm.find("") == fcm.end());
+  CHECK(!fcm.contains(""));
+  CHECK_THROWS_AS(fcm.at("a"), std::out_of_range);
+}
+
+TEST_CASE("[FrontCodedFlatMap] Lookups", "[FrontCodedFlatMap]")
+{
+  std::vector<std::pair<std::string, int>> const pairs = {
+      {"b", 2}, {"abc", 3}, {"", 0}, {"ab", 1}, {"abd", 4}, {"b", 5}};
+  FrontCodedFlatMap<int> const fcm{pairs.begin(), pairs.end()};
+  REQUIRE(fcm.size() == 5);
+  CHECK(fcm.at("") == 0);
+  CHECK(fcm.at("ab") == 1);
+  CHECK(fcm.at("abc") == 3);
+  CHECK(fcm.at("abd") == 4);
+  CHECK(fcm.at("b") == 2);
+  CHECK(fcm.count("a") == 0);
+  CHECK(fcm.count("abcd") == 0);
+  CHECK(fcm.count("c") == 0);
+  CHECK(fcm.contains("abcX", 3));
+  CHECK((*fcm.find("abd")).first == "abd");
+  CHECK((*fcm.find("abd")).second == 4);
+  CHECK(fcm.find("aa") == fcm.end());
+
+  // Keys are decoded inside iterators, so only the input category holds.
+  using Iterator = FrontCodedFlatMap<int>::const_iterator;
+  CHECK((std::is_same<std::iterator_traits<Iterator>::iterator_category,
+                      std::input_iterator_tag>::value));
+
+  FrontCodedFlatMap<int> const last{
+      pairs.begin(), pairs.end(), kouh::DuplicatePolicy::KeepLast};
+  CHECK(last.at("b") == 5);
+}
+
+TEST_CASE("[FrontCodedFlatMap] Move-only values", "[FrontCodedFlatMap]")
+{
+  std::vector<std::pair<std::string, std::unique_ptr<int>>> pairs;
+  pairs.emplace_back("b", std::make_unique<int>(2));
+  pairs.emplace_back("a", std::make_unique<int>(1));
+  FrontCodedFlatMap<std::unique_ptr<int>> const fcm{
+      std::make_move_iterator(pairs.begin()),
+      std::make_move_iterator(pairs.end())};
+  REQUIRE(fcm.size() == 2);
+  CHECK(*fcm.at("a") == 1);
+  CHECK(*fcm.at("b") == 2);
+}
+
+TEST_CASE("[FrontCodedFlatMap] Against std::map", "[FrontCodedFlatMap]")
+{
+  std::map<std::string, std::size_t> reference;
+  std::vector<std::pair<std::string, std::size_t>> pairs;
+  auto const paths = randomPaths(2000, 42);
+  for (std::size_t i = 0; i < paths.size(); ++i)
+  {
+    pairs.emplace_back(paths[i], i);
+    reference.emplace(paths[i], i);
+  }
+  FrontCodedFlatMap<std::size_t> const fcm{pairs.begin(), pairs.end()};
+  REQUIRE(fcm.size() == reference.size());
+  CHECK(elements(fcm) ==
+        std::vector<std::pair<std::string, std::size_t>>(reference.begin(),
+                                                         reference.end()));
+
+  SECTION("Lookups")
+  {
+    for (auto const& path : randomPaths(2000, 43))
+    {
+      auto const it = reference.find(path);
+      if (it == reference.end())
+      {
+        CHECK(fcm.find(path) == fcm.end());
+        CHECK_THROWS_AS(fcm.at(path), std::out_of_range);
+      }
+      else
+      {
+        CHECK(fcm.at(path) == it->second);
+        CHECK((*fcm.find(path)).first == path);
+      }
+    }
+  }
+
+  SECTION("Keys next to present keys")
+  {
+    for (auto const& element : reference)
+    {
+      auto const& key = element.first;
+      CHECK(fcm.contains(key) == true);
+      CHECK(fcm.contains(key + '\0') == (reference.count(key + '\0') == 1));
+      CHECK(fcm.contains(key + "/a") == (reference.count(key + "/a") == 1));
+      if (!key.empty())
+      {
+        auto const prefix = key.substr(0, key.size() - 1);
+        CHECK(fcm.contains(prefix) == (reference.count(prefix) == 1));
+      }
+    }
+  }
+}
+
+TEST_CASE("[FrontCodedFlatMap] From a FlatMap", "[FrontCodedFlatMap]")
+{
+  FlatMap<std::string, unsigned> fm;
+  for (unsigned i = 0; i < 1000; ++i)
+    fm.emplace("/static/assets/images/" + std::to_string(i) + ".png", i);
+  FrontCodedFlatMap<unsigned> const fcm{kouh::sorted_unique,
+                                        fm.begin(),
+                                        fm.end()};
+  REQUIRE(fcm.size() == fm.size());
+  std::size_t keyBytes = 0;
+  auto it = fcm.begin();
+  for (auto const& pair : fm)
+  {
+    keyBytes += pair.first.size();
+    CHECK((*it).first == pair.first);
+    CHECK((*it).second == pair.second);
+    CHECK(fcm.at(pair.first) == pair.second);
+    ++it;
+  }
+  CHECK(it == fcm.end());
+  // Most of each key is a prefix shared with the key before it.
+  CHECK(fcm.keyStorageSize() < keyBytes / 2);
+}
@@ -0,0 +1,88 @@
+#include <catch2/catch.hpp>
+
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <kouh/FrozenFlatMap.hpp>
+
+using kouh::FrozenFlatMap;
+using kouh::makeFrozenFlatMap;
+
+namespace
+{
+enum class Keyword
+{
+  If,
+  Else,
+  While,
+  Return,
+};
+
+/// Orders C strings by content, at compile time.
+struct StrLess
+{
+  constexpr bool operator()(char const* a, char const* b) const noexcept
+  {
+    while (*a != '\0' && *a == *b)
+    {
+      ++a;
+      ++b;
+    }
+    return *a < *b;
+  }
+};
+
+constexpr auto keywords = makeFrozenFlatMap(
+    std::array<std::pair<char const*, Keyword>, 4>{{{"while", Keyword::While},
+                                                    {"if", Keyword::If},
+                                                    {"return", Keyword::Return},
+                                                    {"else", Keyword::Else}}},
+    StrLess{});
+
+constexpr FrozenFlatMap<int, int, 5> squares{
+    std::array<std::pair<int, int>, 5>{
+        {{4, 16}, {2, 4}, {0, 0}, {3, 9}, {1, 1}}}};
+}
+
+TEST_CASE("[FrozenFlatMap] Compile-time lookup", "[FrozenFlatMap]")
+{
+  static_assert(squares.size() == 5, "");
+  static_assert(squares.begin()->first == 0, "");
+  static_assert((squares.end() - 1)->first == 4, "");
+  static_assert(squares.at(3) == 9, "");
+  static_assert(squares.find(5) == squares.end(), "");
+  static_assert(squares.lower_bound(-1) == squares.begin(), "");
+  static_assert(squares.count(2) == 1, "");
+  static_assert(!squares.contains(-1), "");
+
+  static_assert(keywords.at("return") == Keyword::Return, "");
+  static_assert(!keywords.contains("for"), "");
+  static_assert(StrLess{}(keywords.begin()->first, "if"), "");
+  CHECK(std::string{keywords.begin()->first} == "else");
+}
+
+TEST_CASE("[FrozenFlatMap] Runtime lookup", "[FrozenFlatMap]")
+{
+  for (int i = 0; i < 5; ++i)
+    CHECK(squares.at(i) == i * i);
+  CHECK_THROWS_AS(squares.at(5), std::out_of_range);
+
+  std::string const word = "while";
+  CHECK(keywords.find(word.c_str())->second == Keyword::While);
+  CHECK(keywords.find("whilst") == keywords.end());
+}
+
+TEST_CASE("[FrozenFlatMap] Runtime construction", "[FrozenFlatMap]")
+{
+  auto const fm = makeFrozenFlatMap(std::array<std::pair<std::string, int>, 3>{
+      {{"b", 2}, {"c", 3}, {"a", 1}}});
+  CHECK(fm.begin()->first == "a");
+  CHECK(fm.at("c") == 3);
+  CHECK(!fm.contains("d"));
+
+  CHECK_THROWS_AS(makeFrozenFlatMap(std::array<std::pair<int, int>, 3>{
+                      {{1, 1}, {2, 2}, {1, 3}}}),
+                  std::logic_error);
+}
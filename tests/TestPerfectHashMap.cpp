@@ -0,0 +1,115 @@
+#include <catch2/catch.hpp>
+
+#include <cstddef>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <kouh/FlatMap.hpp>
+#include <kouh/PerfectHashMap.hpp>
+
+using kouh::FlatMap;
+using kouh::PerfectHashMap;
+
+namespace
+{
+/// A hash that sends every key to the same value.
+struct ConstantHash
+{
+  std::size_t operator()(int) const noexcept
+  {
+    return 42;
+  }
+};
+}
+
+TEST_CASE("[PerfectHashMap] Empty", "[PerfectHashMap]")
+{
+  auto const phm = kouh::freeze(FlatMap<int, int>{});
+  CHECK(phm.empty());
+  CHECK(phm.size() == 0);
+  CHECK(phm.find(3) == phm.end());
+  CHECK_THROWS_AS(phm.at(3), std::out_of_range);
+}
+
+TEST_CASE("[PerfectHashMap] Freeze", "[PerfectHashMap]")
+{
+  FlatMap<std::string, int> fm = {{"one", 1}, {"two", 2}, {"three", 3}};
+  auto const phm = kouh::freeze(fm);
+  CHECK(phm.size() == 3);
+  CHECK(phm.at("one") == 1);
+  CHECK(phm.at("two") == 2);
+  CHECK(phm.find("three")->second == 3);
+  CHECK(phm.count("four") == 0);
+  CHECK(!phm.contains(""));
+  // The FlatMap is left untouched.
+  CHECK(fm.size() == 3);
+
+  auto const moved = kouh::freeze(std::move(fm));
+  CHECK(moved.size() == 3);
+  CHECK(moved.at("two") == 2);
+  CHECK(fm.empty());
+}
+
+TEST_CASE("[PerfectHashMap] Many keys", "[PerfectHashMap]")
+{
+  std::mt19937 rng{42};
+  std::uniform_int_distribution<int> dist{0, 1 << 30};
+  FlatMap<int, int> fm;
+  for (int i = 0; i < 20000; ++i)
+  {
+    auto const key = dist(rng);
+    fm[key] = key / 2;
+  }
+  auto const phm = kouh::freeze(fm);
+  REQUIRE(phm.size() == fm.size());
+  for (auto const& pair : fm)
+  {
+    auto const it = phm.find(pair.first);
+    REQUIRE(it != phm.end());
+    REQUIRE(it->second == pair.second);
+  }
+  for (int i = 0; i < 20000; ++i)
+  {
+    auto const key = dist(rng);
+    REQUIRE(phm.contains(key) == fm.contains(key));
+  }
+}
+
+TEST_CASE("[PerfectHashMap] Equal hashes", "[PerfectHashMap]")
+{
+  SECTION("All equal")
+  {
+    std::vector<std::pair<int, int>> pairs{{1, 1}, {2, 2}, {3, 3}};
+    PerfectHashMap<int, int, ConstantHash> const phm{pairs.begin(),
+                                                     pairs.end()};
+    CHECK(phm.size() == 3);
+    CHECK(phm.at(1) == 1);
+    CHECK(phm.at(2) == 2);
+    CHECK(phm.at(3) == 3);
+    CHECK(!phm.contains(4));
+  }
+
+  SECTION("Some equal")
+  {
+    // Only keeps 8 bits of the key, like a weak hash would.
+    struct WeakHash
+    {
+      std::size_t operator()(int key) const noexcept
+      {
+        return static_cast<std::size_t>(key) & 0xff;
+      }
+    };
+    std::vector<std::pair<int, int>> pairs;
+    for (int i = 0; i < 5000; ++i)
+      pairs.emplace_back(i, -i);
+    PerfectHashMap<int, int, WeakHash> const phm{pairs.begin(), pairs.end()};
+    REQUIRE(phm.size() == 5000);
+    for (int i = 0; i < 5000; ++i)
+      REQUIRE(phm.at(i) == -i);
+    CHECK(!phm.contains(5000));
+    CHECK(!phm.contains(-1));
+  }
+}
@@ -0,0 +1,168 @@
+#include <catch2/catch.hpp>
+
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <kouh/SmallFlatMap.hpp>
+
+using kouh::SmallFlatMap;
+
+TEST_CASE("[SmallFlatMap] Initialization", "[SmallFlatMap]")
+{
+  SmallFlatMap<int, std::string, 4> fm = {{3, "c"}, {1, "a"}, {3, "x"}};
+  CHECK(fm.size() == 2);
+  CHECK(fm.isInline());
+  CHECK(fm.at(1) == "a");
+  CHECK(fm.at(3) == "c");
+  CHECK_THROWS_AS(fm.at(2), std::out_of_range);
+}
+
+TEST_CASE("[SmallFlatMap] Spill", "[SmallFlatMap]")
+{
+  SmallFlatMap<int, int, 4> fm;
+  for (int i = 0; i < 4; ++i)
+    fm.emplace(3 - i, i);
+  CHECK(fm.isInline());
+  fm[10] = 10;
+  CHECK(!fm.isInline());
+  CHECK(fm.size() == 5);
+  CHECK(fm.begin()->first == 0);
+  CHECK(fm.find(10)->second == 10);
+
+  auto copy = fm;
+  auto moved = std::move(fm);
+  CHECK(copy.size() == 5);
+  CHECK(moved.size() == 5);
+  CHECK(moved.contains(2));
+  CHECK(fm.empty());
+}
+
+TEST_CASE("[SmallFlatMap] Geometric growth", "[SmallFlatMap]")
+{
+  // Every allocation moves the elements to a new buffer, so count the moves.
+  SmallFlatMap<int, int, 8> fm;
+  auto allocations = 0;
+  auto data = &*fm.begin();
+  for (int i = 1000; i > 0; --i)
+  {
+    fm.emplace(i, i);
+    if (&*fm.begin() != data)
+      ++allocations;
+    data = &*fm.begin();
+  }
+  CHECK(fm.size() == 1000);
+  CHECK(allocations == 7);
+  CHECK(fm.begin()->first == 1);
+}
+
+TEST_CASE("[SmallFlatMap] Lookup and erasure", "[SmallFlatMap]")
+{
+  SmallFlatMap<int, int, 8> fm;
+  for (int i = 0; i < 6; ++i)
+    fm.try_emplace(i * 2, i);
+  CHECK(!fm.try_emplace(4, 42).second);
+  CHECK(fm.at(4) == 2);
+  CHECK(!fm.insert_or_assign(4, 42).second);
+  CHECK(fm.at(4) == 42);
+
+  CHECK(fm.lower_bound(3)->first == 4);
+  CHECK(fm.upper_bound(4)->first == 6);
+  CHECK(fm.equal_range(5).first == fm.equal_range(5).second);
+  CHECK(fm.count(6) == 1);
+  CHECK(fm.count(7) == 0);
+
+  CHECK(fm.erase(6)->first == 8);
+  CHECK(fm.erase(7) == fm.end());
+  CHECK(fm.emplace_hint(fm.find(8), 7, 7)->first == 7);
+  CHECK(erase_if(fm, [](std::pair<int, int> const& p) {
+          return p.first % 2 != 0;
+        }) == 1);
+  CHECK(fm.size() == 5);
+  fm.erase(fm.begin(), fm.find(8));
+  CHECK(fm.size() == 2);
+}
+
+TEST_CASE("[SmallFlatMap] Bulk construction and insertion", "[SmallFlatMap]")
+{
+  std::vector<std::pair<int, int>> v{{5, 0}, {1, 1}, {5, 2}, {3, 3}};
+
+  SECTION("Range")
+  {
+    SmallFlatMap<int, int, 4> fm{v.begin(), v.end()};
+    CHECK(fm.size() == 3);
+    CHECK(fm.isInline());
+    CHECK(fm.at(5) == 0);
+
+    SmallFlatMap<int, int, 4> last{
+        v.begin(), v.end(), kouh::DuplicatePolicy::KeepLast};
+    CHECK(last.at(5) == 2);
+
+    std::vector<std::pair<int, int>> more{{0, 4}, {3, 5}, {9, 6}};
+    fm.insert(more.begin(), more.end());
+    CHECK(!fm.isInline());
+    CHECK(std::vector<std::pair<int, int>>(fm.begin(), fm.end()) ==
+          (std::vector<std::pair<int, int>>{
+              {0, 4}, {1, 1}, {3, 3}, {5, 0}, {9, 6}}));
+  }
+
+  SECTION("Adoption, extract and replace")
+  {
+    using Map = SmallFlatMap<int, int, 4>;
+    Map fm{Map::ContainerType(v.begin(), v.end())};
+    CHECK(fm.size() == 3);
+
+    auto c = fm.extract();
+    CHECK(fm.empty());
+    CHECK(c.size() == 3);
+    c.emplace_back(8, 8);
+    fm.replace(std::move(c));
+    CHECK(fm.at(8) == 8);
+
+    Map sorted{kouh::sorted_unique, fm.extract()};
+    CHECK(sorted.size() == 4);
+    CHECK(sorted.begin()->first == 1);
+  }
+}
+
+TEST_CASE("[SmallFlatMap] Heterogeneous lookup", "[SmallFlatMap]")
+{
+  SmallFlatMap<std::string, int, 2, std::less<>> fm{
+      {"abc", 1}, {"abd", 2}, {"b", 3}};
+  CHECK(fm.contains("abd"));
+  CHECK(!fm.contains("abe"));
+  CHECK(fm.find("b")->second == 3);
+  CHECK(fm.count("abc") == 1);
+  CHECK(fm.at("abc") == 1);
+  CHECK_THROWS_AS(fm.at("c"), std::out_of_range);
+  CHECK(fm.lower_bound("abcd")->first == "abd");
+  CHECK(fm.upper_bound("abd")->first == "b");
+  CHECK(fm.equal_range("b").first == fm.find("b"));
+}
+
+TEST_CASE("[SmallFlatMap] Against std::map", "[SmallFlatMap]")
+{
+  std::mt19937 rng{42};
+  std::uniform_int_distribution<int> dist{0, 63};
+  SmallFlatMap<int, int, 16> fm;
+  std::map<int, int> m;
+
+  for (int i = 0; i < 1000; ++i)
+  {
+    auto const key = dist(rng);
+    if (i % 3 == 0)
+    {
+      fm.erase(key);
+      m.erase(key);
+    }
+    else
+    {
+      fm[key] = i;
+      m[key] = i;
+    }
+    REQUIRE(fm.size() == m.size());
+  }
+  CHECK(std::vector<std::pair<int, int>>(fm.begin(), fm.end()) ==
+        std::vector<std::pair<int, int>>(m.begin(), m.end()));
+}
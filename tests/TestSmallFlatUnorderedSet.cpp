@@ -0,0 +1,45 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <kouh/SmallFlatUnorderedSet.hpp>
+
+using kouh::SmallFlatUnorderedSet;
+
+TEST_CASE("[SmallFlatUnorderedSet] Insertion", "[SmallFlatUnorderedSet]")
+{
+  SmallFlatUnorderedSet<std::string, 2> fs{};
+  CHECK(fs.empty());
+  CHECK(fs.emplace("a").second);
+  CHECK(fs.emplace("b").second);
+  CHECK(!fs.emplace("a").second);
+  CHECK(fs.size() == 2);
+  CHECK(fs.isInline());
+
+  CHECK(fs.emplace("c").second);
+  CHECK(!fs.isInline());
+  CHECK(fs.contains("c"));
+  CHECK(fs.count("d") == 0);
+}
+
+TEST_CASE("[SmallFlatUnorderedSet] Erasure", "[SmallFlatUnorderedSet]")
+{
+  SmallFlatUnorderedSet<int, 4> fs{1, 2, 3, 4};
+  CHECK(fs.erase(2) == 1);
+  CHECK(fs.erase(2) == 0);
+  CHECK(fs.size() == 3);
+  CHECK(!fs.contains(2));
+
+  CHECK(erase_if(fs, [](int i) { return i > 3; }) == 1);
+  std::vector<int> values(fs.begin(), fs.end());
+  std::sort(values.begin(), values.end());
+  CHECK(values == (std::vector<int>{1, 3}));
+
+  auto moved = std::move(fs);
+  CHECK(moved.size() == 2);
+  CHECK(fs.empty());
+  moved.clear();
+  CHECK(moved.empty());
+}
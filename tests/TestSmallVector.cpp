@@ -0,0 +1,131 @@
+#include <catch2/catch.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <kouh/SmallVector.hpp>
+
+using kouh::SmallVector;
+
+TEST_CASE("[SmallVector] Inline storage", "[SmallVector]")
+{
+  SmallVector<int, 4> v{};
+  CHECK(v.empty());
+  CHECK(v.isInline());
+  CHECK(v.capacity() == 4);
+
+  for (int i = 0; i < 4; ++i)
+    v.push_back(i);
+  CHECK(v.isInline());
+  CHECK(std::vector<int>(v.begin(), v.end()) == (std::vector<int>{0, 1, 2, 3}));
+
+  SECTION("Spill")
+  {
+    v.push_back(4);
+    CHECK(!v.isInline());
+    CHECK(v.capacity() >= 5);
+    CHECK(std::vector<int>(v.begin(), v.end()) ==
+          (std::vector<int>{0, 1, 2, 3, 4}));
+  }
+
+  SECTION("Self reference on spill")
+  {
+    v.push_back(v[1]);
+    CHECK(v.back() == 1);
+    v.emplace(v.begin(), v.back());
+    CHECK(std::vector<int>(v.begin(), v.end()) ==
+          (std::vector<int>{1, 0, 1, 2, 3, 1}));
+  }
+}
+
+TEST_CASE("[SmallVector] Modifiers", "[SmallVector]")
+{
+  SmallVector<std::string, 2> v{"b", "d"};
+
+  v.insert(v.begin(), "a");
+  v.insert(v.begin() + 2, "c");
+  v.insert(v.end(), "e");
+  CHECK(std::vector<std::string>(v.begin(), v.end()) ==
+        (std::vector<std::string>{"a", "b", "c", "d", "e"}));
+
+  std::vector<std::string> more{"x", "y"};
+  auto const it = v.insert(v.begin() + 1, more.begin(), more.end());
+  CHECK(*it == "x");
+  CHECK(std::vector<std::string>(v.begin(), v.end()) ==
+        (std::vector<std::string>{"a", "x", "y", "b", "c", "d", "e"}));
+
+  CHECK(*v.erase(v.begin() + 1, v.begin() + 3) == "b");
+  CHECK(*v.erase(v.begin()) == "b");
+  v.pop_back();
+  CHECK(std::vector<std::string>(v.begin(), v.end()) ==
+        (std::vector<std::string>{"b", "c", "d"}));
+
+  v.clear();
+  CHECK(v.empty());
+  CHECK(!v.isInline());
+}
+
+TEST_CASE("[SmallVector] Geometric growth on middle inserts",
+          "[SmallVector]")
+{
+  SmallVector<int, 4> v{};
+  auto allocations = 0;
+  auto capacity = v.capacity();
+  for (int i = 0; i < 1000; ++i)
+  {
+    v.insert(v.begin(), i);
+    if (v.capacity() != capacity)
+      ++allocations;
+    capacity = v.capacity();
+  }
+  CHECK(v.size() == 1000);
+  CHECK(allocations == 8);
+  CHECK(v.front() == 999);
+  CHECK(v.back() == 0);
+}
+
+TEST_CASE("[SmallVector] Copy and move", "[SmallVector]")
+{
+  SECTION("Inline")
+  {
+    SmallVector<std::string, 4> v{"a", "b"};
+    SmallVector<std::string, 4> copy{v};
+    CHECK(copy.isInline());
+    CHECK(std::vector<std::string>(copy.begin(), copy.end()) ==
+          (std::vector<std::string>{"a", "b"}));
+
+    SmallVector<std::string, 4> moved{std::move(v)};
+    CHECK(moved.isInline());
+    CHECK(moved.size() == 2);
+    CHECK(moved[1] == "b");
+    CHECK(v.empty());
+  }
+
+  SECTION("Heap")
+  {
+    SmallVector<std::string, 1> v{"a", "b", "c"};
+    auto const data = v.data();
+    SmallVector<std::string, 1> copy;
+    copy = v;
+    CHECK(!copy.isInline());
+    CHECK(copy.size() == 3);
+
+    SmallVector<std::string, 1> moved;
+    moved = std::move(v);
+    CHECK(moved.data() == data);
+    CHECK(v.empty());
+    CHECK(v.isInline());
+    CHECK(moved[2] == "c");
+  }
+
+  SECTION("Move-only values")
+  {
+    SmallVector<std::unique_ptr<int>, 2> v;
+    for (int i = 0; i < 5; ++i)
+      v.emplace_back(new int(i));
+    SmallVector<std::unique_ptr<int>, 2> moved{std::move(v)};
+    CHECK(moved.size() == 5);
+    CHECK(*moved[4] == 4);
+  }
+}
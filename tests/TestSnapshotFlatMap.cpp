@@ -0,0 +1,170 @@
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <kouh/SnapshotFlatMap.hpp>
+
+using kouh::SnapshotFlatMap;
+
+TEST_CASE("[SnapshotFlatMap] Snapshots", "[SnapshotFlatMap]")
+{
+  SnapshotFlatMap<int, int> sfm{{{1, 10}, {2, 20}}};
+  auto const first = sfm.snapshot();
+  REQUIRE(first);
+  REQUIRE(first.number() == 0);
+  REQUIRE(first->size() == 2);
+  REQUIRE(first->at(1) == 10);
+
+  auto const number = sfm.update([](auto& map) {
+    map[1] = 11;
+    map.erase(2);
+    map[3] = 30;
+  });
+  REQUIRE(number == 1);
+
+  // The first snapshot still sees the first version.
+  REQUIRE(first->size() == 2);
+  REQUIRE(first->at(1) == 10);
+  REQUIRE(first->at(2) == 20);
+
+  auto const second = sfm.snapshot();
+  REQUIRE(second.number() == 1);
+  REQUIRE(second->size() == 2);
+  REQUIRE(second->at(1) == 11);
+  REQUIRE(second->count(2) == 0);
+  REQUIRE((*second).at(3) == 30);
+
+  REQUIRE(sfm.publish({{4, 40}}) == 2);
+  REQUIRE(sfm.snapshot()->size() == 1);
+  REQUIRE(sfm.snapshot()->at(4) == 40);
+
+  SnapshotFlatMap<int, int>::Snapshot empty;
+  REQUIRE(!empty);
+  empty = sfm.snapshot();
+  REQUIRE(empty.number() == 2);
+}
+
+TEST_CASE("[SnapshotFlatMap] Failed update", "[SnapshotFlatMap]")
+{
+  SnapshotFlatMap<int, int> sfm{{{1, 10}}};
+  REQUIRE_THROWS_AS(sfm.update([](auto& map) {
+    map[2] = 20;
+    throw std::runtime_error("update");
+  }),
+                    std::runtime_error);
+  auto const snapshot = sfm.snapshot();
+  REQUIRE(snapshot.number() == 0);
+  REQUIRE(snapshot->size() == 1);
+  REQUIRE(sfm.update([](auto& map) { map[2] = 20; }) == 1);
+}
+
+TEST_CASE("[SnapshotFlatMap] Reclamation", "[SnapshotFlatMap]")
+{
+  // Each version holds a copy of value: its use count tells how many
+  // versions are alive.
+  auto const value = std::make_shared<int>(0);
+  SnapshotFlatMap<int, std::shared_ptr<int>> sfm{{{0, value}}};
+  REQUIRE(value.use_count() == 2);
+
+  // Unpinned versions are freed by the update that replaces them.
+  sfm.update([](auto& map) { map[1] = nullptr; });
+  REQUIRE(value.use_count() == 2);
+
+  {
+    auto const pinned = sfm.snapshot();
+    sfm.update([](auto& map) { map[2] = nullptr; });
+    sfm.update([](auto& map) { map[3] = nullptr; });
+    REQUIRE(value.use_count() == 3);
+    REQUIRE(sfm.reclaim() == 1);
+    REQUIRE(pinned->size() == 2);
+  }
+  REQUIRE(value.use_count() == 3);
+  REQUIRE(sfm.reclaim() == 0);
+  REQUIRE(value.use_count() == 2);
+
+  // Moving a snapshot hands its pin over.
+  auto moved = sfm.snapshot();
+  sfm.update([](auto& map) { map.erase(3); });
+  auto const pinned = std::move(moved);
+  REQUIRE(!moved);
+  REQUIRE(sfm.reclaim() == 1);
+  REQUIRE(pinned->size() == 4);
+}
+
+TEST_CASE("[SnapshotFlatMap] Reader", "[SnapshotFlatMap]")
+{
+  auto const value = std::make_shared<int>(0);
+  SnapshotFlatMap<int, std::shared_ptr<int>> sfm{{{0, value}}};
+  SnapshotFlatMap<int, std::shared_ptr<int>>::Reader reader{sfm};
+  REQUIRE(reader.get().number() == 0);
+  REQUIRE(&reader.get() == &reader.get());
+
+  sfm.update([](auto& map) { map[1] = nullptr; });
+  REQUIRE(value.use_count() == 3);
+  REQUIRE(sfm.reclaim() == 1);
+
+  // The next get() moves to the new version and releases the old one.
+  REQUIRE(reader.get().number() == 1);
+  REQUIRE(reader.get()->size() == 2);
+  REQUIRE(sfm.reclaim() == 0);
+  REQUIRE(value.use_count() == 2);
+}
+
+TEST_CASE("[SnapshotFlatMap] Concurrent readers", "[SnapshotFlatMap]")
+{
+  // Version n maps every key in [0, 64) to n. Readers check they never see
+  // a mix of versions, or versions going back.
+  constexpr int KEYS = 64;
+  constexpr std::uint64_t UPDATES = 200;
+  SnapshotFlatMap<int, std::uint64_t> sfm;
+  sfm.update([](auto& map) {
+    for (int key = 0; key < KEYS; ++key)
+      map[key] = 1;
+  });
+
+  std::atomic<bool> done{false};
+  std::atomic<int> errors{0};
+  auto const check = [&](auto const& snapshot, std::uint64_t& last) {
+    auto const number = snapshot.number();
+    if (number < last || snapshot->size() != KEYS)
+      ++errors;
+    for (auto const& pair : *snapshot)
+      if (pair.second != number)
+        ++errors;
+    last = number;
+  };
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; ++i)
+    readers.emplace_back([&, i]() {
+      std::uint64_t last = 0;
+      if (i % 2 == 0)
+        while (!done.load())
+          check(sfm.snapshot(), last);
+      else
+      {
+        SnapshotFlatMap<int, std::uint64_t>::Reader reader{sfm};
+        while (!done.load())
+          check(reader.get(), last);
+      }
+    });
+
+  for (std::uint64_t n = 2; n <= UPDATES; ++n)
+  {
+    sfm.update([n](auto& map) {
+      for (auto& pair : map)
+        pair.second = n;
+    });
+    std::this_thread::yield();
+  }
+  done = true;
+  for (auto& reader : readers)
+    reader.join();
+  REQUIRE(errors.load() == 0);
+  REQUIRE(sfm.reclaim() == 0);
+  REQUIRE(sfm.snapshot().number() == UPDATES);
+}
@@ -0,0 +1,205 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <type_traits>
+
+#include <kouh/SplitFlatMap.hpp>
+
+template <typename Key, typename Value>
+using SplitFlatMap = kouh::SplitFlatMap<Key, Value>;
+
+namespace
+{
+struct NoCopy
+{
+  NoCopy() : a(0)
+  {
+  }
+  NoCopy(int b) : a(b)
+  {
+  }
+  NoCopy(NoCopy const&) = delete;
+  NoCopy& operator=(NoCopy const&) = delete;
+  NoCopy(NoCopy&&) = default;
+  NoCopy& operator=(NoCopy&&) = default;
+
+  // For convenience
+  inline bool operator==(int b) const noexcept
+  {
+    return this->a == b;
+  }
+
+  int a;
+};
+}
+
+TEST_CASE("[SplitFlatMap] Initialization", "[SplitFlatMap]")
+{
+  SECTION("Empty")
+  {
+    SplitFlatMap<int, int> sfm{};
+    CHECK(sfm.size() == 0);
+    CHECK(sfm.empty());
+    CHECK(sfm.begin() == sfm.end());
+  }
+
+  SECTION("Init list is sorted and deduplicated")
+  {
+    SplitFlatMap<int, std::string> sfm = {
+        {4, "four"}, {2, "two"}, {3, "three"}, {2, "deux"}};
+    REQUIRE(sfm.size() == 3);
+    CHECK(std::is_sorted(sfm.keys().begin(), sfm.keys().end()));
+    CHECK(sfm.values().front() == "two");
+  }
+}
+
+TEST_CASE("[SplitFlatMap] Lookup", "[SplitFlatMap]")
+{
+  SplitFlatMap<std::string, int> sfm = {
+      {"4", 4}, {"8", 8}, {"42", 42}, {"1337", 1337}, {"4269", 4269}};
+
+  SECTION("find")
+  {
+    auto it = sfm.find("42");
+    REQUIRE(it != sfm.end());
+    CHECK(it->first == "42");
+    CHECK(it->second == 42);
+    CHECK(sfm.find("foo") == sfm.end());
+  }
+
+  SECTION("find on const SplitFlatMap")
+  {
+    auto const& csfm = sfm;
+    auto it = csfm.find("8");
+    REQUIRE(it != csfm.end());
+    CHECK((*it).second == 8);
+    CHECK(csfm.find("foo") == csfm.cend());
+  }
+
+  SECTION("at")
+  {
+    CHECK(sfm.at("4269") == 4269);
+    sfm.at("4") = 2;
+    CHECK(sfm.at("4") == 2);
+    CHECK_THROWS_AS(sfm.at("foo"), std::out_of_range);
+  }
+
+  SECTION("operator[]")
+  {
+    CHECK(sfm["1337"] == 1337);
+    sfm["1"] = 1;
+    CHECK(sfm.size() == 6);
+    CHECK(sfm["1"] == 1);
+    CHECK(sfm.keys().front() == "1");
+  }
+
+  SECTION("Iteration is ordered")
+  {
+    std::string previous;
+    for (auto const& pair : sfm)
+    {
+      CHECK(previous < pair.first);
+      previous = pair.first;
+    }
+  }
+
+  SECTION("Proxy iterators")
+  {
+    using Iterator = SplitFlatMap<std::string, int>::iterator;
+    // References are proxies, so only the input iterator category holds.
+    CHECK((std::is_same<std::iterator_traits<Iterator>::iterator_category,
+                        std::input_iterator_tag>::value));
+    CHECK(sfm.end() - sfm.begin() == 5);
+    CHECK((sfm.begin() + 2)->first == sfm.begin()[2].first);
+    CHECK(std::distance(sfm.begin(), sfm.end()) == 5);
+  }
+
+  SECTION("Values are writable through iterators")
+  {
+    for (auto it = sfm.begin(); it != sfm.end(); ++it)
+      it->second = 0;
+    CHECK(std::count(sfm.values().begin(), sfm.values().end(), 0) == 5);
+  }
+}
+
+TEST_CASE("[SplitFlatMap] Modifiers", "[SplitFlatMap]")
+{
+  SplitFlatMap<int, NoCopy> sfm;
+  sfm.emplace(4, 4);
+  sfm.emplace(8, 8);
+  sfm.emplace(1, 1);
+  REQUIRE(sfm.size() == 3);
+
+  SECTION("emplace existing key")
+  {
+    auto const ret = sfm.emplace(4, 5);
+    CHECK(!ret.second);
+    CHECK(ret.first == sfm.find(4));
+    CHECK(sfm.at(4) == 4);
+  }
+
+  SECTION("erase by key")
+  {
+    sfm.erase(4);
+    CHECK(sfm.size() == 2);
+    CHECK(sfm.find(4) == sfm.end());
+    sfm.erase(31);
+    CHECK(sfm.size() == 2);
+  }
+
+  SECTION("erase by iterator")
+  {
+    auto const it = sfm.erase(sfm.begin());
+    CHECK(it == sfm.begin());
+    CHECK(it->first == 4);
+    CHECK(sfm.size() == 2);
+  }
+
+  SECTION("clear")
+  {
+    sfm.clear();
+    CHECK(sfm.empty());
+  }
+}
+
+TEST_CASE("[SplitFlatMap] Arithmetic keys lookup", "[SplitFlatMap]")
+{
+  // Contiguous keys go through the SIMD search. Use enough keys to go through
+  // the binary search, and unsigned keys above the signed range.
+  for (std::uint32_t n : {1u, 7u, 16u, 17u, 40u, 1000u})
+  {
+    SplitFlatMap<std::uint32_t, std::uint32_t> sfm;
+    SplitFlatMap<std::uint64_t, std::uint32_t> sfm64;
+    SplitFlatMap<double, std::uint32_t> sfmd;
+    for (std::uint32_t i = 0; i < n; ++i)
+    {
+      sfm.emplace(0x7ffffff0u + 2 * i, i);
+      sfm64.emplace(0x7ffffffffffffff0u + 2 * i, i);
+      sfmd.emplace(-10.0 + 2 * i, i);
+    }
+    for (std::uint32_t i = 0; i < 2 * n + 2; ++i)
+    {
+      auto const it = sfm.find(0x7ffffff0u + i);
+      auto const it64 = sfm64.find(0x7ffffffffffffff0u + i);
+      auto const itd = sfmd.find(-10.0 + i);
+      if (i % 2 == 0 && i < 2 * n)
+      {
+        REQUIRE(it != sfm.end());
+        REQUIRE(it->second == i / 2);
+        REQUIRE(it64 != sfm64.end());
+        REQUIRE(it64->second == i / 2);
+        REQUIRE(itd != sfmd.end());
+        REQUIRE(itd->second == i / 2);
+      }
+      else
+      {
+        REQUIRE(it == sfm.end());
+        REQUIRE(it64 == sfm64.end());
+        REQUIRE(itd == sfmd.end());
+      }
+    }
+  }
+}